@@ -3,7 +3,13 @@
 // A uniform variable whose value doesn't change for all runs in 1 draw in the shader
 // In other words, in 1 draw, all vertices running this main function in parallel, they'll all see the same uniform value.
 // This variable is sent from the main.cpp to the shader
-uniform float time;
+// Here it is read from the Frame block, which is sent once per frame in a uniform buffer (see source/uniform_buffers.hpp)
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    float time;
+};
 
 // Need to send the color as output
 // Note we didn't need to do so for the positions, since we passed them to the reasterizer using the built in gl_Position
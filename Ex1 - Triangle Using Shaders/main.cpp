@@ -1,8 +1,17 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
+#include "source/program_cache.hpp"
+#include "source/headless.hpp"
+#include "source/frame_stats.hpp"
+#include "source/profiler.hpp"
+#include "source/uniform_buffers.hpp"
+#include "source/frame_scheduler.hpp"
 
 // A function for the 2 shaders instead of writing the code inside twice
 // All objects in opengl are unsigned int, this unsignedint represents an ID
@@ -30,10 +39,61 @@ GLuint loadShader(const std::string& filePath, GLenum shaderType) {
     glShaderSource(shader, 1, &sourceCStr, nullptr);
     glCompileShader(shader);
 
+    // Check if the shader compiled successfully, otherwise print the errors the compiler found
+    // Without this check, a mistake in the shader code fails silently and nothing is drawn
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if(!compiled){
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Failed to compile " << filePath << ":\n" << log << std::endl;
+    }
+
     return shader;
 }
 
-int main(int, char**) {
+// Reads the value of a command line option as a whole number between "low" and "high"
+// Returns false (and leaves "value" unchanged) for anything else, like "abc", "12abc", "-5" or a number too big for an int
+bool parseIntArgument(const char* text, int low, int high, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long number = std::strtol(text, &end, 10);
+    if(end == text || *end != '\0' || errno == ERANGE || number < low || number > high) return false;
+    value = (int)number;
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    // Command line options:
+    // --headless : draw into an offscreen framebuffer instead of a visible window (see source/headless.hpp)
+    // --frames N : close after drawing N frames and print the frame time statistics
+    // --profile : measure the CPU and GPU time of every part of the frame and save them to trace.json on exit
+    // --swap MODE : wait for the vertical blank before showing a frame (vsync) or show it immediately (uncapped, the default)
+    // --frames-in-flight N : let the CPU prepare at most N frames ahead of the GPU (2 by default, 0 for no limit, see source/frame_scheduler.hpp)
+    bool headless = false;
+    int frameLimit = 0;
+    bool profile = false;
+    FrameScheduler::SwapMode swapMode = FrameScheduler::SwapMode::Uncapped;
+    int framesInFlight = 2;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--headless"){
+            headless = true;
+        } else if(arg == "--frames" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, frameLimit)){
+            i++;
+        } else if(arg == "--profile"){
+            profile = true;
+        } else if(arg == "--swap" && i + 1 < argc && FrameScheduler::parseSwapMode(argv[i + 1], swapMode)){
+            i++;
+        } else if(arg == "--frames-in-flight" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, framesInFlight)){
+            i++;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+        }
+    }
+    // A headless run has no close button, so it must stop after a fixed number of frames
+    if(headless && frameLimit == 0) frameLimit = 1000;
     
     if(!glfwInit()){
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -42,6 +102,8 @@ int main(int, char**) {
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // In headless mode we still need a window to own the OpenGL context, but it is never shown
+    if(headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     GLFWwindow* window = glfwCreateWindow(500, 500, "Example 1", nullptr, nullptr);
     if(!window){
@@ -59,13 +121,30 @@ int main(int, char**) {
     // Think of the program as the pipeline
     // Note that the program don't have some info related to the rasterizer, its not the pipeline exactly, but part of it.
     GLuint program = glCreateProgram();
-    GLuint vs = loadShader("assets/shaders/simple.vert", GL_VERTEX_SHADER);
-    glAttachShader(program, vs);
-    glDeleteShader(vs);
-    GLuint fs = loadShader("assets/shaders/simple.frag", GL_FRAGMENT_SHADER);
-    glAttachShader(program, fs);
-    glDeleteShader(fs);
-    glLinkProgram(program);
+    // If this program was linked in a previous run, load its binary from the cache instead of compiling the shaders again
+    // The key changes whenever the shaders' code or the graphics driver change
+    std::string programCacheKey = getProgramCacheKey({"assets/shaders/simple.vert", "assets/shaders/simple.frag"});
+    if(!loadProgramBinary(program, programCacheKey)){
+        GLuint vs = loadShader("assets/shaders/simple.vert", GL_VERTEX_SHADER);
+        glAttachShader(program, vs);
+        glDeleteShader(vs);
+        GLuint fs = loadShader("assets/shaders/simple.frag", GL_FRAGMENT_SHADER);
+        glAttachShader(program, fs);
+        glDeleteShader(fs);
+        glLinkProgram(program);
+
+        // Same as the shaders, check if the program linked successfully
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(!linked){
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "Failed to link the program:\n" << log << std::endl;
+        }
+
+        // Save the linked program so that the next run can skip compiling it
+        saveProgramBinary(program, programCacheKey);
+    }
 
     // To draw in opengl, need to define a vertex array
     // In Ex2 will use the VAO to send data to the vertix shader
@@ -74,25 +153,75 @@ int main(int, char**) {
     // Firstparam: 1 means creating one vertix array
     glGenVertexArrays(1, &VAO);
 
-    // Give it the name of the variable 'time'
-    // Returns the location (ptr) of that variable
-    GLint timeLoc = glGetUniformLocation(program, "time");
+    // The time is sent in the Frame block of a uniform buffer instead of a uniform of the program (see source/uniform_buffers.hpp)
+    // The Frame block of the program is attached to the binding point that the buffer is bound to every frame
+    bindUniformBlocks(program);
+    UniformBuffer uniformBuffer;
+    uniformBuffer.create(uniformBuffer.getAlignedSize(sizeof(FrameUniforms)));
+    // There is no camera in this example, so the matrices stay the identity
+    FrameUniforms frameUniforms;
+    setIdentityMatrix(frameUniforms.view);
+    setIdentityMatrix(frameUniforms.projection);
+    setIdentityMatrix(frameUniforms.viewProjection);
+
+    // In headless mode, everything is drawn into this framebuffer instead of the window
+    OffscreenFramebuffer offscreen;
+    if(headless) offscreen = createOffscreenFramebuffer(500, 500);
+
+    FrameStats frameStats;
+    double lastFrameTime = glfwGetTime();
+
+    // Measures how long each part of the frame takes (see source/profiler.hpp)
+    Profiler profiler;
+    if(profile) profiler.enable();
+
+    // The animation advances in fixed steps of 1/60 s, and the frame draws the time between the last 2 steps (see source/frame_scheduler.hpp)
+    FrameScheduler scheduler;
+    scheduler.start(swapMode, framesInFlight);
+    double previousTime = 0, simulationTime = 0;
 
-    // While the close button is not pressed
-    while(!glfwWindowShouldClose(window)){
+    // While the close button is not pressed (and the frame limit is not reached)
+    while(!glfwWindowShouldClose(window) && (frameLimit == 0 || (int)frameStats.getFrameCount() < frameLimit)){
+        profiler.beginFrame();
+
+        // Waits for the GPU if too many frames are in flight, then reads the input, so the frame is made from the newest input
+        profiler.beginScope("wait for GPU");
+        scheduler.waitForFrameSlot();
+        profiler.endScope();
+
+        profiler.beginScope("poll events");
+        glfwPollEvents();
+        profiler.endScope();
+
+        // The fixed steps of the simulation, here it is only the time
+        int steps = scheduler.advance();
+        for(int step = 0; step < steps; step++){
+            previousTime = simulationTime;
+            simulationTime += scheduler.getStepTime();
+        }
+
+        profiler.beginScope("clear");
         glClearColor(0.2, 0.4, 0.6, 1.0);
         glClear(GL_COLOR_BUFFER_BIT);
+        profiler.endScope();
 
+        profiler.beginScope("uniforms");
         // Need to bind the VAO before drawing
         glBindVertexArray(VAO);
         // Specify which program to use when draw
         glUseProgram(program);
 
-        // Send to the variable time the value glfwGetTime (i.e current time)
-        // Note: the link stage of the program enabled us to send to the time variable defined in any object attached to the program
-        // i.e this value will be sent to the 'time' variables in both the frag and the vertix shader.
-        // 1f means we're going to send 1 float
-        glUniform1f(timeLoc, (float)glfwGetTime());
+        // Send to the variable time the simulated time (see source/frame_scheduler.hpp)
+        // The block is written then sent to the buffer, and glBindBufferRange points the binding point of the Frame block at it
+        // Note: the link stage of the program enabled us to use the same block in any object attached to the program
+        // i.e this value will be seen by the 'time' variables in both the frag and the vertix shader.
+        // It is the time between the last 2 steps, at the fraction of a step left in the scheduler
+        frameUniforms.time = (float)(previousTime + (simulationTime - previousTime) * scheduler.getAlpha());
+        uniformBuffer.beginFrame();
+        size_t frameOffset = uniformBuffer.write(&frameUniforms, sizeof(FrameUniforms));
+        uniformBuffer.upload();
+        uniformBuffer.bindRange(FRAME_UNIFORMS_BINDING, frameOffset, sizeof(FrameUniforms));
+        profiler.endScope();
 
         // First param: either traingle/line/point
         // Second param, is to specify how many indeces to skip from the start of the array
@@ -100,12 +229,41 @@ int main(int, char**) {
         // Third param: if 3 draw a traingle, if 9 draw 3 traingles, if 5 draw 1 traingle and skip the 2 vertices left.
         // This takes each 3 successive vertices and draw a traingle using them.
 
+        profiler.beginScope("draw");
         glDrawArrays(GL_TRIANGLES, 0, 3);
+        profiler.endScope();
 
         // Every thing drawn on the back buffer will be swapped (visible) to the curr window
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // In headless mode nothing is shown, so instead we wait for the GPU to finish drawing the frame
+        // (otherwise we would only measure how fast the commands are sent, not how fast they are drawn)
+        profiler.beginScope("swap");
+        if(headless) glFinish();
+        else glfwSwapBuffers(window);
+        profiler.endScope();
+
+        scheduler.endFrame();
+
+        profiler.endFrame();
+
+        double now = glfwGetTime();
+        // The frame times are only printed when there is a frame limit (--frames or --headless)
+        // Without one the window can stay open for hours, so they aren't kept at all
+        if(frameLimit > 0) frameStats.addFrame(1000.0 * (now - lastFrameTime));
+        lastFrameTime = now;
+    }
+
+    if(frameLimit > 0){
+        frameStats.print("Example 1");
+        scheduler.printStats("Frame scheduler");
+    }
+    scheduler.destroy();
+    if(profile){
+        profiler.printSummary();
+        profiler.exportChromeTrace("trace.json");
     }
+    profiler.destroy();
+    if(headless) destroyOffscreenFramebuffer(offscreen);
+    uniformBuffer.destroy();
 
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Collects the duration of every frame, then prints a summary of them
+// The average alone hides stutters, so the percentiles and the slowest frame are printed too
+// Every frame is kept (the percentiles need all of them), so only add frames to a run that stops, like --frames N
+class FrameStats {
+public:
+    // Adds the duration of 1 frame (in milliseconds)
+    void addFrame(double milliseconds) { frameTimes.push_back(milliseconds); }
+
+    size_t getFrameCount() const { return frameTimes.size(); }
+
+    // Prints the number of frames, the average, minimum, median, 95th and 99th percentiles and maximum frame time
+    void print(const std::string& label) const;
+
+private:
+    std::vector<double> frameTimes;
+};
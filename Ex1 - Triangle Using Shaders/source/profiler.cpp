@@ -0,0 +1,214 @@
+#include "profiler.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <algorithm>
+
+Profiler::Profiler(size_t frameHistory) {
+    // The GPU results of a frame arrive GPU_LATENCY frames late, so that frame must still be in the ring buffer
+    frames.resize(std::max(frameHistory, (size_t)GPU_LATENCY + 1));
+    epoch = std::chrono::steady_clock::now();
+}
+
+void Profiler::enable() {
+    enabled = true;
+
+    // Some drivers have no timer, then only the CPU is measured
+    GLint timestampBits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &timestampBits);
+    gpuTiming = timestampBits > 0;
+    if(!gpuTiming){
+        std::cerr << "The driver doesn't support timer queries, only the CPU will be profiled" << std::endl;
+        return;
+    }
+
+    for(GpuFrame& gpuFrame : gpuFrames) glGenQueries(1, &gpuFrame.frameQuery);
+
+    // Read the GPU clock now, and compare it to the CPU clock
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    gpuClockOffset = now() - gpuTime / 1000.0;
+}
+
+double Profiler::now() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::beginFrame() {
+    if(!enabled) return;
+    inFrame = true;
+    frameIndex++;
+
+    FrameRecord& frame = getFrame(frameIndex);
+    frame.index = frameIndex;
+    frame.start = now();
+    frame.duration = 0;
+    frame.gpuDuration = -1;
+    frame.cpuScopes.clear();
+    frame.gpuScopes.clear();
+    cpuStack.clear();
+
+    if(gpuTiming){
+        // This slot was used GPU_LATENCY frames ago, so its results should be ready by now
+        GpuFrame& gpuFrame = gpuFrames[frameIndex % GPU_LATENCY];
+        if(gpuFrame.pending) collect(gpuFrame);
+        gpuFrame.frameIndex = frameIndex;
+        gpuFrame.scopes.clear();
+        gpuFrame.stack.clear();
+        glBeginQuery(GL_TIME_ELAPSED, gpuFrame.frameQuery);
+    }
+}
+
+void Profiler::endFrame() {
+    if(!enabled || !inFrame) return;
+    inFrame = false;
+    while(!cpuStack.empty()) endScope();
+
+    FrameRecord& frame = getFrame(frameIndex);
+    frame.duration = now() - frame.start;
+
+    if(gpuTiming){
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuFrames[frameIndex % GPU_LATENCY].pending = true;
+    }
+}
+
+void Profiler::beginScope(const char* name) {
+    if(!enabled || !inFrame) return;
+
+    FrameRecord& frame = getFrame(frameIndex);
+    cpuStack.push_back((int)frame.cpuScopes.size());
+    frame.cpuScopes.push_back({name, (int)cpuStack.size() - 1, now(), 0});
+
+    if(gpuTiming){
+        GpuFrame& gpuFrame = gpuFrames[frameIndex % GPU_LATENCY];
+        size_t scope = gpuFrame.scopes.size();
+        // The queries are created once and reused in the next frames
+        if(gpuFrame.timestamps.size() < 2 * (scope + 1)){
+            gpuFrame.timestamps.resize(2 * (scope + 1));
+            glGenQueries(2, &gpuFrame.timestamps[2 * scope]);
+        }
+        gpuFrame.stack.push_back((int)scope);
+        gpuFrame.scopes.push_back({name, (int)gpuFrame.stack.size() - 1, 0, 0});
+        // The GPU writes its clock into the query when it reaches this point in the commands
+        glQueryCounter(gpuFrame.timestamps[2 * scope], GL_TIMESTAMP);
+    }
+}
+
+void Profiler::endScope() {
+    if(!enabled || !inFrame || cpuStack.empty()) return;
+
+    FrameRecord& frame = getFrame(frameIndex);
+    ScopeRecord& scope = frame.cpuScopes[cpuStack.back()];
+    scope.duration = now() - scope.start;
+    cpuStack.pop_back();
+
+    if(gpuTiming){
+        GpuFrame& gpuFrame = gpuFrames[frameIndex % GPU_LATENCY];
+        glQueryCounter(gpuFrame.timestamps[2 * gpuFrame.stack.back() + 1], GL_TIMESTAMP);
+        gpuFrame.stack.pop_back();
+    }
+}
+
+void Profiler::collect(GpuFrame& gpuFrame) {
+    gpuFrame.pending = false;
+
+    // The queries finish in order, so if the last one is available, all of them are
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(gpuFrame.frameQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(available && !gpuFrame.scopes.empty())
+        glGetQueryObjectiv(gpuFrame.timestamps[2 * gpuFrame.scopes.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available){
+        // The GPU is more than GPU_LATENCY frames behind, drop the results instead of waiting for them
+        droppedGpuFrames++;
+        return;
+    }
+
+    FrameRecord& frame = getFrame(gpuFrame.frameIndex);
+    if(frame.index != gpuFrame.frameIndex) return;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(gpuFrame.frameQuery, GL_QUERY_RESULT, &elapsed);
+    frame.gpuDuration = elapsed / 1000.0;
+
+    for(size_t i = 0; i < gpuFrame.scopes.size(); i++){
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(gpuFrame.timestamps[2 * i], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(gpuFrame.timestamps[2 * i + 1], GL_QUERY_RESULT, &end);
+        ScopeRecord scope = gpuFrame.scopes[i];
+        scope.start = begin / 1000.0 + gpuClockOffset;
+        scope.duration = (end - begin) / 1000.0;
+        frame.gpuScopes.push_back(scope);
+    }
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if(!file){
+        std::cerr << "Failed to write the trace " << path << std::endl;
+        return false;
+    }
+
+    // Every event is a complete event ("ph":"X") with a start time and a duration in microseconds
+    // The CPU events are shown on the first row (tid 1) and the GPU events on the second row (tid 2)
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    auto writeEvent = [&](const char* name, int tid, double start, double duration) {
+        file << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+             << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+    };
+
+    file.precision(3);
+    file << std::fixed;
+    // Start from the oldest frame in the ring buffer
+    uint64_t oldest = frameIndex >= frames.size() ? frameIndex - frames.size() + 1 : 1;
+    for(uint64_t index = oldest; index <= frameIndex; index++){
+        const FrameRecord& frame = frames[index % frames.size()];
+        if(frame.index != index || frame.duration == 0) continue;
+        writeEvent("frame", 1, frame.start, frame.duration);
+        for(const ScopeRecord& scope : frame.cpuScopes) writeEvent(scope.name, 1, scope.start, scope.duration);
+        for(const ScopeRecord& scope : frame.gpuScopes) writeEvent(scope.name, 2, scope.start, scope.duration);
+    }
+    file << "\n]}\n";
+
+    std::cout << "Saved the trace of the last frames to " << path << std::endl;
+    return true;
+}
+
+void Profiler::printSummary() const {
+    if(!enabled) return;
+
+    struct Total { double cpu = 0, gpu = 0; int cpuCount = 0, gpuCount = 0; };
+    std::map<std::string, Total> totals;
+    Total frameTotal;
+    for(const FrameRecord& frame : frames){
+        if(frame.index == 0 || frame.duration == 0) continue;
+        frameTotal.cpu += frame.duration; frameTotal.cpuCount++;
+        if(frame.gpuDuration >= 0){ frameTotal.gpu += frame.gpuDuration; frameTotal.gpuCount++; }
+        for(const ScopeRecord& scope : frame.cpuScopes){ totals[scope.name].cpu += scope.duration; totals[scope.name].cpuCount++; }
+        for(const ScopeRecord& scope : frame.gpuScopes){ totals[scope.name].gpu += scope.duration; totals[scope.name].gpuCount++; }
+    }
+
+    auto print = [](const std::string& name, const Total& total) {
+        std::cout << "  " << name << ": cpu " << (total.cpuCount ? total.cpu / total.cpuCount / 1000.0 : 0) << " ms";
+        if(total.gpuCount) std::cout << ", gpu " << total.gpu / total.gpuCount / 1000.0 << " ms";
+        std::cout << std::endl;
+    };
+    std::cout << "Average time per frame (" << frameTotal.cpuCount << " frames):" << std::endl;
+    print("frame", frameTotal);
+    for(auto& [name, total] : totals) print(name, total);
+    if(droppedGpuFrames > 0)
+        std::cout << "  " << droppedGpuFrames << " frames had no GPU times since the GPU was too far behind" << std::endl;
+}
+
+void Profiler::destroy() {
+    if(!gpuTiming) return;
+    for(GpuFrame& gpuFrame : gpuFrames){
+        glDeleteQueries(1, &gpuFrame.frameQuery);
+        if(!gpuFrame.timestamps.empty()) glDeleteQueries((GLsizei)gpuFrame.timestamps.size(), gpuFrame.timestamps.data());
+        gpuFrame = GpuFrame();
+    }
+    gpuTiming = false;
+}
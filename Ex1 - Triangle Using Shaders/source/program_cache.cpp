@@ -0,0 +1,127 @@
+#include "program_cache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+    // The cache file starts with this header, followed by "length" bytes of the program binary
+    struct ProgramBinaryHeader {
+        uint32_t magic;
+        uint32_t format;    // The binary format returned by glGetProgramBinary
+        uint32_t length;    // The size of the binary in bytes
+    };
+    const uint32_t PROGRAM_BINARY_MAGIC = 0x42505247; // "GRPB"
+
+    // FNV-1a hash, a simple and fast hash which is good enough to name cache files
+    uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashString(uint64_t hash, const std::string& text) {
+        // The size is hashed too, so that {"ab", "c"} and {"a", "bc"} get different hashes
+        uint64_t size = text.size();
+        hash = hashBytes(hash, &size, sizeof(size));
+        return hashBytes(hash, text.data(), text.size());
+    }
+
+    std::string getDriverString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string((const char*)value) : std::string();
+    }
+
+    std::filesystem::path getCachePath(const std::string& cacheKey) {
+        return std::filesystem::path(PROGRAM_CACHE_DIRECTORY) / (cacheKey + ".bin");
+    }
+
+    // Some drivers support OpenGL 4.1 but have no binary formats, then there is nothing to cache
+    bool isProgramBinarySupported() {
+        if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return false;
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        return formatCount > 0;
+    }
+}
+
+std::string getProgramCacheKey(const std::vector<std::string>& shaderPaths) {
+    uint64_t hash = 14695981039346656037ull;
+    for(const std::string& path : shaderPaths){
+        std::ifstream file(path, std::ios::binary);
+        std::string source = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        hash = hashString(hash, path);
+        hash = hashString(hash, source);
+    }
+    hash = hashString(hash, getDriverString(GL_VENDOR));
+    hash = hashString(hash, getDriverString(GL_RENDERER));
+    hash = hashString(hash, getDriverString(GL_VERSION));
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+    return key;
+}
+
+bool loadProgramBinary(GLuint program, const std::string& cacheKey) {
+    if(!isProgramBinarySupported()) return false;
+
+    // Must be set before linking, otherwise some drivers won't keep the binary for glGetProgramBinary
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    std::filesystem::path path = getCachePath(cacheKey);
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    ProgramBinaryHeader header;
+    if(!file.read((char*)&header, sizeof(header)) || header.magic != PROGRAM_BINARY_MAGIC) return false;
+    std::vector<char> binary(header.length);
+    if(!file.read(binary.data(), binary.size())) return false;
+    file.close();
+
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    // The driver may reject the binary, then the program is not linked and we have to compile from source
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(!linked){
+        std::cerr << "Program binary " << path.string() << " was rejected, compiling from source" << std::endl;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    return true;
+}
+
+void saveProgramBinary(GLuint program, const std::string& cacheKey) {
+    if(!isProgramBinarySupported()) return;
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(!linked) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIRECTORY, error);
+    std::filesystem::path path = getCachePath(cacheKey);
+    std::ofstream file(path, std::ios::binary);
+    if(!file){
+        std::cerr << "Failed to write the program binary " << path.string() << std::endl;
+        return;
+    }
+    ProgramBinaryHeader header = { PROGRAM_BINARY_MAGIC, format, (uint32_t)length };
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), length);
+}
@@ -0,0 +1,63 @@
+#include "uniform_buffers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+void setIdentityMatrix(float* matrix) {
+    for(int i = 0; i < 16; i++) matrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+void bindUniformBlocks(GLuint program) {
+    GLuint frameIndex = glGetUniformBlockIndex(program, "Frame");
+    if(frameIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, frameIndex, FRAME_UNIFORMS_BINDING);
+    GLuint objectIndex = glGetUniformBlockIndex(program, "Object");
+    if(objectIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, objectIndex, OBJECT_UNIFORMS_BINDING);
+}
+
+void UniformBuffer::create(size_t capacity) {
+    data.resize(capacity);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+}
+
+size_t UniformBuffer::getAlignedSize(size_t size) const {
+    if(alignment == 0){
+        GLint value = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+        alignment = value > 0 ? (size_t)value : 1;
+    }
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t UniformBuffer::write(const void* block, size_t size) {
+    size_t offset = used;
+    size_t alignedSize = getAlignedSize(size);
+    // Returning an offset that is already used (e.g. 0, the Frame block) would draw with the wrong uniforms,
+    // so the buffer grows instead, upload() sends the new size to the GPU since it allocates the buffer every frame
+    if(offset + alignedSize > data.size()){
+        size_t capacity = std::max(data.size() * 2, offset + alignedSize);
+        std::cerr << "The uniform buffer is full, growing it from " << data.size() << " to " << capacity << " bytes" << std::endl;
+        data.resize(capacity);
+    }
+    std::memcpy(data.data() + offset, block, size);
+    used += alignedSize;
+    return offset;
+}
+
+void UniformBuffer::upload() {
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, data.size(), nullptr, GL_STREAM_DRAW);
+    if(used > 0) glBufferSubData(GL_UNIFORM_BUFFER, 0, used, data.data());
+}
+
+void UniformBuffer::bindRange(GLuint binding, size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
+
+void UniformBuffer::destroy() {
+    if(buffer) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    data.clear();
+}
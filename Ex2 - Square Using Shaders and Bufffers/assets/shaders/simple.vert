@@ -1,6 +1,13 @@
 #version 330
 
-uniform float time;
+// The values shared by all the draws of a frame, sent once per frame in a uniform buffer (see source/uniform_buffers.hpp)
+// Only time is used here, but every shader declares the whole block the same way
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    float time;
+};
 
 // We specify explicity the entry location we wish an attribute to be defined in.
 // Thus we don't need to get the locations of these attributes in the main.cpp
@@ -1,8 +1,17 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
+#include "source/program_cache.hpp"
+#include "source/headless.hpp"
+#include "source/frame_stats.hpp"
+#include "source/profiler.hpp"
+#include "source/uniform_buffers.hpp"
+#include "source/frame_scheduler.hpp"
 
 GLuint loadShader(const std::string& filePath, GLenum shaderType) {
     GLuint shader = glCreateShader(shaderType);
@@ -14,6 +23,14 @@ GLuint loadShader(const std::string& filePath, GLenum shaderType) {
     glShaderSource(shader, 1, &sourceCStr, nullptr);
     glCompileShader(shader);
 
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if(!compiled){
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Failed to compile " << filePath << ":\n" << log << std::endl;
+    }
+
     return shader;
 }
 
@@ -25,7 +42,47 @@ struct Vertex {
     uint8_t r, g, b, a;
 };
 
-int main(int, char**) {
+// Reads the value of a command line option as a whole number between "low" and "high"
+// Returns false (and leaves "value" unchanged) for anything else, like "abc", "12abc", "-5" or a number too big for an int
+bool parseIntArgument(const char* text, int low, int high, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long number = std::strtol(text, &end, 10);
+    if(end == text || *end != '\0' || errno == ERANGE || number < low || number > high) return false;
+    value = (int)number;
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    // Command line options:
+    // --headless : draw into an offscreen framebuffer instead of a visible window (see source/headless.hpp)
+    // --frames N : close after drawing N frames and print the frame time statistics
+    // --profile : measure the CPU and GPU time of every part of the frame and save them to trace.json on exit
+    // --swap MODE : wait for the vertical blank before showing a frame (vsync) or show it immediately (uncapped, the default)
+    // --frames-in-flight N : let the CPU prepare at most N frames ahead of the GPU (2 by default, 0 for no limit, see source/frame_scheduler.hpp)
+    bool headless = false;
+    int frameLimit = 0;
+    bool profile = false;
+    FrameScheduler::SwapMode swapMode = FrameScheduler::SwapMode::Uncapped;
+    int framesInFlight = 2;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--headless"){
+            headless = true;
+        } else if(arg == "--frames" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, frameLimit)){
+            i++;
+        } else if(arg == "--profile"){
+            profile = true;
+        } else if(arg == "--swap" && i + 1 < argc && FrameScheduler::parseSwapMode(argv[i + 1], swapMode)){
+            i++;
+        } else if(arg == "--frames-in-flight" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, framesInFlight)){
+            i++;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+        }
+    }
+    if(headless && frameLimit == 0) frameLimit = 1000;
     
     if(!glfwInit()){
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -34,6 +91,7 @@ int main(int, char**) {
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    if(headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     GLFWwindow* window = glfwCreateWindow(500, 500, "Example 1", nullptr, nullptr);
     if(!window){
@@ -47,13 +105,25 @@ int main(int, char**) {
     gladLoadGL(glfwGetProcAddress);
 
     GLuint program = glCreateProgram();
-    GLuint vs = loadShader("assets/shaders/simple.vert", GL_VERTEX_SHADER);
-    glAttachShader(program, vs);
-    glDeleteShader(vs);
-    GLuint fs = loadShader("assets/shaders/simple.frag", GL_FRAGMENT_SHADER);
-    glAttachShader(program, fs);
-    glDeleteShader(fs);
-    glLinkProgram(program);
+    std::string programCacheKey = getProgramCacheKey({"assets/shaders/simple.vert", "assets/shaders/simple.frag"});
+    if(!loadProgramBinary(program, programCacheKey)){
+        GLuint vs = loadShader("assets/shaders/simple.vert", GL_VERTEX_SHADER);
+        glAttachShader(program, vs);
+        glDeleteShader(vs);
+        GLuint fs = loadShader("assets/shaders/simple.frag", GL_FRAGMENT_SHADER);
+        glAttachShader(program, fs);
+        glDeleteShader(fs);
+        glLinkProgram(program);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(!linked){
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "Failed to link the program:\n" << log << std::endl;
+        }
+        saveProgramBinary(program, programCacheKey);
+    }
 
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
@@ -134,18 +204,68 @@ int main(int, char**) {
 
     glBindVertexArray(0);
 
-    GLint timeLoc = glGetUniformLocation(program, "time");
+    // The time is sent in the Frame block of a uniform buffer instead of a uniform of the program (see source/uniform_buffers.hpp)
+    // The Frame block of the program is attached to the binding point that the buffer is bound to every frame
+    bindUniformBlocks(program);
+    UniformBuffer uniformBuffer;
+    uniformBuffer.create(uniformBuffer.getAlignedSize(sizeof(FrameUniforms)));
+    // There is no camera in this example, so the matrices stay the identity
+    FrameUniforms frameUniforms;
+    setIdentityMatrix(frameUniforms.view);
+    setIdentityMatrix(frameUniforms.projection);
+    setIdentityMatrix(frameUniforms.viewProjection);
+
+    OffscreenFramebuffer offscreen;
+    if(headless) offscreen = createOffscreenFramebuffer(500, 500);
+
+    FrameStats frameStats;
+    double lastFrameTime = glfwGetTime();
+
+    Profiler profiler;
+    if(profile) profiler.enable();
+
+    // The animation advances in fixed steps of 1/60 s, and the frame draws the time between the last 2 steps (see source/frame_scheduler.hpp)
+    FrameScheduler scheduler;
+    scheduler.start(swapMode, framesInFlight);
+    double previousTime = 0, simulationTime = 0;
 
-    while(!glfwWindowShouldClose(window)){
+    while(!glfwWindowShouldClose(window) && (frameLimit == 0 || (int)frameStats.getFrameCount() < frameLimit)){
         // We're writing numbers here ended with f
         // Since this function's signature takes floats
+        profiler.beginFrame();
+
+        // Waits for the GPU if too many frames are in flight, then reads the input, so the frame is made from the newest input
+        profiler.beginScope("wait for GPU");
+        scheduler.waitForFrameSlot();
+        profiler.endScope();
+
+        profiler.beginScope("poll events");
+        glfwPollEvents();
+        profiler.endScope();
+
+        // The fixed steps of the simulation, here it is only the time
+        int steps = scheduler.advance();
+        for(int step = 0; step < steps; step++){
+            previousTime = simulationTime;
+            simulationTime += scheduler.getStepTime();
+        }
+
+        profiler.beginScope("clear");
         glClearColor(0.2f, 0.4f, 0.6f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
+        profiler.endScope();
 
+        profiler.beginScope("uniforms");
         glBindVertexArray(VAO);
         glUseProgram(program);
 
-        glUniform1f(timeLoc, (float)glfwGetTime());
+        // The time between the last 2 steps, at the fraction of a step left in the scheduler
+        frameUniforms.time = (float)(previousTime + (simulationTime - previousTime) * scheduler.getAlpha());
+        uniformBuffer.beginFrame();
+        size_t frameOffset = uniformBuffer.write(&frameUniforms, sizeof(FrameUniforms));
+        uniformBuffer.upload();
+        uniformBuffer.bindRange(FRAME_UNIFORMS_BINDING, frameOffset, sizeof(FrameUniforms));
+        profiler.endScope();
 
         // The line below will draw 2 traingle, each triangle will be draw using 3 of the 6 vertices
         // However, we didn't use this line, since we only defined data for 4 vertices not 6, in order to optimize in memory
@@ -154,11 +274,38 @@ int main(int, char**) {
         // Want to draw 6 elements
         // Third param: Type of data in the elements array
         // Fourth param: To skip some locations in the buffer 
+        profiler.beginScope("draw");
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (void*)0);
+        profiler.endScope();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        profiler.beginScope("swap");
+        if(headless) glFinish();
+        else glfwSwapBuffers(window);
+        profiler.endScope();
+
+        scheduler.endFrame();
+
+        profiler.endFrame();
+
+        double now = glfwGetTime();
+        // The frame times are only printed when there is a frame limit (--frames or --headless)
+        // Without one the window can stay open for hours, so they aren't kept at all
+        if(frameLimit > 0) frameStats.addFrame(1000.0 * (now - lastFrameTime));
+        lastFrameTime = now;
+    }
+
+    if(frameLimit > 0){
+        frameStats.print("Example 2");
+        scheduler.printStats("Frame scheduler");
+    }
+    scheduler.destroy();
+    if(profile){
+        profiler.printSummary();
+        profiler.exportChromeTrace("trace.json");
     }
+    profiler.destroy();
+    if(headless) destroyOffscreenFramebuffer(offscreen);
+    uniformBuffer.destroy();
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
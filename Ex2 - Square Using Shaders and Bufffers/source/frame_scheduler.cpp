@@ -0,0 +1,113 @@
+#include "frame_scheduler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+bool FrameScheduler::parseSwapMode(const std::string& name, SwapMode& mode) {
+    if(name == "vsync") mode = SwapMode::Vsync;
+    else if(name == "uncapped") mode = SwapMode::Uncapped;
+    else return false;
+    return true;
+}
+
+const char* FrameScheduler::getSwapModeName(SwapMode mode) {
+    return mode == SwapMode::Vsync ? "vsync" : "uncapped";
+}
+
+void FrameScheduler::start(SwapMode swapMode, int framesInFlight, double stepsPerSecond) {
+    mode = swapMode;
+    maxFramesInFlight = std::max(framesInFlight, 0);
+    stepTime = 1.0 / stepsPerSecond;
+    accumulator = 0;
+    lastTime = -1;
+    // The number of vertical blanks to wait for before swapping: 1 is vsync, 0 swaps immediately
+    glfwSwapInterval(mode == SwapMode::Vsync ? 1 : 0);
+}
+
+void FrameScheduler::waitForFrameSlot() {
+    collectFinishedFrames();
+    while(maxFramesInFlight > 0 && (int)inFlight.size() >= maxFramesInFlight){
+        double start = glfwGetTime();
+        // GL_SYNC_FLUSH_COMMANDS_BIT makes sure the fence was sent to the GPU, otherwise the wait could never end
+        // The timeout is in nanoseconds, the loop waits again if the GPU takes longer than 1 second
+        GLenum result;
+        do {
+            result = glClientWaitSync(inFlight.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while(result == GL_TIMEOUT_EXPIRED);
+        double now = glfwGetTime();
+        stats.waits++;
+        stats.waitTime += 1000.0 * (now - start);
+        finishFrame(now);
+    }
+}
+
+int FrameScheduler::advance() {
+    double now = glfwGetTime();
+    inputTime = now;
+    // The first frame starts the clock, so it runs no step
+    if(lastTime < 0) lastTime = now;
+    accumulator += now - lastTime;
+    lastTime = now;
+
+    int steps = (int)(accumulator / stepTime);
+    if(steps > MAX_STEPS_PER_FRAME){
+        stats.droppedTime += 1000.0 * (steps - MAX_STEPS_PER_FRAME) * stepTime;
+        accumulator -= (steps - MAX_STEPS_PER_FRAME) * stepTime;
+        steps = MAX_STEPS_PER_FRAME;
+    }
+    accumulator = std::max(accumulator - steps * stepTime, 0.0);
+    stats.steps += steps;
+    stats.frames++;
+    return steps;
+}
+
+void FrameScheduler::endFrame() {
+    // The fence is signaled when the GPU has finished all the commands before it, including the swap
+    inFlight.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), inputTime});
+    collectFinishedFrames();
+}
+
+void FrameScheduler::collectFinishedFrames() {
+    // The fences are signaled in order, so the first one not signaled stops the search
+    // A frame found here finished some time before now, so its latency is an upper bound
+    while(!inFlight.empty()){
+        GLenum result = glClientWaitSync(inFlight.front().fence, 0, 0);
+        if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) break;
+        finishFrame(glfwGetTime());
+    }
+}
+
+void FrameScheduler::finishFrame(double now) {
+    double latency = 1000.0 * (now - inFlight.front().inputTime);
+    if(stats.latencies.size() < LATENCY_HISTORY) stats.latencies.push_back(latency);
+    else stats.latencies[stats.latencyCount % LATENCY_HISTORY] = latency;
+    stats.latencyCount++;
+    stats.totalLatency += latency;
+    stats.maxLatency = std::max(stats.maxLatency, latency);
+    glDeleteSync(inFlight.front().fence);
+    inFlight.pop_front();
+}
+
+void FrameScheduler::printStats(const std::string& label) const {
+    std::cout << label << ": " << getSwapModeName(mode) << ", ";
+    if(maxFramesInFlight > 0) std::cout << "at most " << maxFramesInFlight << " frames in flight, ";
+    else std::cout << "no limit of frames in flight, ";
+    std::cout << stats.steps << " steps of " << 1000.0 * stepTime << " ms in " << stats.frames << " frames";
+    if(stats.droppedTime > 0) std::cout << " (" << stats.droppedTime << " ms dropped)";
+    std::cout << ", waited for the GPU in " << stats.waits << " frames (" << stats.waitTime << " ms)" << std::endl;
+    if(stats.latencies.empty()) return;
+
+    // The order in the ring buffer doesn't matter once sorted
+    std::vector<double> sorted = stats.latencies;
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "  input-to-photon latency: avg " << stats.totalLatency / stats.latencyCount << " ms, "
+              << "median " << sorted[sorted.size() / 2] << " ms, "
+              << "p99 " << sorted[(size_t)(0.99 * (sorted.size() - 1) + 0.5)] << " ms";
+    if(stats.latencyCount > sorted.size()) std::cout << " (of the last " << sorted.size() << " frames)";
+    std::cout << ", max " << stats.maxLatency << " ms (until the GPU finished the frame, without the display)" << std::endl;
+}
+
+void FrameScheduler::destroy() {
+    for(InFlightFrame& frame : inFlight) glDeleteSync(frame.fence);
+    inFlight.clear();
+}
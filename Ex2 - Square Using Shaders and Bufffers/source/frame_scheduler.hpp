@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+// Frame Scheduler
+// ----------------
+// Without a scheduler, the animation reads glfwGetTime() once per frame, so how much it moves depends on the frame rate,
+// and the CPU can prepare frames as fast as it wants, far ahead of what the GPU has drawn. The scheduler separates 3 things:
+//
+// 1. Fixed-timestep updates: the simulation (the time, the camera angle) always advances by the same step (1/60 s by default),
+//    so it behaves the same at 30 or 300 frames per second. Every frame, the time since the last frame is added to an accumulator,
+//    and as many whole steps as it holds are run (0 if the frame was shorter than a step, several if it was longer).
+//    If a frame is very long (a breakpoint, a window drag), at most MAX_STEPS_PER_FRAME steps are run and the rest is dropped,
+//    otherwise the steps would make the next frame longer too.
+// 2. Interpolated rendering: the time left in the accumulator is a fraction of a step (getAlpha(), from 0 to 1).
+//    The frame draws the state between the last 2 steps at that fraction, so the motion is smooth even if the steps and the frames
+//    don't line up. It is a fraction of a step behind the simulation, which is the price of the smoothness.
+// 3. Frames in flight: OpenGL calls only queue commands, so the CPU can be several frames ahead of the GPU.
+//    Each of these frames was made from input read earlier, so it adds latency. After every swap the scheduler puts a fence,
+//    and before a new frame it waits until at most "maxFramesInFlight - 1" frames are still queued.
+//    1 frame in flight gives the lowest latency (the CPU and the GPU take turns), 2 or 3 let them work at the same time.
+// The swap mode chooses between waiting for the vertical blank of the display (vsync, glfwSwapInterval(1), no tearing,
+// at most the refresh rate) and swapping immediately (uncapped, glfwSwapInterval(0), the highest frame rate).
+//
+// The input-to-photon latency is measured as the time from reading the input (glfwPollEvents, right after the wait)
+// to the moment the GPU has finished the frame made from it, including its swap (its fence is signaled).
+// The display adds the time until it shows the image (up to 1 refresh with vsync), which the program can't see.
+//
+// Usage:
+//      scheduler.start(FrameScheduler::SwapMode::Vsync, 2, 60);
+//      while(...){
+//          scheduler.waitForFrameSlot();
+//          glfwPollEvents();
+//          int steps = scheduler.advance();
+//          for(int i = 0; i < steps; i++) { previous = current; current = update(current, scheduler.getStepTime()); }
+//          draw(mix(previous, current, scheduler.getAlpha()));
+//          glfwSwapBuffers(window);
+//          scheduler.endFrame();
+//      }
+class FrameScheduler {
+public:
+    enum class SwapMode { Vsync, Uncapped };
+
+    static const int MAX_STEPS_PER_FRAME = 8;
+    // The number of latencies kept for the median and the 99th percentile, like the frames of the Profiler
+    static const size_t LATENCY_HISTORY = 600;
+
+    struct Stats {
+        size_t frames = 0;
+        size_t steps = 0;
+        double droppedTime = 0;    // The time that wasn't simulated because of MAX_STEPS_PER_FRAME (in milliseconds)
+        size_t waits = 0;          // The frames that waited for the GPU because too many frames were in flight
+        double waitTime = 0;       // In milliseconds
+        // The input-to-photon latency of the frames whose fence was seen (in milliseconds)
+        // The average and the maximum are over all of them, but only the last LATENCY_HISTORY are kept (in a ring buffer),
+        // so a window left open for hours doesn't grow the memory
+        size_t latencyCount = 0;
+        double totalLatency = 0;
+        double maxLatency = 0;
+        std::vector<double> latencies;
+    };
+
+    // Parses "vsync" or "uncapped", returns false if the name is unknown
+    static bool parseSwapMode(const std::string& name, SwapMode& mode);
+    static const char* getSwapModeName(SwapMode mode);
+
+    // Sets the swap interval of the current context, the limit of frames in flight (0 for no limit)
+    // and the number of fixed steps per second
+    void start(SwapMode mode, int maxFramesInFlight, double stepsPerSecond = 60.0);
+
+    // Waits until fewer than maxFramesInFlight frames are queued on the GPU, call it first in the frame
+    void waitForFrameSlot();
+
+    // Adds the time since the last call to the accumulator and returns the number of fixed steps to run
+    // Call it right after polling the input, its time is the start of the input-to-photon latency
+    int advance();
+
+    // The duration of 1 step in seconds
+    double getStepTime() const { return stepTime; }
+    // How far the frame is between the state before the last step (0) and after it (1)
+    double getAlpha() const { return accumulator / stepTime; }
+
+    // Puts the fence of the frame, call it right after swapping the buffers
+    void endFrame();
+
+    const Stats& getStats() const { return stats; }
+    // Prints the swap mode, the steps, the waits and the average, median, 99th percentile and maximum latency
+    // (the median and the 99th percentile of the last LATENCY_HISTORY frames)
+    void printStats(const std::string& label) const;
+
+    // Deletes the fences of the frames still in flight
+    void destroy();
+
+private:
+    struct InFlightFrame {
+        GLsync fence;
+        double inputTime;
+    };
+
+    // Removes the frames whose fence is signaled from the front of the queue, without waiting
+    void collectFinishedFrames();
+    void finishFrame(double now);
+
+    SwapMode mode = SwapMode::Uncapped;
+    int maxFramesInFlight = 0;
+    double stepTime = 1.0 / 60.0;
+    double accumulator = 0;
+    double lastTime = -1;
+    double inputTime = 0;
+    std::deque<InFlightFrame> inFlight;
+    Stats stats;
+};
@@ -0,0 +1,31 @@
+#include "frame_stats.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+void FrameStats::print(const std::string& label) const {
+    if(frameTimes.empty()){
+        std::cout << label << ": no frames" << std::endl;
+        return;
+    }
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    // Returns the frame time that "fraction" of the frames are faster than
+    auto percentile = [&](double fraction) {
+        size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    };
+
+    double total = 0;
+    for(double time : sorted) total += time;
+    double average = total / sorted.size();
+
+    std::cout << label << ": " << sorted.size() << " frames, "
+              << "avg " << average << " ms (" << 1000.0 / average << " fps), "
+              << "min " << sorted.front() << " ms, "
+              << "median " << percentile(0.5) << " ms, "
+              << "p95 " << percentile(0.95) << " ms, "
+              << "p99 " << percentile(0.99) << " ms, "
+              << "max " << sorted.back() << " ms" << std::endl;
+}
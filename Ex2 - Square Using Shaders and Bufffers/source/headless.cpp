@@ -0,0 +1,40 @@
+#include "headless.hpp"
+
+#include <iostream>
+
+OffscreenFramebuffer createOffscreenFramebuffer(int width, int height) {
+    OffscreenFramebuffer offscreen;
+    offscreen.width = width;
+    offscreen.height = height;
+
+    // Renderbuffers are images that can only be drawn into (unlike textures, they can't be sampled in shaders)
+    glGenRenderbuffers(1, &offscreen.colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen.colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &offscreen.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // The framebuffer combines the renderbuffers, and while it is bound, draw calls write into it instead of the window
+    glGenFramebuffers(1, &offscreen.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen.colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen.depthBuffer);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "The offscreen framebuffer is incomplete" << std::endl;
+
+    glViewport(0, 0, width, height);
+    return offscreen;
+}
+
+void destroyOffscreenFramebuffer(OffscreenFramebuffer& offscreen) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &offscreen.framebuffer);
+    glDeleteRenderbuffers(1, &offscreen.colorBuffer);
+    glDeleteRenderbuffers(1, &offscreen.depthBuffer);
+    offscreen = OffscreenFramebuffer();
+}
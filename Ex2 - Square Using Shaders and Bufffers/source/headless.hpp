@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glad/gl.h>
+
+// Headless Rendering
+// ----------------
+// On machines without a display (or without a GPU), we can't show a window, but we can still render.
+// Instead of drawing on the window's back buffer, we draw into a framebuffer object (FBO) that lives in memory.
+// To run without any display, configure with -DHEADLESS=ON so that GLFW uses its null platform
+// with an OSMesa context (software rendering through Mesa, e.g. llvmpipe).
+// Then run the example with "--headless --frames N" to render N frames and print the frame time statistics.
+
+struct OffscreenFramebuffer {
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;     // RGBA8 renderbuffer
+    GLuint depthBuffer = 0;     // 24-bit depth + 8-bit stencil renderbuffer, same as the default window framebuffer
+    int width = 0, height = 0;
+};
+
+// Creates a framebuffer of the given size and binds it, so every draw call after it draws into the framebuffer
+// The viewport is also set to cover the whole framebuffer
+OffscreenFramebuffer createOffscreenFramebuffer(int width, int height);
+
+// Unbinds and deletes the framebuffer and its renderbuffers
+void destroyOffscreenFramebuffer(OffscreenFramebuffer& offscreen);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <glad/gl.h>
+
+// Frame Profiler
+// ----------------
+// Measures where the time of each frame goes, both on the CPU and on the GPU.
+//
+// CPU: each scope records the time when it begins and ends, scopes can be nested (e.g. "render" contains "clear" and "draw").
+// GPU: the CPU only sends commands, the GPU runs them later. So to time the GPU work, we ask the GPU itself to write
+//      a timestamp when it reaches the beginning and the end of each scope (glQueryCounter with GL_TIMESTAMP),
+//      and we measure the whole frame with a GL_TIME_ELAPSED query.
+//      Reading a query result before the GPU finished would block the CPU until the GPU catches up,
+//      so the results of a frame are read "GPU_LATENCY" frames later, and they are skipped if they are still not ready.
+//
+// The results of the last frames are kept in a ring buffer, and can be saved as a Chrome trace
+// (open chrome://tracing or https://ui.perfetto.dev and load the file).
+//
+// Usage:
+//      profiler.beginFrame();
+//      profiler.beginScope("clear"); glClear(...); profiler.endScope();
+//      ...
+//      profiler.endFrame();
+//      profiler.exportChromeTrace("trace.json");
+//
+// Note: the scope names must be string literals (or live as long as the profiler), since only their pointers are stored.
+class Profiler {
+public:
+    // A scope measured on the CPU or on the GPU, times are in microseconds since the profiler was created
+    struct ScopeRecord {
+        const char* name;
+        int depth;          // 0 for the scopes directly inside the frame, 1 for the scopes inside them, ...
+        double start;
+        double duration;
+    };
+
+    // Everything measured in 1 frame
+    struct FrameRecord {
+        uint64_t index;
+        double start, duration;         // CPU time of the frame in microseconds
+        double gpuDuration;             // GPU time of the frame in microseconds, negative if not available (yet)
+        std::vector<ScopeRecord> cpuScopes;
+        std::vector<ScopeRecord> gpuScopes;
+    };
+
+    // The number of frames to wait before reading the GPU queries of a frame
+    static const int GPU_LATENCY = 4;
+
+    // "frameHistory" is the number of frames kept in the ring buffer
+    explicit Profiler(size_t frameHistory = 600);
+
+    // Must be called after the OpenGL context is created
+    // The profiler does nothing until it is enabled, so it can be left in the code without any cost
+    void enable();
+    bool isEnabled() const { return enabled; }
+
+    void beginFrame();
+    void endFrame();
+
+    void beginScope(const char* name);
+    void endScope();
+
+    // Writes the frames in the ring buffer in the Chrome trace event format (JSON)
+    bool exportChromeTrace(const std::string& path) const;
+
+    // Prints the average CPU and GPU time of every scope over the frames in the ring buffer
+    void printSummary() const;
+
+    // Deletes the GPU queries, must be called before the OpenGL context is destroyed
+    void destroy();
+
+private:
+    // The queries sent during 1 frame, they are reused once their results are read
+    struct GpuFrame {
+        uint64_t frameIndex = 0;
+        bool pending = false;               // True if the queries were sent and their results were not read yet
+        GLuint frameQuery = 0;              // GL_TIME_ELAPSED query for the whole frame
+        std::vector<GLuint> timestamps;     // 2 GL_TIMESTAMP queries (begin and end) for each scope
+        std::vector<ScopeRecord> scopes;
+        std::vector<int> stack;             // The scopes that began but didn't end yet
+    };
+
+    double now() const;
+    FrameRecord& getFrame(uint64_t index) { return frames[index % frames.size()]; }
+    // Reads the results of a GPU frame if they are available, otherwise drops them
+    void collect(GpuFrame& gpuFrame);
+
+    bool enabled = false;
+    bool gpuTiming = false;
+    bool inFrame = false;
+    std::chrono::steady_clock::time_point epoch;
+    // The difference between the CPU clock and the GPU clock (in microseconds) to show them on the same timeline
+    double gpuClockOffset = 0;
+
+    uint64_t frameIndex = 0;
+    std::vector<FrameRecord> frames;
+    std::vector<int> cpuStack;
+    GpuFrame gpuFrames[GPU_LATENCY];
+    uint64_t droppedGpuFrames = 0;
+};
@@ -0,0 +1,21 @@
+#version 330
+
+in vec4 vertex_color;
+in vec2 vertex_uv;              // The coordinate in the image, it repeats outside [0, 1]
+flat in vec4 vertex_rect;       // xy: the offset of the image's rectangle in the layer, zw: its size
+flat in float vertex_layer;
+
+// All the images are in the layers of 1 texture array bound to texture unit 0, the 3rd coordinate is the layer
+uniform sampler2DArray atlas;
+
+out vec4 frag_color;
+
+void main(){
+    // fract() repeats the image inside its rectangle, like GL_REPEAT does for a whole texture
+    vec2 uv = vertex_rect.xy + fract(vertex_uv) * vertex_rect.zw;
+    // fract() jumps from 1 to 0 where the image repeats, so the mip level is chosen from the derivatives before it
+    vec2 dx = dFdx(vertex_uv) * vertex_rect.zw;
+    vec2 dy = dFdy(vertex_uv) * vertex_rect.zw;
+    // The texture is tinted by the vertex colors
+    frag_color = textureGrad(atlas, vec3(uv, vertex_layer), dx, dy) * mix(vec4(1.0), vertex_color, 0.25);
+}
@@ -0,0 +1,27 @@
+#version 330
+
+// The Object block of the square being drawn, with the rectangle of its image in the texture array (see source/texture_atlas.hpp)
+layout(std140) uniform Object {
+    mat4 MVP;
+    vec4 atlasRect;     // xy: the offset of the rectangle, zw: its size
+    float atlasLayer;
+};
+
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 color;
+
+out vec4 vertex_color;
+out vec2 vertex_uv;
+flat out vec4 vertex_rect;
+flat out float vertex_layer;
+
+void main(){
+    gl_Position = MVP * vec4(position, 1.0);
+    vertex_color = color;
+    // Like textured.vert, the corners of the square (from -0.5 to 0.5) get the corners of its image (from 0 to 1)
+    // They are moved into the rectangle by atlas.frag, since other positions (a mesh, or snorm16 positions from -1 to 1)
+    // go outside [0, 1] and must repeat the image instead of reading the neighbors in the layer
+    vertex_uv = position.xy + 0.5;
+    vertex_rect = atlasRect;
+    vertex_layer = atlasLayer;
+}
@@ -0,0 +1,10 @@
+#version 330
+
+in vec4 vertex_color;
+
+out vec4 frag_color;
+
+// Used while the real program is still compiling, it draws everything in a flat gray color
+void main(){
+    frag_color = vec4(0.5, 0.5, 0.5, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 330
+
+// Same as simple.vert, but the model matrix comes from an instance attribute instead of a uniform block
+// The View-Projection matrix is the same for all the squares, so it is read from the per-frame block (see source/uniform_buffers.hpp)
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    float time;
+};
+
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 color;
+// A mat4 attribute takes 4 locations, so "model" occupies the locations 2, 3, 4 and 5
+// Its value changes once per instance (square) since its divisor is set to 1 in the main.cpp
+layout(location=2) in mat4 model;
+
+out vec4 vertex_color;
+
+void main(){
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+    vertex_color = color;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330
+
+// Same as atlas.vert, but the model matrix and the rectangle of the image come from instance attributes (see source/texture_atlas.hpp)
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    float time;
+};
+
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 color;
+// The model matrix occupies the locations 2, 3, 4 and 5
+layout(location=2) in mat4 model;
+// Read from a second instance buffer, once per instance too (6 and 7 are kept for the normals and texture coordinates)
+layout(location=8) in vec4 atlasRect;
+layout(location=9) in float atlasLayer;
+
+out vec4 vertex_color;
+out vec2 vertex_uv;
+flat out vec4 vertex_rect;
+flat out float vertex_layer;
+
+void main(){
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+    vertex_color = color;
+    vertex_uv = position.xy + 0.5;
+    vertex_rect = atlasRect;
+    vertex_layer = atlasLayer;
+}
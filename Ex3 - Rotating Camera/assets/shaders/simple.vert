@@ -1,6 +1,9 @@
 #version 330
 
-uniform mat4 MVP;
+// The MVP of the square being drawn, read from the part of the uniform buffer bound before the draw (see source/uniform_buffers.hpp)
+layout(std140) uniform Object {
+    mat4 MVP;
+};
 
 layout(location=0) in vec3 position;
 layout(location=1) in vec4 color;
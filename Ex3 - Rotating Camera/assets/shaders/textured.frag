@@ -0,0 +1,14 @@
+#version 330
+
+in vec4 vertex_color;
+in vec2 vertex_uv;
+
+// The texture bound to texture unit 0, which is the default unit of a sampler, so it doesn't need to be set with glUniform1i
+uniform sampler2D tex;
+
+out vec4 frag_color;
+
+void main(){
+    // The texture is tinted by the vertex colors
+    frag_color = texture(tex, vertex_uv) * mix(vec4(1.0), vertex_color, 0.25);
+}
@@ -0,0 +1,20 @@
+#version 330
+
+// The MVP of the square being drawn, read from the part of the uniform buffer bound before the draw (see source/uniform_buffers.hpp)
+layout(std140) uniform Object {
+    mat4 MVP;
+};
+
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 color;
+
+out vec4 vertex_color;
+out vec2 vertex_uv;
+
+void main(){
+    gl_Position = MVP * vec4(position, 1.0);
+    vertex_color = color;
+    // The vertices have no texture coordinates, so the texture is projected on the square along the z-axis:
+    // the corners of the square (from -0.5 to 0.5) get the corners of the texture (from 0 to 1)
+    vertex_uv = position.xy + 0.5;
+}
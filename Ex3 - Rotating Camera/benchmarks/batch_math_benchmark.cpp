@@ -0,0 +1,95 @@
+// Compares the batch math functions (source/batch_math.hpp) with multiplying the glm matrices one by one
+// Build it in Release mode, otherwise the compiler doesn't optimize any of them and the comparison is meaningless
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include "../source/batch_math.hpp"
+
+// Runs "function" enough times to take about 0.2 seconds, and returns the average time of 1 run in milliseconds
+template<typename Function>
+double measure(Function function) {
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do {
+        function();
+        runs++;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while(elapsed < 200.0);
+    return elapsed / runs;
+}
+
+float maxDifference(const glm::mat4* a, const glm::mat4* b, size_t count) {
+    float difference = 0;
+    for(size_t i = 0; i < count; i++)
+        for(int c = 0; c < 4; c++)
+            for(int r = 0; r < 4; r++)
+                difference = std::max(difference, std::abs(a[i][c][r] - b[i][c][r]));
+    return difference;
+}
+
+int main(int, char**) {
+#ifndef NDEBUG
+    std::cout << "Warning: the benchmark is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    std::cout << "Best SIMD level supported by this CPU: " << getSimdLevelName(getSupportedSimdLevel()) << std::endl;
+
+    std::vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if((int)getSupportedSimdLevel() >= (int)SimdLevel::SSE2) levels.push_back(SimdLevel::SSE2);
+    if((int)getSupportedSimdLevel() >= (int)SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+
+    glm::mat4 viewProjection = glm::perspective(glm::pi<float>()/2, 4.0f/3.0f, 0.01f, 100.0f)
+                             * glm::lookAt(glm::vec3(3, 1, 2), glm::vec3(0), glm::vec3(0, 1, 0));
+
+    for(size_t count : {1000, 10000, 100000, 1000000}){
+        std::cout << "\n" << count << " objects" << std::endl;
+
+        std::vector<glm::mat4> models(count), expected(count), results(count);
+        for(size_t i = 0; i < count; i++)
+            models[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i % 100, (i / 100) % 100, i / 10000));
+
+        // The way the renderer did it before: 1 glm multiplication per object
+        double glmTime = measure([&]{
+            for(size_t i = 0; i < count; i++) expected[i] = viewProjection * models[i];
+        });
+        std::cout << "  MVP, glm::mat4 per object: " << glmTime << " ms" << std::endl;
+
+        for(SimdLevel level : levels){
+            setSimdLevel(level);
+            double time = measure([&]{ multiplyMatrices(viewProjection, models.data(), results.data(), count); });
+            std::cout << "  MVP, batch " << getSimdLevelName(level) << ": " << time << " ms ("
+                      << glmTime / time << "x, max error " << maxDifference(expected.data(), results.data(), count) << ")" << std::endl;
+        }
+
+        // Points: glm::vec4 per point against the SoA batch function
+        std::vector<glm::vec3> points(count);
+        std::vector<glm::vec4> expectedPoints(count);
+        PointsSoA soa, transformed;
+        soa.resize(count);
+        for(size_t i = 0; i < count; i++){
+            points[i] = glm::vec3(i % 100, (i / 100) % 100, i / 10000);
+            soa.x[i] = points[i].x; soa.y[i] = points[i].y; soa.z[i] = points[i].z;
+        }
+        double glmPointsTime = measure([&]{
+            for(size_t i = 0; i < count; i++) expectedPoints[i] = viewProjection * glm::vec4(points[i], 1.0f);
+        });
+        std::cout << "  points, glm::vec4 per point: " << glmPointsTime << " ms" << std::endl;
+
+        for(SimdLevel level : levels){
+            setSimdLevel(level);
+            double time = measure([&]{ transformPoints(viewProjection, soa, transformed); });
+            float error = 0;
+            for(size_t i = 0; i < count; i++)
+                error = std::max(error, std::abs(transformed.w[i] - expectedPoints[i].w) + std::abs(transformed.x[i] - expectedPoints[i].x));
+            std::cout << "  points, batch SoA " << getSimdLevelName(level) << ": " << time << " ms ("
+                      << glmPointsTime / time << "x, max error " << error << ")" << std::endl;
+        }
+    }
+    return 0;
+}
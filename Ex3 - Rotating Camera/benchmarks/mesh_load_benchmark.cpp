@@ -0,0 +1,93 @@
+// Compares the time it takes to load a mesh from a text file (OBJ or PLY) and from a .mesh file (see source/mesh_file.hpp)
+// Usage: MeshLoadBenchmark input.obj
+// The .mesh file is written next to the input file
+// Build it in Release mode, otherwise the parsing is much slower than it would be in the real program
+
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include "../source/mesh_importer.hpp"
+#include "../source/mesh_file.hpp"
+
+// Runs "function" "runs" times and returns the fastest time in milliseconds
+// The fastest run is the one least disturbed by the rest of the system, and the file is in the OS cache after the first run
+template<typename Function>
+double measure(int runs, Function function) {
+    using Clock = std::chrono::steady_clock;
+    double best = 1e30;
+    for(int i = 0; i < runs; i++){
+        Clock::time_point start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+// Reads every cache line of the data, like the driver does when glBufferData copies it
+// With a mapped file, this is when the pages are really read, so the time must include it
+uint64_t touch(const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t sum = 0;
+    for(size_t i = 0; i < size; i += 64) sum += bytes[i];
+    return sum;
+}
+
+int main(int argc, char** argv) {
+#ifndef NDEBUG
+    std::cout << "Warning: the benchmark is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    if(argc != 2){
+        std::cerr << "Usage: " << argv[0] << " input.obj|input.ply" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1];
+    std::string output = input.substr(0, input.find_last_of('.')) + ".mesh";
+    const int runs = 5;
+
+    ThreadPool threadPool;
+    Mesh mesh;
+    if(!importMesh(input, mesh, &threadPool) || !saveMeshFile(output, mesh)) return 1;
+    size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex), indexBytes = mesh.indexData.size();
+    std::cout << mesh.getTriangleCount() << " triangles, " << mesh.vertices.size() << " vertices, "
+              << (vertexBytes + indexBytes) / (1024.0 * 1024.0) << " MB of GPU data" << std::endl;
+
+    uint64_t checksum = 0;
+
+    double importOneThread = measure(runs, [&]{
+        Mesh imported;
+        importMesh(input, imported);
+        checksum += touch(imported.vertices.data(), vertexBytes);
+    });
+    double importThreads = measure(runs, [&]{
+        Mesh imported;
+        importMesh(input, imported, &threadPool);
+        checksum += touch(imported.vertices.data(), vertexBytes);
+    });
+
+    // Reading the whole .mesh file into memory with 1 copy, as a program without mapping would do
+    double readFile = measure(runs, [&]{
+        std::ifstream file(output, std::ios::binary | std::ios::ate);
+        std::vector<char> data((size_t)file.tellg());
+        file.seekg(0);
+        file.read(data.data(), data.size());
+        checksum += touch(data.data(), data.size());
+    });
+
+    // Mapping it, the data is used where it is
+    double mapFile = measure(runs, [&]{
+        MeshFile file;
+        file.open(output);
+        const MeshView& view = file.getView();
+        checksum += touch(view.vertices, view.vertexCount * sizeof(Vertex));
+        checksum += touch(view.indexData, view.indexCount * view.getIndexSize());
+    });
+
+    std::cout << "Import " << input << " on 1 thread:   " << importOneThread << " ms" << std::endl;
+    std::cout << "Import " << input << " on " << threadPool.getThreadCount() << " threads: " << importThreads << " ms" << std::endl;
+    std::cout << "Read " << output << " with ifstream: " << readFile << " ms" << std::endl;
+    std::cout << "Map " << output << ":             " << mapFile << " ms (" << importThreads / mapFile << "x faster than importing)" << std::endl;
+    // Printed so the compiler can't remove the reads
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
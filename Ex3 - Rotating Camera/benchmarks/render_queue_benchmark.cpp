@@ -0,0 +1,101 @@
+// Measures how fast the render queue (source/render_queue.hpp) fills and sorts its draws, compared with std::stable_sort,
+// and how many program and vertex array switches the sorting saves
+// Only the CPU side is measured, the draws aren't sent to OpenGL
+// Build it in Release mode, otherwise the compiler doesn't optimize the loops and the comparison is meaningless
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "../source/render_queue.hpp"
+
+// Runs "function" enough times to take about 0.2 seconds, and returns the average time of 1 run in milliseconds
+template<typename Function>
+double measure(Function function) {
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do {
+        function();
+        runs++;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while(elapsed < 200.0);
+    return elapsed / runs;
+}
+
+// A draw of the scene, the index of its program, vertex array and material and its distance from the camera
+struct SceneDraw {
+    uint32_t program, vertexArray, material;
+    float depth;
+    bool transparent;
+};
+
+// Counts the program and vertex array switches of drawing the draws in the given order
+template<typename GetDraw>
+void countSwitches(size_t count, GetDraw getDraw, size_t& programSwitches, size_t& vertexArraySwitches) {
+    programSwitches = vertexArraySwitches = 0;
+    for(size_t i = 0; i < count; i++){
+        const SceneDraw& draw = getDraw(i);
+        if(i == 0 || draw.program != getDraw(i - 1).program) programSwitches++;
+        if(i == 0 || draw.vertexArray != getDraw(i - 1).vertexArray) vertexArraySwitches++;
+    }
+}
+
+int main(int, char**) {
+#ifndef NDEBUG
+    std::cout << "Warning: the benchmark is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    std::mt19937 random(42);
+
+    for(size_t count : {10000, 100000, 1000000}){
+        std::cout << "\n" << count << " draws (8 programs, 64 vertex arrays, 256 materials, 10% transparent)" << std::endl;
+
+        // The draws in the order a scene would visit them, with no relation to their state
+        std::vector<SceneDraw> scene(count);
+        std::uniform_real_distribution<float> depths(0.1f, 500.0f);
+        for(SceneDraw& draw : scene){
+            draw = {(uint32_t)(random() % 8), (uint32_t)(random() % 64), (uint32_t)(random() % 256), depths(random), random() % 10 == 0};
+        }
+
+        // The queue is created once, filling and sorting it every frame doesn't allocate
+        RenderQueue queue(count);
+        auto fill = [&]{
+            queue.clear();
+            for(size_t i = 0; i < count; i++){
+                const SceneDraw& draw = scene[i];
+                uint64_t key = draw.transparent ? RenderQueue::makeTransparentKey(draw.program, draw.vertexArray, draw.material, draw.depth)
+                                                : RenderQueue::makeOpaqueKey(draw.program, draw.vertexArray, draw.material, draw.depth);
+                // The draw index is stored in baseVertex so the order can be checked below
+                queue.push(key, {draw.program, draw.vertexArray, 0, 0, GL_UNSIGNED_SHORT, 6, 0, (GLint)i});
+            }
+        };
+        double fillTime = measure(fill);
+        double radixTime = measure([&]{ fill(); queue.sort(); }) - fillTime;
+        std::cout << "  push: " << fillTime << " ms, radix sort: " << radixTime << " ms" << std::endl;
+
+        // The same keys sorted by std::stable_sort, which must give the same order
+        std::vector<std::pair<uint64_t, uint32_t>> pairs(count);
+        fill();
+        for(size_t i = 0; i < count; i++) pairs[i] = {queue.getKey(i), (uint32_t)i};
+        std::vector<std::pair<uint64_t, uint32_t>> sortedPairs;
+        double stdTime = measure([&]{
+            sortedPairs = pairs;
+            std::stable_sort(sortedPairs.begin(), sortedPairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        });
+        queue.sort();
+        bool same = true;
+        for(size_t i = 0; i < count; i++) same = same && (uint32_t)queue.getCommand(i).baseVertex == sortedPairs[i].second;
+        std::cout << "  std::stable_sort: " << stdTime << " ms (" << stdTime / radixTime << "x slower, "
+                  << (same ? "same order" : "DIFFERENT ORDER") << ")" << std::endl;
+
+        size_t programSwitches, vertexArraySwitches, sortedProgramSwitches, sortedVertexArraySwitches;
+        countSwitches(count, [&](size_t i) -> const SceneDraw& { return scene[i]; }, programSwitches, vertexArraySwitches);
+        countSwitches(count, [&](size_t i) -> const SceneDraw& { return scene[queue.getCommand(i).baseVertex]; },
+                      sortedProgramSwitches, sortedVertexArraySwitches);
+        std::cout << "  program switches: " << programSwitches << " -> " << sortedProgramSwitches
+                  << ", vertex array switches: " << vertexArraySwitches << " -> " << sortedVertexArraySwitches << std::endl;
+    }
+    return 0;
+}
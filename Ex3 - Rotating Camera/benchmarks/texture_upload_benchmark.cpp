@@ -0,0 +1,104 @@
+// Compares sending a whole texture in 1 frame with glTexSubImage2D from CPU memory,
+// with streaming it from its smallest level through the ring of pixel buffers (source/texture.hpp)
+// For every method it prints the upload bandwidth and the longest time a frame is blocked by the uploads (the stall)
+// It needs an OpenGL context, so it opens a hidden window (configure with -DHEADLESS=ON on machines without a display)
+// Build it in Release mode, otherwise generating the mip levels is much slower than the uploads
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+#include "../source/texture.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int, char**) {
+#ifndef NDEBUG
+    std::cout << "Warning: the benchmark is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    if(!glfwInit()){
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Texture Upload Benchmark", nullptr, nullptr);
+    if(!window){
+        std::cerr << "Failed to create window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    gladLoadGL(glfwGetProcAddress);
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << ", "
+              << (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage ? "glTexStorage2D" : "glTexImage2D") << std::endl;
+
+    RenderState state;
+    const size_t BYTES_PER_FRAME = 1024 * 1024;
+
+    for(int size : {1024, 2048, 4096}){
+        std::vector<Image> mips = generateMipChain(createCheckerboardImage(size, 16));
+        int levels = (int)mips.size();
+        size_t bytes = 0;
+        for(const Image& mip : mips) bytes += mip.getSize();
+        double megabytes = bytes / (1024.0 * 1024.0);
+        std::cout << "\n" << size << "x" << size << " texture, " << levels << " levels, " << megabytes << " MB" << std::endl;
+
+        // 1. All the levels in 1 frame: glTexSubImage2D copies the pixels before it returns,
+        // and glFinish waits until the texture can be used, which is when it could be drawn
+        {
+            GLuint texture = createTextureStorage(state, size, size, levels);
+            Clock::time_point start = Clock::now();
+            for(int level = 0; level < levels; level++)
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mips[level].width, mips[level].height, GL_RGBA, GL_UNSIGNED_BYTE, mips[level].pixels.data());
+            double callTime = millisecondsSince(start);
+            glFinish();
+            double totalTime = millisecondsSince(start);
+            std::cout << "  1 frame:   " << megabytes / (totalTime / 1000.0) << " MB/s, the frame is blocked for " << callTime
+                      << " ms (" << totalTime << " ms until the GPU has it)" << std::endl;
+            glDeleteTextures(1, &texture);
+        }
+
+        // 2. Streamed: every frame sends at most BYTES_PER_FRAME bytes through the pixel buffers
+        // The frames are only the updates, a glFlush at the end of each sends the commands like a buffer swap would
+        {
+            GLuint texture = createTextureStorage(state, size, size, levels);
+            TextureUploader uploader;
+            uploader.create(std::max(BYTES_PER_FRAME, (size_t)size * 4));
+            TextureStreamer streamer;
+            streamer.add(texture, mips);
+            Clock::time_point start = Clock::now();
+            double worstFrame = 0;
+            int frames = 0, firstLevelFrames = 0, halfSizeFrames = 0;
+            while(!streamer.isDone()){
+                Clock::time_point frameStart = Clock::now();
+                streamer.update(state, uploader);
+                glFlush();
+                worstFrame = std::max(worstFrame, millisecondsSince(frameStart));
+                frames++;
+                int resident = streamer.getResidentLevel(texture);
+                if(firstLevelFrames == 0 && resident < levels) firstLevelFrames = frames;
+                if(halfSizeFrames == 0 && resident <= 1) halfSizeFrames = frames;
+            }
+            glFinish();
+            double totalTime = millisecondsSince(start);
+            const TextureUploader::Stats& stats = uploader.getStats();
+            std::cout << "  streamed:  " << megabytes / (totalTime / 1000.0) << " MB/s, the slowest frame is blocked for " << worstFrame
+                      << " ms, " << frames << " frames (first level after " << firstLevelFrames << ", level 1 after " << halfSizeFrames
+                      << "), waited for the GPU in " << stats.stalls << " frames" << std::endl;
+            uploader.destroy();
+            glDeleteTextures(1, &texture);
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
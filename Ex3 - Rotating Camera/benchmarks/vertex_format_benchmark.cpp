@@ -0,0 +1,104 @@
+// Compares the size and the precision of the vertex formats (source/vertex_format.hpp),
+// and how fast the vertices can be read from memory in every format
+// The GPU reads the vertices the same way, so smaller vertices mean more vertices per second when the GPU is limited by memory
+// To compare on the GPU, run Example5 with "--mesh big.obj --objects 100 --instanced --vertex-format snorm16" (or float, half)
+// Build it in Release mode, otherwise the compiler doesn't optimize the loops and the comparison is meaningless
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <glm/ext/scalar_constants.hpp>
+#include "../source/vertex_format.hpp"
+
+// Runs "function" enough times to take about 0.2 seconds, and returns the average time of 1 run in milliseconds
+template<typename Function>
+double measure(Function function) {
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do {
+        function();
+        runs++;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while(elapsed < 200.0);
+    return elapsed / runs;
+}
+
+int main(int, char**) {
+#ifndef NDEBUG
+    std::cout << "Warning: the benchmark is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    // A sphere of radius 10 made of 1000 x 1000 vertices, with normals and texture coordinates
+    const int side = 1000;
+    const size_t count = (size_t)side * side;
+    std::vector<Vertex> vertices(count);
+    std::vector<glm::vec3> normals(count);
+    std::vector<glm::vec2> uvs(count);
+    for(int y = 0; y < side; y++){
+        for(int x = 0; x < side; x++){
+            size_t i = (size_t)y * side + x;
+            float u = x / (side - 1.0f), v = y / (side - 1.0f);
+            float theta = u * 2 * glm::pi<float>(), phi = v * glm::pi<float>();
+            glm::vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            glm::vec3 position = 10.0f * normal;
+            vertices[i] = {position.x, position.y, position.z, (uint8_t)(255 * u), (uint8_t)(255 * v), 128, 255};
+            normals[i] = normal;
+            uvs[i] = glm::vec2(u, v);
+        }
+    }
+
+    struct Candidate {
+        const char* name;
+        VertexFormat format;
+    };
+    const Candidate candidates[] = {
+        {"float (all attributes)", {PositionFormat::Float32, NormalFormat::Float32, UVFormat::Float32}},
+        {"half + octahedral + half", {PositionFormat::Half, NormalFormat::Octahedral, UVFormat::Half}},
+        {"snorm16 + octahedral + half", {PositionFormat::Snorm16, NormalFormat::Octahedral, UVFormat::Half}},
+        {"snorm16 + 2_10_10_10 + half", {PositionFormat::Snorm16, NormalFormat::Int2_10_10_10, UVFormat::Half}},
+        {"float position + color (Vertex)", {PositionFormat::Float32, NormalFormat::None, UVFormat::None}},
+        {"snorm16 position + color", {PositionFormat::Snorm16, NormalFormat::None, UVFormat::None}},
+    };
+
+    std::cout << count << " vertices" << std::endl;
+    std::cout << std::left << std::setw(34) << "format" << std::right << std::setw(8) << "bytes" << std::setw(10) << "MB"
+              << std::setw(12) << "encode ms" << std::setw(10) << "read ms" << std::setw(10) << "GB/s"
+              << std::setw(14) << "position err" << std::setw(12) << "normal err" << std::setw(10) << "uv err" << std::endl;
+
+    uint64_t checksum = 0;
+    for(const Candidate& candidate : candidates){
+        EncodedVertices encoded;
+        double encodeTime = measure([&]{ encoded = encodeVertices(candidate.format, vertices.data(), count, normals.data(), uvs.data()); });
+
+        // Reads every 32-bit word of the buffer, which is what limits the GPU when it is bound by memory bandwidth
+        double readTime = measure([&]{
+            const uint32_t* words = (const uint32_t*)encoded.data.data();
+            size_t wordCount = encoded.data.size() / 4;
+            uint32_t sum = 0;
+            for(size_t i = 0; i < wordCount; i++) sum += words[i];
+            checksum += sum;
+        });
+
+        // The biggest error of the decoded attributes
+        float positionError = 0, normalError = 0, uvError = 0;
+        for(size_t i = 0; i < count; i += 7){
+            DecodedVertex decoded = decodeVertex(encoded, i);
+            positionError = std::max(positionError, glm::length(decoded.position - glm::vec3(vertices[i].x, vertices[i].y, vertices[i].z)));
+            if(candidate.format.normal != NormalFormat::None) normalError = std::max(normalError, glm::length(decoded.normal - normals[i]));
+            if(candidate.format.uv != UVFormat::None) uvError = std::max(uvError, glm::length(decoded.uv - uvs[i]));
+        }
+
+        std::cout << std::left << std::setw(34) << candidate.name << std::right << std::setw(8) << encoded.layout.stride
+                  << std::setw(10) << std::fixed << std::setprecision(1) << encoded.data.size() / (1024.0 * 1024.0)
+                  << std::setw(12) << std::setprecision(2) << encodeTime << std::setw(10) << readTime
+                  << std::setw(10) << encoded.data.size() / (readTime * 1e6)
+                  << std::setw(14) << std::scientific << std::setprecision(1) << positionError
+                  << std::setw(12) << normalError << std::setw(10) << uvError << std::defaultfloat << std::endl;
+    }
+    // Printed so the compiler can't remove the reads
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
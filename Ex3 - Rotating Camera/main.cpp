@@ -1,33 +1,479 @@
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
+#include "source/program_builder.hpp"
+#include "source/headless.hpp"
+#include "source/frame_stats.hpp"
+#include "source/profiler.hpp"
+#include "source/stream_buffer.hpp"
+#include "source/camera.hpp"
+#include "source/transform_system.hpp"
+#include "source/thread_pool.hpp"
+#include "source/frustum_culling.hpp"
+#include "source/mesh.hpp"
+#include "source/mesh_importer.hpp"
+#include "source/mesh_file.hpp"
+#include "source/mesh_optimizer.hpp"
+#include "source/mesh_builder.hpp"
+#include "source/render_state.hpp"
+#include "source/render_queue.hpp"
+#include "source/gpu_culling.hpp"
+#include "source/uniform_buffers.hpp"
+#include "source/command_list.hpp"
+#include "source/asset_streamer.hpp"
+#include "source/texture.hpp"
+#include "source/ktx_file.hpp"
+#include "source/block_compression.hpp"
+#include "source/texture_atlas.hpp"
+#include "source/frame_scheduler.hpp"
+#include "source/vertex_format.hpp"
+#include "source/software_rasterizer.hpp"
+#include <chrono>
 
 // GLM is a mathematics library.
 
-GLuint loadShader(const std::string& filePath, GLenum shaderType) {
-    GLuint shader = glCreateShader(shaderType);
+// Creates the positions of "count" squares arranged in a 3D grid centered at the origin
+// Each row of the grid is "spacing" units away from the next one
+// This is used to stress the renderer with thousands of squares instead of the 3 squares of the tutorial
+std::vector<glm::vec3> createObjectGrid(int count, float spacing) {
+    std::vector<glm::vec3> positions;
+    positions.reserve(count);
+    // The smallest cube that can hold "count" squares
+    int side = (int)std::ceil(std::cbrt((double)count));
+    float offset = (side - 1) * spacing * 0.5f;
+    for(int i = 0; i < count; i++){
+        int x = i % side;
+        int y = (i / side) % side;
+        int z = i / (side * side);
+        positions.push_back(glm::vec3(x * spacing - offset, y * spacing - offset, z * spacing - offset));
+    }
+    return positions;
+}
 
-    std::ifstream file(filePath);
-    std::string sourceCode = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-    const char* sourceCodeCStr = sourceCode.c_str();
+// The positions of the squares in the world
+// By default (objectCount = 0), these are the 3 squares of the tutorial translated to z = -1, 0 and 1
+// "cameraDistance" is set to the distance from the origin where the camera sees all of them
+std::vector<glm::vec3> createObjectPositions(int objectCount, float& cameraDistance) {
+    std::vector<glm::vec3> positions;
+    cameraDistance = 2;
+    if(objectCount > 0){
+        const float spacing = 1.5f;
+        positions = createObjectGrid(objectCount, spacing);
+        // Move the camera away so that the whole grid fits in the view
+        cameraDistance = std::max(2.0f, std::cbrt((float)objectCount) * spacing);
+    } else {
+        for(int z = -1; z <= 1; z++) positions.push_back(glm::vec3(0, 0, z));
+    }
+    return positions;
+}
 
-    glShaderSource(shader, 1, &sourceCodeCStr, nullptr);
-    glCompileShader(shader);
+// How fast the camera turns around the squares, in radians per second
+const double CAMERA_SPEED = 1.0;
 
-    return shader;
+// Returns a matrix that moves and scales a mesh with the bounding box (low, high) so that it is centered at the origin
+// and its biggest side is 1 unit long like the square, since meshes from other programs can have any size
+// The vertices aren't changed, so a mesh file can be sent to the GPU directly from the disk
+glm::mat4 getUnitSizeTransform(const glm::vec3& low, const glm::vec3& high) {
+    glm::vec3 size = high - low;
+    float scale = 1.0f / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+    return glm::scale(glm::mat4(1.0f), glm::vec3(scale)) * glm::translate(glm::mat4(1.0f), -(low + high) * 0.5f);
+}
+
+// Writes the 4 vertices and 6 indices of every square, already translated to its position in the world
+// Every square also moves up and down by time, as an example of geometry that changes every frame
+// The indices are 32-bit since there are more than 65536 vertices when there are more than 16384 squares
+void writeAnimatedSquares(Vertex* vertices, uint32_t* indices, const std::vector<glm::vec3>& positions, float time) {
+    const Vertex corners[] = {
+        {-0.5f, -0.5f, 0.0f,   0, 255, 255, 255},
+        { 0.5f, -0.5f, 0.0f, 255,   0, 255, 255},
+        { 0.5f,  0.5f, 0.0f, 255, 255,   0, 255},
+        {-0.5f,  0.5f, 0.0f, 255,   0,   0, 255}
+    };
+    for(size_t i = 0; i < positions.size(); i++){
+        glm::vec3 position = positions[i];
+        position.y += 0.25f * std::sin(2 * time + 0.1f * i);
+        for(int corner = 0; corner < 4; corner++){
+            Vertex vertex = corners[corner];
+            vertex.x += position.x;
+            vertex.y += position.y;
+            vertex.z += position.z;
+            vertices[4*i + corner] = vertex;
+        }
+        uint32_t first = (uint32_t)(4*i);
+        uint32_t* square = indices + 6*i;
+        square[0] = first; square[1] = first + 1; square[2] = first + 2;
+        square[3] = first + 2; square[4] = first + 3; square[5] = first;
+    }
 }
 
-struct Vertex {
-    float x, y, z;
-    uint8_t r, g, b, a;
+// The buffers of the mesh drawn for every square, and what is needed to draw it
+struct MeshBuffers {
+    GLuint vertexBuffer = 0, indexBuffer = 0;
+    std::vector<MeshCluster> clusters;
+    GLenum indexType = GL_UNSIGNED_BYTE;
+    glm::mat4 meshTransform = glm::mat4(1.0f);      // Moves and scales the mesh to the size of the square
+    glm::mat4 dequantization = glm::mat4(1.0f);     // Changes the encoded positions back (see source/vertex_format.hpp)
+    size_t bytes = 0;                               // The size of the 2 buffers
 };
 
-int main(int, char**) {
+// The mesh drawn for every square, in the memory of the CPU
+// A .mesh file is mapped and used directly, so "view" may point into "meshFile" instead of "mesh"
+struct LoadedMesh {
+    Mesh mesh;
+    MeshFile meshFile;
+    ClusteredMesh clusteredMesh;
+    MeshView view;
+    std::vector<MeshCluster> clusters;
+    glm::mat4 meshTransform = glm::mat4(1.0f);      // Moves and scales the mesh to the size of the square
+};
+
+// Reads the mesh at "meshPath" (or makes the square if the path is empty or the file can't be read),
+// and splits it into clusters if it is big
+// "threadPool" is used to import OBJ and PLY files, it can be null
+void loadMesh(const std::string& meshPath, bool optimize, ThreadPool* threadPool, LoadedMesh& loaded) {
+    // The mesh drawn for every square: the square itself, or a mesh from --mesh
+    // OBJ and PLY files are imported into "mesh", while .mesh files are mapped and used directly from "meshFile"
+    Mesh& mesh = loaded.mesh;
+    MeshFile& meshFile = loaded.meshFile;
+    MeshView& meshView = loaded.view;
+    glm::vec3 meshLow, meshHigh;
+    if(!meshPath.empty()){
+        if(meshPath.size() > 5 && meshPath.substr(meshPath.size() - 5) == ".mesh"){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(meshFile.open(meshPath)){
+                meshView = meshFile.getView();
+                meshLow = meshFile.getBoundsLow();
+                meshHigh = meshFile.getBoundsHigh();
+                std::cout << "Mapped " << meshPath << " (" << meshFile.getFileSize() / (1024.0 * 1024.0) << " MB) in "
+                          << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms: "
+                          << meshView.indexCount / 3 << " triangles, " << meshView.vertexCount << " vertices" << std::endl;
+            }
+        } else {
+            MeshImportStats importStats;
+            if(importMesh(meshPath, mesh, threadPool, &importStats)){
+                std::cout << "Imported " << meshPath << " (" << importStats.fileSize / (1024.0 * 1024.0) << " MB) in "
+                          << importStats.totalTime << " ms (parse " << importStats.parseTime << " ms, weld " << importStats.weldTime
+                          << " ms, " << importStats.threadCount << " threads): " << mesh.getTriangleCount() << " triangles, "
+                          << importStats.cornerCount << " corners welded into " << mesh.vertices.size() << " vertices" << std::endl;
+                // .mesh files made by MeshConverter are already optimized
+                if(optimize){
+                    MeshOptimizationReport report;
+                    optimizeMesh(mesh, &report);
+                    printMeshOptimizationReport(report);
+                }
+                meshView = mesh.getView();
+                computeMeshBounds(mesh.vertices.data(), mesh.vertices.size(), meshLow, meshHigh);
+            }
+        }
+        if(meshView.vertexCount > 0) loaded.meshTransform = getUnitSizeTransform(meshLow, meshHigh);
+    }
+    if(meshView.vertexCount == 0){
+        // Square coordinates in local space
+        mesh.vertices = {
+            {-0.5f, -0.5f, 0.0f,   0, 255, 255, 255},
+            { 0.5f, -0.5f, 0.0f, 255,   0, 255, 255},
+            { 0.5f,  0.5f, 0.0f, 255, 255,   0, 255},
+            {-0.5f,  0.5f, 0.0f, 255,   0,   0, 255}
+        };
+        mesh.setIndices({
+            0, 1, 2,
+            2, 3, 0
+        });
+        meshView = mesh.getView();
+    }
+
+    // A mesh with more than 65536 vertices would need 32-bit indices, so it is split into clusters with 16-bit indices instead
+    // The other meshes are drawn as 1 cluster (see source/mesh_builder.hpp)
+    if(meshView.indexType == GL_UNSIGNED_INT){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        loaded.clusteredMesh = buildClusteredMesh(meshView);
+        loaded.clusters = loaded.clusteredMesh.clusters;
+        std::cout << "Split the mesh into " << loaded.clusters.size() << " clusters with " << getIndexTypeBits(loaded.clusteredMesh.mesh.indexType)
+                  << "-bit indices in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                  << " ms (" << meshView.vertexCount << " -> " << loaded.clusteredMesh.mesh.vertices.size() << " vertices)" << std::endl;
+        meshView = loaded.clusteredMesh.mesh.getView();
+    } else {
+        loaded.clusters.push_back(makeWholeMeshCluster(meshView));
+    }
+}
+
+// Loads the mesh (see loadMesh) and sends its vertices and indices to the GPU in 2 new buffers
+// It only creates buffers, which are shared between contexts, so it can run on the asset streamer's thread (see source/asset_streamer.hpp)
+MeshBuffers loadMeshBuffers(const std::string& meshPath, bool optimize, const VertexFormat& vertexFormat, ThreadPool* threadPool) {
+    MeshBuffers buffers;
+    LoadedMesh loaded;
+    loadMesh(meshPath, optimize, threadPool, loaded);
+    const MeshView& meshView = loaded.view;
+    buffers.clusters = loaded.clusters;
+    buffers.indexType = meshView.indexType;
+    buffers.meshTransform = loaded.meshTransform;
+
+    // A buffer can be bound to any target to send its data, the index buffer is bound as GL_ELEMENT_ARRAY_BUFFER
+    // when it is attached to a vertex array (see attachMeshBuffers), since that binding is part of the vertex array
+    glGenBuffers(1, &buffers.vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+
+    // The float format is the Vertex struct itself, so the vertices are sent as they are
+    // For a .mesh file, they are sent from the mapped file, so they are copied only once: from the disk to the driver
+    // The other formats are encoded first, and their positions may need a dequantization matrix (see source/vertex_format.hpp)
+    if(vertexFormat.position == PositionFormat::Float32){
+        buffers.bytes += meshView.vertexCount*sizeof(Vertex);
+        glBufferData(GL_ARRAY_BUFFER, meshView.vertexCount*sizeof(Vertex), meshView.vertices, GL_STATIC_DRAW);
+    } else {
+        EncodedVertices encoded = encodeVertices(vertexFormat, meshView.vertices, meshView.vertexCount);
+        buffers.bytes += encoded.data.size();
+        glBufferData(GL_ARRAY_BUFFER, encoded.data.size(), encoded.data.data(), GL_STATIC_DRAW);
+        buffers.dequantization = encoded.dequantization;
+        std::cout << getPositionFormatName(vertexFormat.position) << " positions: " << encoded.layout.stride << " bytes per vertex instead of "
+                  << sizeof(Vertex) << " (" << encoded.data.size() / 1024.0 << " KB)" << std::endl;
+    }
+
+    // The indices are 8-bit (GL_UNSIGNED_BYTE) for up to 256 vertices, otherwise 16-bit (GL_UNSIGNED_SHORT)
+    // Only a .mesh file made from a big mesh has 32-bit indices (GL_UNSIGNED_INT), and it is split into clusters above
+    glGenBuffers(1, &buffers.indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.indexBuffer);
+    buffers.bytes += meshView.indexCount*meshView.getIndexSize();
+    glBufferData(GL_ARRAY_BUFFER, meshView.indexCount*meshView.getIndexSize(), meshView.indexData, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The GPU has its own copy now, so the mesh isn't needed anymore (it is freed when the function returns)
+    return buffers;
+}
+
+// Points the vertex attributes and the index buffer of the vertex array at the buffers of the mesh
+// Vertex arrays aren't shared between contexts, so this always runs on the main thread
+void attachMeshBuffers(GLuint vertexArray, const MeshBuffers& buffers, const VertexLayout& vertexLayout) {
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+    // The position is in location 0, and the color in location 1
+    // Calls glEnableVertexAttribArray and glVertexAttribPointer for every attribute of the format
+    setupVertexAttributes(vertexLayout);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+}
+
+// Draws the squares with the software rasterizer instead of OpenGL (see source/software_rasterizer.hpp), without a window
+// The squares, the camera and the clear color are the same as in the per-draw path, and the frame times are printed the same way,
+// so they can be compared with a --headless run, which uses llvmpipe (the software OpenGL driver) on machines without a GPU
+// The camera turns by exactly 1/60 s per frame, so 2 runs with the same options draw the same images
+void runSoftwareRenderer(int objectCount, const std::string& meshPath, bool optimize, bool staticCamera, int frameLimit) {
+    const int W = 800, H = 600;
+    ThreadPool threadPool;
+
+    // The rasterizer reads the vertices and the indices where they are, the mesh is never copied
+    LoadedMesh mesh;
+    loadMesh(meshPath, optimize, &threadPool, mesh);
+    const MeshView& meshView = mesh.view;
+    size_t indexSize = meshView.getIndexSize();
+
+    float cameraDistance;
+    std::vector<glm::vec3> positions = createObjectPositions(objectCount, cameraDistance);
+    std::vector<glm::mat4> models;
+    models.reserve(positions.size());
+    for(const glm::vec3& position : positions) models.push_back(glm::translate(glm::mat4(1.0f), position) * mesh.meshTransform);
+
+    Camera camera;
+    camera.setPerspective(glm::pi<float>()/2, W/float(H), 0.01f, 100.0f + cameraDistance);
+
+    SoftwareRasterizer rasterizer;
+    rasterizer.create(W, H, &threadPool);
+    FrameStats frameStats;
+    double setupTime = 0, rasterTime = 0;
+    for(int frame = 0; frame < frameLimit; frame++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double angle = staticCamera ? 0 : CAMERA_SPEED * frame / 60.0;
+        camera.lookAt(
+            glm::vec3(cameraDistance*glm::sin(angle), 1, cameraDistance*glm::cos(angle)),
+            glm::vec3(0, 0, 0),
+            glm::vec3(0, 1, 0)
+        );
+        const glm::mat4& VP = camera.getViewProjection();
+
+        rasterizer.clear(0.2f, 0.4f, 0.6f, 1.0f);
+        for(const glm::mat4& model : models){
+            glm::mat4 MVP = VP * model;
+            for(const MeshCluster& cluster : mesh.clusters)
+                rasterizer.drawIndexed(meshView.vertices, (const uint8_t*)meshView.indexData + cluster.firstIndex * indexSize,
+                                       meshView.indexType, cluster.indexCount, cluster.baseVertex, MVP);
+        }
+        rasterizer.flush();
+
+        frameStats.addFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        setupTime += rasterizer.getStats().setupTime;
+        rasterTime += rasterizer.getStats().rasterTime;
+    }
+    if(frameLimit <= 0) return;
+
+    frameStats.print("software, " + std::to_string(positions.size()) + " squares");
+    // The counts of the last frame
+    const SoftwareRasterizer::Stats& stats = rasterizer.getStats();
+    std::cout << "  rasterizer: " << stats.draws << " draws, " << stats.triangles << " triangles (" << stats.clipped << " clipped, "
+              << stats.culled << " culled), " << stats.binned << " triangles in " << SoftwareRasterizer::TILE_SIZE << "x"
+              << SoftwareRasterizer::TILE_SIZE << " tiles" << std::endl;
+    std::cout << "  average setup " << setupTime / frameLimit << " ms, raster " << rasterTime / frameLimit << " ms ("
+              << (getSimdLevel() != SimdLevel::Scalar ? "SSE2" : "scalar") << ", " << threadPool.getThreadCount() << " threads)" << std::endl;
+    // The checksum only changes if the image does, to check a change of the rasterizer didn't change its output
+    std::cout << "  image checksum of the last frame: " << std::hex << rasterizer.getChecksum() << std::dec << std::endl;
+    if(rasterizer.savePpm("software.ppm")) std::cout << "  saved the last frame to software.ppm" << std::endl;
+}
+
+// Reads the value of a command line option as a whole number between "low" and "high"
+// Returns false (and leaves "value" unchanged) for anything else, like "abc", "12abc", "-5" or a number too big for an int
+bool parseIntArgument(const char* text, int low, int high, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long number = std::strtol(text, &end, 10);
+    if(end == text || *end != '\0' || errno == ERANGE || number < low || number > high) return false;
+    value = (int)number;
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    // Command line options:
+    // --objects N : draw N squares arranged in a grid instead of the 3 squares of the tutorial
+    // --instanced : draw all the squares using 1 instanced draw call instead of 1 draw call per square
+    // --static-camera : stop rotating the camera, so nothing changes between frames and all the matrices are reused
+    // --stream METHOD : rewrite the vertices of all the squares every frame using METHOD: persistent, buffer-data or sub-data
+    // --headless : draw into an offscreen framebuffer instead of a visible window (see source/headless.hpp)
+    // --frames N : close after drawing N frames and print the frame time statistics
+    // --profile : measure the CPU and GPU time of every part of the frame and save them to trace.json on exit
+    // --swap MODE : wait for the vertical blank before showing a frame (vsync) or show it immediately (uncapped, the default)
+    // --frames-in-flight N : let the CPU prepare at most N frames ahead of the GPU (2 by default, 0 for no limit, see source/frame_scheduler.hpp)
+    // --cull : only draw the squares inside the camera's view (see source/frustum_culling.hpp)
+    // --mesh PATH : draw the mesh in an OBJ, PLY or .mesh file instead of the square (see source/mesh_importer.hpp and source/mesh_file.hpp)
+    // --optimize : reorder the triangles and vertices of an OBJ or PLY mesh for the GPU caches (see source/mesh_optimizer.hpp)
+    // --vertex-format FORMAT : store the vertex positions as float, half or snorm16 (see source/vertex_format.hpp)
+    // --gpu-driven : cull and draw all the squares on the GPU with a compute shader and 1 multi-draw indirect call (see source/gpu_culling.hpp)
+    // --queue : push the draws of the per-draw path into a render queue sorted by state and depth, drawn with the depth test (see source/render_queue.hpp)
+    // --parallel-record : prepare the draws of the per-draw path on all the CPU cores as command lists (see source/command_list.hpp)
+    // --texture SIZE : draw the squares of the per-draw path with a SIZExSIZE texture streamed from its smallest mip level (see source/texture.hpp)
+    // --texture-file PATH : like --texture, with the compressed levels of a .ktx file made by the TextureCompressor tool (see source/ktx_file.hpp)
+    // --atlas COUNT : draw the squares of the per-draw and instanced paths with COUNT different images packed into 1 texture array (see source/texture_atlas.hpp)
+    // --async-load : load the mesh of --mesh on another thread while drawing the square, then switch to it (see source/asset_streamer.hpp)
+    // --software : draw the squares on the CPU with the software rasterizer, without OpenGL or a window (see source/software_rasterizer.hpp)
+    // Try running with "--objects 1000", "--objects 10000" and "--objects 100000" with and without "--instanced"
+    // and compare the frame times printed in the console
+    int objectCount = 0;
+    bool instanced = false;
+    bool staticCamera = false;
+    std::string streamMethod;
+    bool headless = false;
+    int frameLimit = 0;
+    bool profile = false;
+    FrameScheduler::SwapMode swapMode = FrameScheduler::SwapMode::Uncapped;
+    int framesInFlight = 2;
+    bool cull = false;
+    std::string meshPath;
+    bool optimize = false;
+    VertexFormat vertexFormat;
+    bool useQueue = false;
+    bool gpuDriven = false;
+    bool parallelRecord = false;
+    bool asyncLoad = false;
+    int textureSize = 0;
+    std::string texturePath;
+    int atlasCount = 0;
+    bool software = false;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--objects" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, objectCount)){
+            i++;
+        } else if(arg == "--instanced"){
+            instanced = true;
+        } else if(arg == "--static-camera"){
+            staticCamera = true;
+        } else if(arg == "--stream" && i + 1 < argc){
+            streamMethod = argv[++i];
+            if(streamMethod != "persistent" && streamMethod != "buffer-data" && streamMethod != "sub-data"){
+                std::cerr << "Unknown stream method: " << streamMethod << std::endl;
+                streamMethod.clear();
+            }
+        } else if(arg == "--headless"){
+            headless = true;
+        } else if(arg == "--frames" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, frameLimit)){
+            i++;
+        } else if(arg == "--profile"){
+            profile = true;
+        } else if(arg == "--swap" && i + 1 < argc && FrameScheduler::parseSwapMode(argv[i + 1], swapMode)){
+            i++;
+        } else if(arg == "--frames-in-flight" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, framesInFlight)){
+            i++;
+        } else if(arg == "--cull"){
+            cull = true;
+        } else if(arg == "--mesh" && i + 1 < argc){
+            meshPath = argv[++i];
+        } else if(arg == "--optimize"){
+            optimize = true;
+        } else if(arg == "--vertex-format" && i + 1 < argc){
+            std::string name = argv[++i];
+            if(!parsePositionFormat(name, vertexFormat.position)) std::cerr << "Unknown vertex format: " << name << std::endl;
+        } else if(arg == "--gpu-driven"){
+            gpuDriven = true;
+        } else if(arg == "--queue"){
+            useQueue = true;
+        } else if(arg == "--parallel-record"){
+            parallelRecord = true;
+        } else if(arg == "--async-load"){
+            asyncLoad = true;
+        } else if(arg == "--texture" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, textureSize)){
+            i++;
+        } else if(arg == "--texture-file" && i + 1 < argc){
+            texturePath = argv[++i];
+        } else if(arg == "--atlas" && i + 1 < argc && parseIntArgument(argv[i + 1], 0, INT_MAX, atlasCount)){
+            i++;
+        } else if(arg == "--software"){
+            software = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+        }
+    }
+    // The software rasterizer only draws the squares (or the mesh) of the per-draw path, the other options need OpenGL
+    if(software){
+        runSoftwareRenderer(objectCount, meshPath, optimize, staticCamera, frameLimit > 0 ? frameLimit : 100);
+        return 0;
+    }
+    if(headless && frameLimit == 0) frameLimit = 1000;
+    bool streaming = !streamMethod.empty();
+    if(streaming) instanced = false;
+    // The streamed squares are all drawn by a single draw call, so there is nothing to cull
+    if(streaming) cull = false;
+    // The GPU-driven path draws the squares as instances, and culls them itself
+    // Without OpenGL 4.3, the CPU culls them instead
+    if(streaming) gpuDriven = false;
+    if(gpuDriven){
+        instanced = true;
+        cull = true;
+    }
+    // The queue sorts the draw calls of the per-draw path
+    if(streaming || instanced) useQueue = false;
+    // The command lists record the per-draw path too, in the order of the squares, so they replace the queue
+    if(streaming || instanced) parallelRecord = false;
+    if(parallelRecord) useQueue = false;
+    // The streamed squares don't use the mesh, and the GPU culler gets the clusters of the mesh only once
+    if(streaming || gpuDriven) asyncLoad = false;
+    // Only the program of the per-draw path has a textured version
+    if(streaming || instanced){
+        textureSize = 0;
+        texturePath.clear();
+    }
+    // The atlas replaces the streamed texture, and the streamed squares are drawn as 1 object
+    if(streaming) atlasCount = 0;
+    if(atlasCount > 0){
+        textureSize = 0;
+        texturePath.clear();
+    }
     
     if(!glfwInit()){
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -36,9 +482,24 @@ int main(int, char**) {
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    if(headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    // Compute shaders and multi-draw indirect need OpenGL 4.3
+    if(gpuDriven){
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    }
 
     const int W = 800, H = 600;
     GLFWwindow* window = glfwCreateWindow(W, H, "Example 1", nullptr, nullptr);
+    if(!window && gpuDriven){
+        std::cerr << "OpenGL 4.3 is not supported, falling back to OpenGL 3.3 with the CPU culling" << std::endl;
+        gpuDriven = false;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+        window = glfwCreateWindow(W, H, "Example 1", nullptr, nullptr);
+    }
     if(!window){
         std::cerr << "Failed to create window" << std::endl;
         glfwTerminate();
@@ -49,66 +510,467 @@ int main(int, char**) {
 
     gladLoadGL(glfwGetProcAddress);
 
-    GLuint program = glCreateProgram();
-    
-    GLuint vs = loadShader("assets/shaders/simple.vert", GL_VERTEX_SHADER);
-    glAttachShader(program, vs);
-    glDeleteShader(vs);
+    // The programs are built asynchronously (see source/program_builder.hpp)
+    // All of them start compiling at once, and the driver compiles them in parallel if it supports it
+    ProgramBuilder programBuilder;
+    int simpleBuild = programBuilder.build("simple", {"assets/shaders/simple.vert", "assets/shaders/simple.frag"});
+    int instancedBuild = programBuilder.build("instanced", {"assets/shaders/instanced.vert", "assets/shaders/simple.frag"});
+    int texturedBuild = textureSize > 0 || !texturePath.empty() ? programBuilder.build("textured", {"assets/shaders/textured.vert", "assets/shaders/textured.frag"}) : -1;
+    int atlasBuild = atlasCount > 0 ? programBuilder.build("atlas", {"assets/shaders/atlas.vert", "assets/shaders/atlas.frag"}) : -1;
+    int instancedAtlasBuild = atlasCount > 0 ? programBuilder.build("instanced atlas", {"assets/shaders/instanced_atlas.vert", "assets/shaders/atlas.frag"}) : -1;
 
-    GLuint fs = loadShader("assets/shaders/simple.frag", GL_FRAGMENT_SHADER);
-    glAttachShader(program, fs);
-    glDeleteShader(fs);
+    // Until a program is ready, the squares are drawn with a fallback program in a flat color
+    // The fallbacks have the same attributes and uniforms as the real programs, and since they are tiny we wait for them
+    // (In real scenes the expensive part of a program is usually the fragment shader)
+    int simpleFallbackBuild = programBuilder.build("simple fallback", {"assets/shaders/simple.vert", "assets/shaders/fallback.frag"});
+    int instancedFallbackBuild = programBuilder.build("instanced fallback", {"assets/shaders/instanced.vert", "assets/shaders/fallback.frag"});
+    programBuilder.wait(simpleFallbackBuild);
+    programBuilder.wait(instancedFallbackBuild);
+    GLuint simpleFallback = programBuilder.getProgram(simpleFallbackBuild);
+    GLuint instancedFallback = programBuilder.getProgram(instancedFallbackBuild);
 
-    glLinkProgram(program);
+    // The compute program of the GPU-driven path is needed before the first frame
+    GLuint cullProgram = 0;
+    if(gpuDriven && GpuCuller::isSupported()){
+        int cullBuild = programBuilder.build("cull", {"assets/shaders/cull.comp"});
+        programBuilder.wait(cullBuild);
+        cullProgram = programBuilder.getProgram(cullBuild);
+    }
+    if(gpuDriven && cullProgram == 0){
+        std::cerr << "GPU-driven culling is not available, falling back to the CPU culling" << std::endl;
+        gpuDriven = false;
+    }
+    if(gpuDriven) cull = false;
 
-    GLint mvpLoc = glGetUniformLocation(program, "MVP");
+    // Used by the mesh importer and the frustum culling to split their work between the CPU cores
+    ThreadPool threadPool;
 
+    // Draws the mesh from --mesh, or the square (see loadMeshBuffers)
+    // With --async-load, the square is drawn at first while the mesh is loaded on another thread, then the mesh replaces it
+    AssetStreamer streamer;
+    MeshBuffers meshBuffers, streamedMesh;
+    int meshJob = -1;
+    double loadStartTime = glfwGetTime();
+    if(asyncLoad && !meshPath.empty() && streamer.start(window)){
+        meshBuffers = loadMeshBuffers("", optimize, vertexFormat, nullptr);
+        // The thread pool is used by the frames while the mesh loads, so the importer uses 1 thread
+        meshJob = streamer.submit([&]() {
+            streamedMesh = loadMeshBuffers(meshPath, optimize, vertexFormat, nullptr);
+            return streamedMesh.bytes;
+        });
+    } else {
+        if(asyncLoad && !meshPath.empty()) std::cerr << "Failed to create the shared context, loading the mesh before the first frame" << std::endl;
+        asyncLoad = false;
+        meshBuffers = loadMeshBuffers(meshPath, optimize, vertexFormat, &threadPool);
+        if(!meshPath.empty())
+            std::cout << "Loaded and sent the mesh (" << meshBuffers.bytes / (1024.0 * 1024.0) << " MB) in "
+                      << 1000.0 * (glfwGetTime() - loadStartTime) << " ms before the first frame" << std::endl;
+    }
+    std::vector<MeshCluster> clusters = meshBuffers.clusters;
+    GLenum indexType = meshBuffers.indexType;
+    size_t indexSize = getIndexTypeSize(indexType);
+    glm::mat4 meshTransform = meshBuffers.meshTransform;
+    glm::mat4 dequantization = meshBuffers.dequantization;
+
+    VertexLayout vertexLayout = getVertexLayout(vertexFormat);
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    attachMeshBuffers(VAO, meshBuffers, vertexLayout);
 
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // The positions of the squares in the world (see createObjectPositions)
+    float cameraDistance;
+    std::vector<glm::vec3> positions = createObjectPositions(objectCount, cameraDistance);
 
-    // Square coordinates in local space
-    Vertex vertices[] = {
-        {-0.5f, -0.5f, 0.0f,   0, 255, 255, 255},
-        { 0.5f, -0.5f, 0.0f, 255,   0, 255, 255},
-        { 0.5f,  0.5f, 0.0f, 255, 255,   0, 255},
-        {-0.5f,  0.5f, 0.0f, 255,   0,   0, 255}
+    // Perspective matrix Changes from the camera space to homogenous clip space
+    // First Param: Field of view angle, when it decreases it seems where zooming in
+    // Second Param: aspect ratio of the window
+    // Third Param: the Near plane (The nearest distance I can't see before)
+    // Fourth Param: the Far plane (The farthest distance I can't see after)
+    
+    // If the aspect ratio is 1.0f then the square will be drawn as rectangle
+    // Why? Because where specifying the position in normalized coordinates
+    // When the normalized (1 to 1) will be transformed to viewport space (of a 800*600 window)
+    // the square will be stretched to a rectangle, 
+    // this is why we set the aspect ratio correct to maintain squares to still be squares
+
+    // The window size never changes, so the projection is computed once here instead of every frame
+    Camera camera;
+    camera.setPerspective(
+        glm::pi<float>()/2,
+        W/float(H),
+        0.01f,
+        100.0f + cameraDistance
+    );
+
+    // The model matrix of every square (see source/transform_system.hpp)
+    // In this tutorial, the model matrix only do translation to the square
+    // By default it translates the square in the z-axis only
+    // First square, z=-1, translates a square to 1 unit out the z direction
+    // Second square, z=0, No translation, the square is at original location
+    // Third square, z=1, translates a square to 1 unit in the z direction
+    // With --mesh, the mesh is first moved and scaled to the size of the square (meshTransform)
+    // With --vertex-format snorm16, the positions are first changed back from [-1, 1] to the mesh's bounding box (dequantization)
+    // The squares never move, so their world matrices are computed once and reused every frame
+    TransformSystem transforms;
+    transforms.reserve(positions.size());
+    for(const glm::vec3& position : positions)
+        transforms.add(glm::translate(glm::mat4(1.0f), position) * meshTransform * dequantization);
+    transforms.update(camera);
+
+    // Instanced Rendering
+    // ----------------
+    // Instead of sending the MVP of each square as a uniform then calling glDrawElements once per square,
+    // we store the model matrix of every square in a buffer, and send it to the shader as a vertex attribute.
+    // An attribute with a divisor of 1 advances once per instance (not once per vertex),
+    // so instance number i reads the model matrix number i from the buffer.
+    // Then all the squares are drawn with a single call to glDrawElementsInstanced.
+    GLuint instanceVBO = 0;
+    if(instanced){
+        // The squares don't move, so the model matrices are sent to the GPU only once
+        // The transform system keeps them next to each other in memory, so they are sent directly from it
+        glGenBuffers(1, &instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, transforms.size()*sizeof(glm::mat4), transforms.getWorldData(), GL_STATIC_DRAW);
+
+        // A mat4 attribute takes 4 locations (one per column), so the model matrix occupies locations 2, 3, 4 and 5
+        GLint modelLoc = 2;
+        for(int column = 0; column < 4; column++){
+            glEnableVertexAttribArray(modelLoc + column);
+            glVertexAttribPointer(modelLoc + column, 4, GL_FLOAT, false, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            // Second param: 1 means read a new value for every instance instead of every vertex
+            glVertexAttribDivisor(modelLoc + column, 1);
+        }
+    }
+
+    // Streaming Geometry
+    // ----------------
+    // With --stream, the vertices of all the squares are calculated on the CPU and sent to the GPU again every frame,
+    // as if the geometry was animated. The squares are already in world space, so their model matrix is the identity.
+    // Each frame needs 1 block of data: the vertices of all the squares, followed by their indices.
+    // There are 3 methods to send it, compare their frame times using --frames:
+    // "persistent": written directly into a persistently mapped buffer (see source/stream_buffer.hpp)
+    // "buffer-data": written into an array, then sent with glBufferData which gives the buffer new memory every frame
+    // "sub-data": written into an array, then copied into the same buffer memory with glBufferSubData
+    size_t streamVertexBytes = positions.size() * 4 * sizeof(Vertex);
+    size_t streamIndexBytes = positions.size() * 6 * sizeof(uint32_t);
+    // The block size is rounded up to a multiple of sizeof(Vertex), so that every region starts at a whole vertex
+    size_t streamBlockBytes = (streamVertexBytes + streamIndexBytes + sizeof(Vertex) - 1) / sizeof(Vertex) * sizeof(Vertex);
+    GLuint streamVAO = 0, streamVBO = 0;
+    StreamBuffer streamBuffer;
+    std::vector<char> streamStaging;
+    if(streaming){
+        if(streamMethod == "persistent" && streamBuffer.create(streamBlockBytes)){
+            streamVBO = streamBuffer.getBuffer();
+        } else {
+            if(streamMethod == "persistent"){
+                std::cerr << "Falling back to the buffer-data stream method" << std::endl;
+                streamMethod = "buffer-data";
+            }
+            streamStaging.resize(streamBlockBytes);
+            glGenBuffers(1, &streamVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+            glBufferData(GL_ARRAY_BUFFER, streamBlockBytes, nullptr, GL_STREAM_DRAW);
+        }
+
+        // The same buffer holds the vertices and the indices, so it is bound as both the array and the element buffer
+        glGenVertexArrays(1, &streamVAO);
+        glBindVertexArray(streamVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streamVBO);
+        // The streamed vertices are always Vertex structs
+        setupVertexAttributes(getVertexLayout(VertexFormat()));
+        glBindVertexArray(0);
+    }
+
+    // Frustum Culling
+    // ----------------
+    // With --cull, every frame the squares are tested against the camera's frustum and only the visible ones are drawn.
+    // Each square is bounded by a sphere at its center, with a radius that reaches its corners (half its diagonal),
+    // or the bounding sphere of every cluster of the mesh. The squares don't move, so the spheres are computed once.
+    // Every square and cluster is 1 item: item = square * clusterCount + cluster, so the clusters of a big mesh are culled one by one.
+    FrustumCuller culler(&threadPool);
+    BoundingSpheresSoA bounds;
+    std::vector<uint32_t> visible;
+    std::vector<glm::mat4> visibleModels;
+    size_t clusterCount = clusters.size();
+    // meshTransform scales all the axes by the same amount
+    float scale = glm::length(glm::vec3(meshTransform[0]));
+    // The world matrices include the dequantization, but the spheres are in the space of the mesh's vertices
+    glm::mat4 undoDequantization = glm::inverse(dequantization);
+    // With --async-load, the spheres are computed again when the mesh replaces the square
+    auto computeBounds = [&]() {
+        bounds.resize(transforms.size() * clusterCount);
+        for(size_t i = 0; i < transforms.size(); i++){
+            glm::mat4 world = transforms.getWorld((int)i) * undoDequantization;
+            for(size_t c = 0; c < clusterCount; c++){
+                size_t item = i * clusterCount + c;
+                glm::vec4 center = world * glm::vec4(clusters[c].center, 1.0f);
+                bounds.x[item] = center.x;
+                bounds.y[item] = center.y;
+                bounds.z[item] = center.z;
+                bounds.radius[item] = clusters[c].radius * scale;
+            }
+        }
+        visible.reserve(bounds.size());
     };
+    if(cull) computeBounds();
+
+    // With --gpu-driven, the model matrices in the instance buffer are also the SSBO read by the compute shader
+    GpuCuller gpuCuller;
+    if(gpuDriven){
+        gpuCuller.create(cullProgram, instanceVBO, transforms.size(), clusters, undoDequantization, scale);
+        std::cout << "GPU-driven culling of " << gpuCuller.getItemCount() << " clusters, drawn with "
+                  << (gpuCuller.usesDrawCount() ? "glMultiDrawElementsIndirectCount" : "glMultiDrawElementsIndirect") << std::endl;
+    }
+
+    std::string modeName = streaming ? "stream " + streamMethod : (gpuDriven ? "gpu-driven" : (instanced ? "instanced" : "per-draw"));
+    if(cull) modeName += " culled";
+    if(useQueue) modeName += " queued";
+    if(parallelRecord) modeName += " parallel-record";
+
+    // Holds every cluster of every square, so it never gets full
+    RenderQueue renderQueue(useQueue ? transforms.size() * clusterCount : 0);
 
-    glBufferData(GL_ARRAY_BUFFER, 4*sizeof(Vertex), vertices, GL_STATIC_DRAW);
+    // 1 command list for every chunk of draws, parallelFor never makes more than 4 chunks per thread
+    std::vector<CommandList> commandLists(parallelRecord ? threadPool.getThreadCount() * 4 : 0);
+    size_t commandListCount = 0;
+    double recordTime = 0;
 
-    GLint positionLoc = 0; 
-    glEnableVertexAttribArray(positionLoc);
-    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, false, sizeof(Vertex), (void*)0);
+    // The Frame block of every frame, and the Object blocks of the squares drawn 1 by 1 (see source/uniform_buffers.hpp)
+    // The streamed squares are drawn as 1 object, and the instanced squares don't need Object blocks
+    // With --parallel-record, the clusters of a square can be split between 2 lists, which both write its block,
+    // so every list can add 1 block
+    UniformBuffer uniformBuffer;
+    size_t objectBlockCount = streaming ? 1 : (instanced ? 0 : transforms.size() + commandLists.size());
+    uniformBuffer.create(uniformBuffer.getAlignedSize(sizeof(FrameUniforms)) + objectBlockCount * uniformBuffer.getAlignedSize(sizeof(ObjectUniforms)));
+    std::cout << "Uniform buffer: " << uniformBuffer.getCapacity() / 1024.0 << " KB, blocks aligned to "
+              << uniformBuffer.getAlignedSize(1) << " bytes" << std::endl;
+    // The offset of the Object block of every draw of the per-draw path
+    std::vector<size_t> drawOffsets(streaming || instanced ? 0 : transforms.size() * clusterCount);
+    GLuint blocksProgram = 0;
 
-    GLint colorLoc = 1; 
-    glEnableVertexAttribArray(colorLoc);
-    glVertexAttribPointer(colorLoc, 4, GL_UNSIGNED_BYTE, true, sizeof(Vertex), (void*)offsetof(Vertex, r));
+    OffscreenFramebuffer offscreen;
+    if(headless) offscreen = createOffscreenFramebuffer(W, H);
 
-    GLuint EBO;
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    // Used to print the average frame time every 2 seconds to compare the 2 drawing methods
+    double reportStartTime = glfwGetTime();
+    int reportFrames = 0;
 
-    uint16_t elements[] = {
-        0, 1, 2,
-        2, 3, 0
+    FrameStats frameStats;
+    double lastFrameTime = glfwGetTime();
+    // With --async-load, the slowest frame drawn while the mesh was loading, to check that loading doesn't stall the frames
+    double worstLoadingFrame = 0;
+
+    Profiler profiler;
+    if(profile) profiler.enable();
+
+    // Skips the state changes that don't change anything (see source/render_state.hpp)
+    RenderState state;
+
+    // With --texture, the texture is allocated with all its levels, then filled from the smallest level,
+    // at most TEXTURE_BYTES_PER_FRAME bytes every frame (see source/texture.hpp)
+    const size_t TEXTURE_BYTES_PER_FRAME = 1024 * 1024;
+    GLuint texture = 0;
+    TextureUploader textureUploader;
+    TextureStreamer textureStreamer;
+    int textureLevels = 0;
+    bool textureStreamed = false;
+    double textureStartTime = 0;
+    // With --texture-file, the levels are read from the file already compressed, and sent to the GPU as they are
+    std::vector<Image> textureMips;
+    std::chrono::steady_clock::time_point textureLoadStart = std::chrono::steady_clock::now();
+    if(!texturePath.empty() && loadKtxFile(texturePath, textureMips)){
+        if(isCompressedFormat(textureMips[0].format) && !GLAD_GL_EXT_texture_compression_s3tc){
+            // Without the extension the GPU can't read the blocks, so they are decoded on the CPU and sent in RGBA8
+            std::cout << "GL_EXT_texture_compression_s3tc isn't supported, decoding " << texturePath << " on the CPU" << std::endl;
+            for(Image& mip : textureMips) mip = decompressImage(mip);
+        }
+    } else if(textureSize > 0){
+        textureMips = generateMipChain(createCheckerboardImage(textureSize, 16));
+    }
+    if(!textureMips.empty()){
+        const Image& image = textureMips[0];
+        GLenum format = image.format;
+        textureLevels = (int)textureMips.size();
+        size_t textureBytes = 0;
+        for(const Image& mip : textureMips) textureBytes += mip.getSize();
+        texture = createTextureStorage(state, image.width, image.height, textureLevels, format);
+        textureUploader.create(std::max(TEXTURE_BYTES_PER_FRAME, image.getRowSize()));
+        std::cout << "Made a " << image.width << "x" << image.height << " " << getCompressedFormatName(format) << " texture with "
+                  << textureLevels << " levels (" << textureBytes / 1024.0 << " KB) in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - textureLoadStart).count() << " ms ("
+                  << (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage ? "glTexStorage2D" : "glTexImage2D") << ")" << std::endl;
+        textureStreamer.add(texture, std::move(textureMips));
+        textureStartTime = glfwGetTime();
+    }
+
+    // With --atlas, COUNT images are packed into the layers of 1 texture array, and square number i shows image number i % COUNT
+    // Every square gets the layer and the rectangle of its image: in its Object block for the per-draw path,
+    // and in a second instance buffer for the instanced path, so the texture array is the only texture bound for all the squares
+    struct AtlasInstance {
+        float uvRect[4];
+        float layer;
     };
+    std::vector<AtlasInstance> atlasInstances;
+    GLuint atlasTexture = 0;
+    GLuint atlasInstanceVBO = 0;
+    if(atlasCount > 0){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<Image> atlasImages;
+        for(int i = 0; i < atlasCount; i++){
+            // Different sizes (from 16 to 128 pixels), cells and tints, so the images look different
+            Image image = createCheckerboardImage(16 + (i * 53) % 113, 2 + i % 7);
+            const int tint[3] = {128 + (i * 97) % 128, 128 + (i * 59) % 128, 128 + (i * 31) % 128};
+            for(size_t p = 0; p < image.pixels.size(); p += 4)
+                for(int c = 0; c < 3; c++) image.pixels[p + c] = (uint8_t)(image.pixels[p + c] * tint[c] / 255);
+            atlasImages.push_back(std::move(image));
+        }
+        const int ATLAS_LAYER_SIZE = 1024, ATLAS_PADDING = 4;
+        TextureAtlas atlas;
+        if(buildTextureAtlas(atlasImages, ATLAS_LAYER_SIZE, ATLAS_PADDING, atlas)){
+            atlasTexture = createTextureArray(state, atlas);
+            for(size_t i = 0; i < positions.size(); i++){
+                const AtlasRegion& region = atlas.regions[i % atlas.regions.size()];
+                atlasInstances.push_back({{region.uvRect[0], region.uvRect[1], region.uvRect[2], region.uvRect[3]}, (float)region.layer});
+            }
+            std::cout << "Packed " << atlasCount << " images into " << atlas.layers.size() << " layers of " << ATLAS_LAYER_SIZE << "x" << ATLAS_LAYER_SIZE
+                      << " with " << atlas.levels << " levels in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms, " << 100.0f * atlas.occupancy << "% of the layers used, 1 texture bound for all the squares" << std::endl;
+        } else {
+            std::cerr << "The images don't fit in the layers of the atlas" << std::endl;
+        }
+    }
+    if(atlasTexture && instanced){
+        // The rectangles are read once per instance like the model matrices, from their own buffer
+        glGenBuffers(1, &atlasInstanceVBO);
+        state.bindVertexArray(VAO);
+        state.bindBuffer(GL_ARRAY_BUFFER, atlasInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, atlasInstances.size() * sizeof(AtlasInstance), atlasInstances.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(ATLAS_RECT_LOCATION);
+        glVertexAttribPointer(ATLAS_RECT_LOCATION, 4, GL_FLOAT, false, sizeof(AtlasInstance), (void*)offsetof(AtlasInstance, uvRect));
+        glVertexAttribDivisor(ATLAS_RECT_LOCATION, 1);
+        glEnableVertexAttribArray(ATLAS_LAYER_LOCATION);
+        glVertexAttribPointer(ATLAS_LAYER_LOCATION, 1, GL_FLOAT, false, sizeof(AtlasInstance), (void*)offsetof(AtlasInstance, layer));
+        glVertexAttribDivisor(ATLAS_LAYER_LOCATION, 1);
+    }
+    // The Object block of a square: its MVP, and the rectangle of its image (the whole texture without --atlas)
+    auto makeObjectUniforms = [&](const glm::mat4& MVP, size_t square){
+        ObjectUniforms object = {};
+        std::memcpy(object.MVP, &MVP, sizeof(object.MVP));
+        AtlasInstance region = square < atlasInstances.size() ? atlasInstances[square] : AtlasInstance{{0, 0, 1, 1}, 0};
+        std::memcpy(object.atlasRect, region.uvRect, sizeof(object.atlasRect));
+        object.atlasLayer = region.layer;
+        return object;
+    };
+    std::vector<AtlasInstance> visibleAtlasInstances;
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6*sizeof(uint16_t), elements, GL_STATIC_DRAW);
+    // The camera turns by CAMERA_SPEED radians per second in fixed steps of 1/60 s, and the frame draws it between the last 2 steps
+    // The time of the Frame block is simulated the same way (see source/frame_scheduler.hpp)
+    FrameScheduler scheduler;
+    scheduler.start(swapMode, framesInFlight);
+    double previousAngle = 0, simulationAngle = 0;
+    double previousTime = 0, simulationTime = 0;
 
-    while(!glfwWindowShouldClose(window)){
+    while(!glfwWindowShouldClose(window) && (frameLimit == 0 || (int)frameStats.getFrameCount() < frameLimit)){
         
-        glClearColor(0.2f, 0.4f, 0.6f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        profiler.beginFrame();
+        state.beginFrame();
+
+        // Waits for the GPU if too many frames are in flight, then reads the input, so the frame is made from the newest input
+        profiler.beginScope("wait for GPU");
+        scheduler.waitForFrameSlot();
+        profiler.endScope();
+
+        profiler.beginScope("poll events");
+        glfwPollEvents();
+        profiler.endScope();
+
+        int steps = scheduler.advance();
+        for(int step = 0; step < steps; step++){
+            previousAngle = simulationAngle;
+            previousTime = simulationTime;
+            if(!staticCamera) simulationAngle += CAMERA_SPEED * scheduler.getStepTime();
+            simulationTime += scheduler.getStepTime();
+        }
+        double alpha = scheduler.getAlpha();
+
+        // The whole state of the frame is set every frame, but only the first frame really sends it to OpenGL
+        profiler.beginScope("clear");
+        int framebufferWidth = W, framebufferHeight = H;
+        if(!headless) glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        state.viewport(0, 0, framebufferWidth, framebufferHeight);
+        // The queue draws the squares from near to far, so it needs the depth test to keep the near ones in front
+        // (and the depth test then skips the shading of the pixels that are already covered)
+        // The other paths draw in the order of the squares without it
+        state.setEnabled(GL_DEPTH_TEST, useQueue);
+        if(useQueue){
+            state.depthFunc(GL_LESS);
+            state.depthMask(true);
+        }
+        state.setEnabled(GL_BLEND, false);
+        state.setEnabled(GL_CULL_FACE, false);
+        state.clearColor(0.2f, 0.4f, 0.6f, 1.0f);
+        glClear(useQueue ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT);
+        profiler.endScope();
+
+        // Check if any program finished building
+        profiler.beginScope("poll programs");
+        programBuilder.poll();
+        profiler.endScope();
+
+        // With --async-load, switches from the square to the mesh once the fence of the streamer says its buffers are complete
+        // Everything that depends on the mesh is updated: the vertex array, the clusters, the model matrices and the culling spheres
+        bool loadingFrame = meshJob >= 0;
+        if(meshJob >= 0 && streamer.isReady(meshJob)){
+            profiler.beginScope("switch mesh");
+            glDeleteBuffers(1, &meshBuffers.vertexBuffer);
+            glDeleteBuffers(1, &meshBuffers.indexBuffer);
+            meshBuffers = std::move(streamedMesh);
+            attachMeshBuffers(VAO, meshBuffers, vertexLayout);
+            clusters = meshBuffers.clusters;
+            clusterCount = clusters.size();
+            indexType = meshBuffers.indexType;
+            indexSize = getIndexTypeSize(indexType);
+            meshTransform = meshBuffers.meshTransform;
+            dequantization = meshBuffers.dequantization;
+            scale = glm::length(glm::vec3(meshTransform[0]));
+            undoDequantization = glm::inverse(dequantization);
 
-        glBindVertexArray(VAO);
-        glUseProgram(program);
+            for(size_t i = 0; i < positions.size(); i++)
+                transforms.setLocal((int)i, glm::translate(glm::mat4(1.0f), positions[i]) * meshTransform * dequantization);
+            transforms.update(camera);
+            if(instanced){
+                glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+                glBufferData(GL_ARRAY_BUFFER, transforms.size()*sizeof(glm::mat4), transforms.getWorldData(), GL_STATIC_DRAW);
+            }
+            // The calls above changed the bindings without telling the state cache
+            state.invalidate();
+            if(cull) computeBounds();
+            if(!instanced) drawOffsets.resize(transforms.size() * clusterCount);
+            if(useQueue) renderQueue = RenderQueue(transforms.size() * clusterCount);
+
+            AssetStreamer::Stats stats = streamer.getStats();
+            std::cout << "Streamed the mesh (" << stats.bytes / (1024.0 * 1024.0) << " MB) in " << stats.uploadTime << " ms on the loading thread ("
+                      << stats.getThroughput() << " MB/s), drawn " << 1000.0 * (glfwGetTime() - loadStartTime) << " ms after the start of the loading, "
+                      << "slowest frame while loading: " << worstLoadingFrame << " ms" << std::endl;
+            meshJob = -1;
+            profiler.endScope();
+        }
+
+        state.bindVertexArray(streaming ? streamVAO : VAO);
+        // Use the real program if it is ready, otherwise use the fallback
+        // The uniform blocks of a program are attached to their binding points the first frame it is used
+        int drawBuild = texture ? texturedBuild : (atlasTexture ? atlasBuild : simpleBuild);
+        GLuint program = instanced ? programBuilder.getProgram(atlasTexture ? instancedAtlasBuild : instancedBuild, instancedFallback)
+                                   : programBuilder.getProgram(drawBuild >= 0 ? drawBuild : simpleBuild, simpleFallback);
+        if(program != blocksProgram){
+            bindUniformBlocks(program);
+            blocksProgram = program;
+        }
+        state.useProgram(program);
         
-        float angle = (float)glfwGetTime();
+        profiler.beginScope("camera");
+        float angle = (float)(previousAngle + (simulationAngle - previousAngle) * alpha);
 
         // Forming the View matrix
         // This matrix changes from the world space to the camera space
@@ -120,54 +982,215 @@ int main(int, char**) {
         // But the camera y is fixed
         // It looks at the origin, (remember the square coordinates we specified is centered at origin)
         // Thus the camera will be rotating around the y-axis.
-        glm::mat4 view = glm::lookAt(
-            glm::vec3(2*glm::sin(angle), 1, 2*glm::cos(angle)),
+        // The camera only recomputes the View-Projection matrix if the view changed
+        camera.lookAt(
+            glm::vec3(cameraDistance*glm::sin(angle), 1, cameraDistance*glm::cos(angle)),
             glm::vec3(0, 0, 0),
             glm::vec3(0, 1, 0)
         );
+        const glm::mat4& VP = camera.getViewProjection();
+        profiler.endScope();
 
-        // Perspective matrix Changes from the camera space to homogenous clip space
-        // First Param: Field of view angle, when it decreases it seems where zooming in
-        // Second Param: aspect ratio of the window
-        // Third Param: the Near plane (The nearest distance I can't see before)
-        // Fourth Param: the Far plane (The farthest distance I can't see after)
-        
-        // If the aspect ratio is 1.0f then the square will be drawn as rectangle
-        // Why? Because where specifying the position in normalized coordinates
-        // When the normalized (1 to 1) will be transformed to viewport space (of a 800*600 window)
-        // the square will be stretched to a rectangle, 
-        // this is why we set the aspect ratio correct to maintain squares to still be squares
-        
-        glm::mat4 projection = glm::perspective(
-            glm::pi<float>()/2,
-            W/float(H),
-            0.01f,
-            100.0f
-        );
+        if(cull){
+            profiler.beginScope("cull");
+            culler.cull(extractFrustum(VP), bounds, visible);
+            profiler.endScope();
+        }
+        if(gpuDriven){
+            // Only measures sending the work, the GPU time of the scope is the real culling time
+            profiler.beginScope("cull");
+            gpuCuller.cull(state, extractFrustum(VP));
+            profiler.endScope();
+        }
+
+        // Writes the uniform blocks of the frame, then sends all of them with 1 upload
+        // The Frame block has the camera and the time, it is bound once and read by every program
+        // Every square drawn by the per-draw path gets an Object block with its MVP, which its clusters share
+        profiler.beginScope("uniforms");
+        FrameUniforms frameUniforms;
+        std::memcpy(frameUniforms.view, &camera.getView(), sizeof(glm::mat4));
+        std::memcpy(frameUniforms.projection, &camera.getProjection(), sizeof(glm::mat4));
+        std::memcpy(frameUniforms.viewProjection, &VP, sizeof(glm::mat4));
+        frameUniforms.time = (float)(previousTime + (simulationTime - previousTime) * alpha);
+        uniformBuffer.beginFrame();
+        size_t frameOffset = uniformBuffer.write(&frameUniforms, sizeof(FrameUniforms));
+        size_t streamOffset = 0;
+        size_t drawCount = 0;
+        if(streaming){
+            // The streamed squares are already in world space, so their MVP is the View-Projection
+            ObjectUniforms object = makeObjectUniforms(VP, SIZE_MAX);
+            streamOffset = uniformBuffer.write(&object, sizeof(ObjectUniforms));
+        } else if(parallelRecord){
+            // Every chunk of draws is recorded into its own command list by a worker thread,
+            // which computes the MVPs of its squares and records their Object blocks and their draws
+            // The squares never move, so their world matrices are only read and the threads don't need to update them
+            std::chrono::steady_clock::time_point recordStart = std::chrono::steady_clock::now();
+            drawCount = cull ? visible.size() : transforms.size() * clusterCount;
+            const size_t MIN_DRAWS_PER_LIST = 256;
+            commandListCount = threadPool.getChunkCount(drawCount, MIN_DRAWS_PER_LIST);
+            threadPool.parallelFor(drawCount, MIN_DRAWS_PER_LIST, [&](size_t begin, size_t end, size_t chunk){
+                CommandList& list = commandLists[chunk];
+                list.reset();
+                list.bindProgram(program);
+                list.bindVertexArray(VAO);
+                size_t lastSquare = SIZE_MAX;
+                for(size_t d = begin; d < end; d++){
+                    size_t item = cull ? visible[d] : d;
+                    size_t square = item / clusterCount;
+                    if(square != lastSquare){
+                        ObjectUniforms object = makeObjectUniforms(VP * transforms.getWorld((int)square), square);
+                        list.uniformData(OBJECT_UNIFORMS_BINDING, &object, sizeof(ObjectUniforms));
+                        lastSquare = square;
+                    }
+                    const MeshCluster& cluster = clusters[item % clusterCount];
+                    list.drawIndexed(indexType, cluster.indexCount, cluster.firstIndex * indexSize, cluster.baseVertex);
+                }
+            });
+            recordTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+            // The Object blocks of all the lists are put in the uniform buffer in the order of the lists, before the upload
+            for(size_t l = 0; l < commandListCount; l++) commandLists[l].prepare(uniformBuffer);
+        } else if(!instanced){
+            // Recomputes only the matrices that changed: the world matrices of the squares that moved,
+            // and the MVPs of these squares (or of all the squares if the camera moved)
+            transforms.update(camera);
+
+            // 1 draw for every cluster of every square, or only for the visible ones with --cull
+            // The draws of a square are next to each other, so its block is written when its first draw is found
+            drawCount = cull ? visible.size() : transforms.size() * clusterCount;
+            size_t lastSquare = SIZE_MAX, offset = 0;
+            for(size_t d = 0; d < drawCount; d++){
+                size_t square = (cull ? visible[d] : d) / clusterCount;
+                if(square != lastSquare){
+                    ObjectUniforms object = makeObjectUniforms(transforms.getMVP((int)square), square);
+                    offset = uniformBuffer.write(&object, sizeof(ObjectUniforms));
+                }
+                lastSquare = square;
+                drawOffsets[d] = offset;
+            }
+        }
+        // The upload binds the buffer to GL_UNIFORM_BUFFER, so the state cache is told first
+        state.bindBuffer(GL_UNIFORM_BUFFER, uniformBuffer.getBuffer());
+        uniformBuffer.upload();
+        state.bindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, uniformBuffer.getBuffer(), frameOffset, sizeof(FrameUniforms));
+        profiler.endScope();
+
+        // Sends the next rows of the texture, the squares show the biggest level that is complete
+        if(atlasTexture) state.bindTexture(0, GL_TEXTURE_2D_ARRAY, atlasTexture);
+        if(texture){
+            profiler.beginScope("textures");
+            textureStreamer.update(state, textureUploader);
+            state.bindTexture(0, GL_TEXTURE_2D, texture);
+            profiler.endScope();
+            if(!textureStreamed && textureStreamer.isDone()){
+                textureStreamed = true;
+                const TextureUploader::Stats& stats = textureUploader.getStats();
+                double time = glfwGetTime() - textureStartTime;
+                std::cout << "Streamed all the " << textureLevels << " texture levels (" << stats.bytes / (1024.0 * 1024.0) << " MB) in "
+                          << 1000.0 * time << " ms (" << stats.bytes / (1024.0 * 1024.0) / time << " MB/s), "
+                          << stats.uploads << " uploads, waited for the GPU in " << stats.stalls << " frames (" << stats.stallTime << " ms)" << std::endl;
+            }
+        }
+
+        // Draws all the squares, the per-draw path includes binding the Object block of every square
+        profiler.beginScope("draw");
+
+        if(streaming){
+            state.bindBuffer(GL_ARRAY_BUFFER, streamVBO);
+
+            // With the persistent method, the data is written directly into the buffer at the offset of this frame's region
+            char* block = streamMethod == "persistent" ? (char*)streamBuffer.beginRegion() : streamStaging.data();
+            // The squares move with the simulated time of the Frame block, so they keep moving with --static-camera
+            writeAnimatedSquares((Vertex*)block, (uint32_t*)(block + streamVertexBytes), positions, frameUniforms.time);
+            size_t blockOffset = 0;
+            if(streamMethod == "persistent") blockOffset = streamBuffer.getRegionOffset();
+            else if(streamMethod == "buffer-data") glBufferData(GL_ARRAY_BUFFER, streamBlockBytes, block, GL_STREAM_DRAW);
+            else glBufferSubData(GL_ARRAY_BUFFER, 0, streamBlockBytes, block);
 
-        // Run 3 times To draw 3 squares
-        // this part isn't responsible for the rotation effect (the one responsible is the view matrix)
-        for(int z = -1; z <= 1; z++){
-            // In this tutorial, the model matrix only do translation to the square
-            // Translates the square in the z-axis only
-            
-            // First run, z=-1, translates a square to 1 unit out the z direction
-            // Second run, z=0, No translation, the square is at original location
-            // First run, z=1, translates a square to 1 unit in the z direction
-            
-            // Froming the matrix that will change from local space to homogenous clip space
-            glm::mat4 MVP = projection * view * glm::translate(
-                glm::mat4(1.0f),
-                glm::vec3(0, 0, z)
-            );
-
-            // First Param: Location of the uniform mvp matrix
-            // Second param: 1 matrix will be sent
-            // Third Param: transpose?
-            // Fourth PAram: float pointer to the data to be sent
-            glUniformMatrix4fv(mvpLoc, 1, false, (float*)&MVP);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (void*)0);
+            state.bindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UNIFORMS_BINDING, uniformBuffer.getBuffer(), streamOffset, sizeof(ObjectUniforms));
+            // The last param (base vertex) is added to every index, so the indices point to the vertices of this frame's region
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)(6 * positions.size()), GL_UNSIGNED_INT,
+                                     (void*)(blockOffset + streamVertexBytes), (GLint)(blockOffset / sizeof(Vertex)));
+
+            // The fence must come after the draw call that reads this region
+            if(streamMethod == "persistent") streamBuffer.endRegion();
+        } else if(gpuDriven){
+            // The compute program was used for the culling, so the program that draws is used again
+            // The whole scene is drawn by 1 call, and the CPU doesn't know how many squares are visible
+            state.useProgram(program);
+            gpuCuller.draw(state, indexType);
+        } else if(instanced){
+            GLsizei instanceCount = (GLsizei)positions.size();
+            if(cull){
+                // Only the model matrices of the visible squares are sent, so instance number i is the visible square number i
+                // All the clusters of a square are drawn if any of them is visible, since every cluster is drawn with the same instances
+                // The visible items are in increasing order, so the clusters of a square are next to each other
+                visibleModels.clear();
+                visibleAtlasInstances.clear();
+                size_t lastSquare = SIZE_MAX;
+                for(uint32_t item : visible){
+                    size_t square = item / clusterCount;
+                    if(square != lastSquare){
+                        visibleModels.push_back(transforms.getWorld((int)square));
+                        if(atlasInstanceVBO) visibleAtlasInstances.push_back(atlasInstances[square]);
+                    }
+                    lastSquare = square;
+                }
+                state.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+                // Calling glBufferData gives the buffer new memory, so we don't wait for the GPU to finish drawing the last frame
+                glBufferData(GL_ARRAY_BUFFER, visibleModels.size()*sizeof(glm::mat4), visibleModels.data(), GL_STREAM_DRAW);
+                // The rectangles of the visible squares, in the same order as their model matrices
+                if(atlasInstanceVBO){
+                    state.bindBuffer(GL_ARRAY_BUFFER, atlasInstanceVBO);
+                    glBufferData(GL_ARRAY_BUFFER, visibleAtlasInstances.size()*sizeof(AtlasInstance), visibleAtlasInstances.data(), GL_STREAM_DRAW);
+                }
+                instanceCount = (GLsizei)visibleModels.size();
+            }
+            // The model matrices are already in the instance buffer, and the View-Projection matrix is in the Frame block
+            // 5th param: the number of instances (squares) to draw, last param: the base vertex of the cluster
+            for(const MeshCluster& cluster : clusters){
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)cluster.indexCount, indexType, (void*)(cluster.firstIndex * indexSize),
+                                                  instanceCount, cluster.baseVertex);
+            }
+        } else if(parallelRecord){
+            // Replays the lists in the order of the chunks, so the squares are drawn in the same order as without the lists
+            for(size_t l = 0; l < commandListCount; l++) commandLists[l].execute(state);
+        } else {
+            if(useQueue) renderQueue.clear();
+
+            // Run once for every cluster of every square (3 times by default To draw 3 squares), or only for the visible ones with --cull
+            // this part isn't responsible for the rotation effect (the one responsible is the view matrix)
+            for(size_t d = 0; d < drawCount; d++){
+                size_t item = cull ? visible[d] : d;
+                int i = (int)(item / clusterCount);
+                const MeshCluster& cluster = clusters[item % clusterCount];
+
+                // With --queue, the draw is only recorded here, and the queue draws it after sorting
+                // There is 1 program and 1 vertex array, so the clusters are the materials, and the squares near the camera are drawn first
+                // (the depth test is enabled with --queue, so the order changes which pixels are shaded, not which ones are seen)
+                if(useQueue){
+                    float depth = glm::length(positions[i] - camera.getPosition());
+                    DrawCommand command = {program, VAO, uniformBuffer.getBuffer(), drawOffsets[d], indexType, (GLsizei)cluster.indexCount,
+                                           cluster.firstIndex * indexSize, cluster.baseVertex};
+                    renderQueue.push(RenderQueue::makeOpaqueKey(0, 0, (uint32_t)(item % clusterCount), depth), command);
+                    continue;
+                }
+
+                // Points the Object block at the MVP of this square (the matrix that changes from local space to homogenous clip space)
+                // First Param: the buffer holds uniform blocks
+                // Second param: the binding point of the Object block
+                // Third Param: the buffer with the blocks of this frame
+                // Fourth and Fifth Params: where the block of this square starts in the buffer and its size
+                // The state cache skips the call for the other clusters of the same square
+                state.bindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UNIFORMS_BINDING, uniformBuffer.getBuffer(), drawOffsets[d], sizeof(ObjectUniforms));
+                // Like glDrawElements, but adds the base vertex of the cluster to its indices
+                glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cluster.indexCount, indexType, (void*)(cluster.firstIndex * indexSize), cluster.baseVertex);
+            }
+            if(useQueue){
+                renderQueue.sort();
+                renderQueue.submit(state);
+            }
         }
+        profiler.endScope();
 
 
         // The Translation matrix
@@ -210,9 +1233,98 @@ int main(int, char**) {
         // matrix[0] is the left column of matrix.
         // matrix[2][1] is in the 3rd row, 2nd column.
         
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        profiler.beginScope("swap");
+        if(headless) glFinish();
+        else glfwSwapBuffers(window);
+        profiler.endScope();
+
+        scheduler.endFrame();
+
+        profiler.endFrame();
+
+        double now = glfwGetTime();
+        // The frame times are only printed when there is a frame limit (--frames or --headless)
+        // Without one the window can stay open for hours, so they aren't kept at all
+        if(frameLimit > 0) frameStats.addFrame(1000.0 * (now - lastFrameTime));
+        if(loadingFrame) worstLoadingFrame = std::max(worstLoadingFrame, 1000.0 * (now - lastFrameTime));
+        lastFrameTime = now;
+
+        reportFrames++;
+        if(now - reportStartTime >= 2.0){
+            std::cout << modeName << ", " << positions.size() << " squares: "
+                      << 1000.0 * (now - reportStartTime) / reportFrames << " ms/frame" << std::endl;
+            if(!streaming && !instanced && !parallelRecord){
+                // The counters of the last frame, to check how many matrices the transform system saved
+                const TransformSystem::Counters& counters = transforms.getCounters();
+                std::cout << "  world matrices: " << counters.worldRecomputed << " recomputed, " << counters.worldReused << " reused"
+                          << ", MVPs: " << counters.mvpRecomputed << " recomputed, " << counters.mvpReused << " reused" << std::endl;
+            }
+            if(cull){
+                // The counts of the last frame
+                const FrustumCuller::Counters& counters = culler.getCounters();
+                std::cout << "  frustum culling: " << counters.visible << " visible, " << counters.culled << " culled"
+                          << (clusterCount > 1 ? " clusters (" : " (")
+                          << getSimdLevelName(getSimdLevel()) << ", " << threadPool.getThreadCount() << " threads)" << std::endl;
+            }
+            if(gpuDriven){
+                // Waits for the GPU, which is fine once every 2 seconds
+                std::cout << "  GPU culling: " << gpuCuller.readVisibleCount(state) << " visible out of " << gpuCuller.getItemCount() << std::endl;
+            }
+            if(useQueue){
+                const RenderQueue::Counters& counters = renderQueue.getCounters();
+                std::cout << "  render queue: " << counters.draws << " draws sorted in " << counters.sortTime << " ms, "
+                          << counters.programSwitches << " program switches, " << counters.vertexArraySwitches << " vertex array switches" << std::endl;
+            }
+            if(parallelRecord){
+                size_t commands = 0, bytes = 0;
+                for(size_t l = 0; l < commandListCount; l++){
+                    commands += commandLists[l].getCounters().commands;
+                    bytes += commandLists[l].getSize();
+                }
+                std::cout << "  command lists: " << commandListCount << " lists, " << commands << " commands ("
+                          << bytes / 1024.0 << " KB) recorded in " << recordTime << " ms by " << threadPool.getThreadCount() << " threads" << std::endl;
+            }
+            // The counts of the last frame
+            const RenderState::Counters& stateCounters = state.getCounters();
+            std::cout << "  state changes: " << stateCounters.issued << " issued, " << stateCounters.skipped << " skipped" << std::endl;
+            reportStartTime = now;
+            reportFrames = 0;
+        }
+    }
+
+    if(frameLimit > 0){
+        frameStats.print(modeName + ", " + std::to_string(positions.size()) + " squares");
+        scheduler.printStats("Frame scheduler");
+    }
+    scheduler.destroy();
+    if(profile){
+        profiler.printSummary();
+        profiler.exportChromeTrace("trace.json");
+    }
+    profiler.destroy();
+    if(headless) destroyOffscreenFramebuffer(offscreen);
+
+    if(gpuDriven) gpuCuller.destroy();
+    uniformBuffer.destroy();
+    if(instanced) glDeleteBuffers(1, &instanceVBO);
+    if(streaming){
+        if(streamMethod == "persistent"){
+            std::cout << "The CPU waited for the GPU in " << streamBuffer.getStallCount() << " frames" << std::endl;
+            streamBuffer.destroy();
+        } else {
+            glDeleteBuffers(1, &streamVBO);
+        }
+        glDeleteVertexArrays(1, &streamVAO);
+    }
+    if(texture){
+        textureUploader.destroy();
+        glDeleteTextures(1, &texture);
     }
+    if(atlasTexture) glDeleteTextures(1, &atlasTexture);
+    if(atlasInstanceVBO) glDeleteBuffers(1, &atlasInstanceVBO);
+    // Waits for the loading thread if the mesh isn't loaded yet
+    streamer.stop();
+    programBuilder.destroy();
 
     glfwDestroyWindow(window);
     glfwTerminate();
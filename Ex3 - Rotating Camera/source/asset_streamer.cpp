@@ -0,0 +1,96 @@
+#include "asset_streamer.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+bool AssetStreamer::start(GLFWwindow* mainWindow) {
+    // The last param is the window whose objects are shared with the new context
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(1, 1, "Asset Streamer", nullptr, mainWindow);
+    if(!window) return false;
+    stopping = false;
+    worker = std::thread(&AssetStreamer::run, this);
+    return true;
+}
+
+int AssetStreamer::submit(Job job) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        queue.emplace_back(id, std::move(job));
+    }
+    wake.notify_one();
+    return id;
+}
+
+bool AssetStreamer::isReady(int job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A timeout of 0 only checks the fence, the worker already flushed it so it will be signaled without help from this context
+    for(size_t i = 0; i < finished.size();){
+        GLenum result = glClientWaitSync(finished[i].fence, 0, 0);
+        if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED){
+            glDeleteSync(finished[i].fence);
+            ready.push_back(finished[i].id);
+            finished.erase(finished.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    return std::find(ready.begin(), ready.end(), job) != ready.end();
+}
+
+bool AssetStreamer::isIdle() {
+    // isReady() updates the list of the ready jobs
+    isReady(-1);
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)ready.size() == nextId;
+}
+
+AssetStreamer::Stats AssetStreamer::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void AssetStreamer::stop() {
+    if(!window) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+    for(FinishedJob& job : finished) glDeleteSync(job.fence);
+    finished.clear();
+    glfwDestroyWindow(window);
+    window = nullptr;
+}
+
+void AssetStreamer::run() {
+    glfwMakeContextCurrent(window);
+    while(true){
+        std::pair<int, Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || !queue.empty(); });
+            if(queue.empty()) break;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t bytes = job.second();
+        // The fence is signaled when the GPU has executed all the commands of this context before it (the uploads)
+        // glFlush sends the commands now, otherwise the driver could keep them and the fence would never be signaled
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back({job.first, fence});
+        stats.jobs++;
+        stats.bytes += bytes;
+        stats.uploadTime += time;
+    }
+    glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+// Background Asset Streaming
+// ----------------
+// Reading a file and sending it to the GPU with glBufferData can take hundreds of milliseconds for a big mesh.
+// Done on the main thread, it delays the first frame, and done in the middle of the frame loop, it freezes the window.
+// An OpenGL context can only be used by 1 thread, but 2 contexts can share their objects (buffers, textures, programs, syncs,
+// but not vertex arrays or framebuffers, which only hold references to other objects).
+// So a second, hidden window is created whose context shares the objects of the main window's context,
+// and a worker thread makes it current and does all the loading and uploading there while the main thread keeps drawing.
+//
+// The main thread must not use a buffer before the GPU has really received its data: the worker puts a fence (glFenceSync)
+// after its uploads and flushes, and every frame the main thread checks the fence without waiting (glClientWaitSync with
+// a timeout of 0). Once it is signaled, the objects of the job are complete and the main thread can start drawing them.
+//
+// Usage:
+//      AssetStreamer streamer;
+//      streamer.start(window);
+//      int job = streamer.submit([&]() { ... glBufferData(...); return bytesUploaded; });
+//      while(...){
+//          if(streamer.isReady(job)) ... use the buffers ...
+//      }
+//      streamer.stop();
+class AssetStreamer {
+public:
+    // Runs on the worker thread with the upload context current, returns the number of bytes it sent to the GPU
+    using Job = std::function<size_t()>;
+
+    struct Stats {
+        size_t jobs = 0;           // The jobs that finished on the worker
+        size_t bytes = 0;          // Sent to the GPU by these jobs
+        double uploadTime = 0;     // The time the worker spent in these jobs (in milliseconds)
+        // In MB/s, including reading and preparing the data since a job does all of it
+        double getThroughput() const { return uploadTime > 0 ? bytes / (1024.0 * 1024.0) / (uploadTime / 1000.0) : 0; }
+    };
+
+    // Creates the hidden window sharing the objects of "mainWindow" and starts the worker thread
+    // Must be called on the main thread, since GLFW only creates windows there (the worker only makes the context current)
+    // The context is created with the window hints in effect, so call it right after creating the main window
+    // Returns false if the shared context can't be created
+    bool start(GLFWwindow* mainWindow);
+
+    // Queues a job for the worker and returns its id, the jobs run one after the other in the order they were submitted
+    int submit(Job job);
+
+    // Checks the fences of the finished jobs without waiting, and returns true once the job's objects can be used
+    bool isReady(int job);
+
+    // Returns true if all the submitted jobs are ready
+    bool isIdle();
+
+    Stats getStats();
+
+    // Waits for the queued jobs to finish, then stops the worker and destroys the hidden window
+    void stop();
+
+private:
+    struct FinishedJob {
+        int id;
+        GLsync fence;
+    };
+
+    void run();
+
+    GLFWwindow* window = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<int, Job>> queue;
+    std::vector<FinishedJob> finished;
+    std::vector<int> ready;
+    int nextId = 0;
+    bool stopping = false;
+    Stats stats;
+};
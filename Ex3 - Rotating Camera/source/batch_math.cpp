@@ -0,0 +1,193 @@
+#include "batch_math.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BATCH_MATH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC can use the AVX2 intrinsics in any function
+#define AVX2_FUNCTION
+#else
+// GCC and Clang need to know that this function may use AVX2 and FMA, even if the rest of the program doesn't
+#define AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+    // ---------------- Scalar ----------------
+
+    void multiplyMatricesScalar(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count) {
+        for(size_t i = 0; i < count; i++) out[i] = left * right[i];
+    }
+
+    void transformPointsScalar(const glm::mat4& m, const float* x, const float* y, const float* z,
+                               float* outX, float* outY, float* outZ, float* outW, size_t begin, size_t end) {
+        // m[column][row], since glm matrices are stored column by column
+        for(size_t i = begin; i < end; i++){
+            outX[i] = m[0][0] * x[i] + m[1][0] * y[i] + m[2][0] * z[i] + m[3][0];
+            outY[i] = m[0][1] * x[i] + m[1][1] * y[i] + m[2][1] * z[i] + m[3][1];
+            outZ[i] = m[0][2] * x[i] + m[1][2] * y[i] + m[2][2] * z[i] + m[3][2];
+            outW[i] = m[0][3] * x[i] + m[1][3] * y[i] + m[2][3] * z[i] + m[3][3];
+        }
+    }
+
+#ifdef BATCH_MATH_X86
+    // ---------------- SSE2 (4 floats per register) ----------------
+
+    void multiplyMatricesSSE2(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count) {
+        // Column j of (left * right) = sum over k of (column k of left) * right[j][k]
+        const float* l = &left[0][0];
+        __m128 l0 = _mm_loadu_ps(l), l1 = _mm_loadu_ps(l + 4), l2 = _mm_loadu_ps(l + 8), l3 = _mm_loadu_ps(l + 12);
+        for(size_t i = 0; i < count; i++){
+            const float* r = &right[i][0][0];
+            float* o = &out[i][0][0];
+            for(int j = 0; j < 4; j++){
+                __m128 column = _mm_mul_ps(l0, _mm_set1_ps(r[4*j]));
+                column = _mm_add_ps(column, _mm_mul_ps(l1, _mm_set1_ps(r[4*j + 1])));
+                column = _mm_add_ps(column, _mm_mul_ps(l2, _mm_set1_ps(r[4*j + 2])));
+                column = _mm_add_ps(column, _mm_mul_ps(l3, _mm_set1_ps(r[4*j + 3])));
+                _mm_storeu_ps(o + 4*j, column);
+            }
+        }
+    }
+
+    void transformPointsSSE2(const glm::mat4& m, const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, float* outW, size_t count) {
+        __m128 m00 = _mm_set1_ps(m[0][0]), m10 = _mm_set1_ps(m[1][0]), m20 = _mm_set1_ps(m[2][0]), m30 = _mm_set1_ps(m[3][0]);
+        __m128 m01 = _mm_set1_ps(m[0][1]), m11 = _mm_set1_ps(m[1][1]), m21 = _mm_set1_ps(m[2][1]), m31 = _mm_set1_ps(m[3][1]);
+        __m128 m02 = _mm_set1_ps(m[0][2]), m12 = _mm_set1_ps(m[1][2]), m22 = _mm_set1_ps(m[2][2]), m32 = _mm_set1_ps(m[3][2]);
+        __m128 m03 = _mm_set1_ps(m[0][3]), m13 = _mm_set1_ps(m[1][3]), m23 = _mm_set1_ps(m[2][3]), m33 = _mm_set1_ps(m[3][3]);
+        size_t i = 0;
+        // The arrays are 32-byte aligned, so aligned loads are used
+        for(; i + 4 <= count; i += 4){
+            __m128 px = _mm_load_ps(x + i), py = _mm_load_ps(y + i), pz = _mm_load_ps(z + i);
+            _mm_store_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, px), _mm_mul_ps(m10, py)), _mm_add_ps(_mm_mul_ps(m20, pz), m30)));
+            _mm_store_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, px), _mm_mul_ps(m11, py)), _mm_add_ps(_mm_mul_ps(m21, pz), m31)));
+            _mm_store_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, px), _mm_mul_ps(m12, py)), _mm_add_ps(_mm_mul_ps(m22, pz), m32)));
+            _mm_store_ps(outW + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m03, px), _mm_mul_ps(m13, py)), _mm_add_ps(_mm_mul_ps(m23, pz), m33)));
+        }
+        // The remaining points (less than 4)
+        transformPointsScalar(m, x, y, z, outX, outY, outZ, outW, i, count);
+    }
+
+    // ---------------- AVX2 (8 floats per register) ----------------
+
+    // Returns a register that holds the 4 floats at "data" twice
+    AVX2_FUNCTION
+    __m256 loadTwice(const float* data) {
+        __m128 half = _mm_loadu_ps(data);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(half), half, 1);
+    }
+
+    AVX2_FUNCTION
+    void multiplyMatricesAVX2(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count) {
+        // Every register holds 2 columns, so each column of left is repeated in both halves
+        const float* l = &left[0][0];
+        __m256 l0 = loadTwice(l), l1 = loadTwice(l + 4), l2 = loadTwice(l + 8), l3 = loadTwice(l + 12);
+        for(size_t i = 0; i < count; i++){
+            const float* r = &right[i][0][0];
+            float* o = &out[i][0][0];
+            for(int j = 0; j < 4; j += 2){
+                // Columns j and j+1 of right, _mm256_permute_ps repeats element k of each column in its half
+                __m256 columns = _mm256_loadu_ps(r + 4*j);
+                __m256 result = _mm256_mul_ps(l0, _mm256_permute_ps(columns, 0x00));
+                result = _mm256_fmadd_ps(l1, _mm256_permute_ps(columns, 0x55), result);
+                result = _mm256_fmadd_ps(l2, _mm256_permute_ps(columns, 0xAA), result);
+                result = _mm256_fmadd_ps(l3, _mm256_permute_ps(columns, 0xFF), result);
+                _mm256_storeu_ps(o + 4*j, result);
+            }
+        }
+    }
+
+    AVX2_FUNCTION
+    void transformPointsAVX2(const glm::mat4& m, const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, float* outW, size_t count) {
+        __m256 m00 = _mm256_set1_ps(m[0][0]), m10 = _mm256_set1_ps(m[1][0]), m20 = _mm256_set1_ps(m[2][0]), m30 = _mm256_set1_ps(m[3][0]);
+        __m256 m01 = _mm256_set1_ps(m[0][1]), m11 = _mm256_set1_ps(m[1][1]), m21 = _mm256_set1_ps(m[2][1]), m31 = _mm256_set1_ps(m[3][1]);
+        __m256 m02 = _mm256_set1_ps(m[0][2]), m12 = _mm256_set1_ps(m[1][2]), m22 = _mm256_set1_ps(m[2][2]), m32 = _mm256_set1_ps(m[3][2]);
+        __m256 m03 = _mm256_set1_ps(m[0][3]), m13 = _mm256_set1_ps(m[1][3]), m23 = _mm256_set1_ps(m[2][3]), m33 = _mm256_set1_ps(m[3][3]);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m256 px = _mm256_load_ps(x + i), py = _mm256_load_ps(y + i), pz = _mm256_load_ps(z + i);
+            _mm256_store_ps(outX + i, _mm256_fmadd_ps(m00, px, _mm256_fmadd_ps(m10, py, _mm256_fmadd_ps(m20, pz, m30))));
+            _mm256_store_ps(outY + i, _mm256_fmadd_ps(m01, px, _mm256_fmadd_ps(m11, py, _mm256_fmadd_ps(m21, pz, m31))));
+            _mm256_store_ps(outZ + i, _mm256_fmadd_ps(m02, px, _mm256_fmadd_ps(m12, py, _mm256_fmadd_ps(m22, pz, m32))));
+            _mm256_store_ps(outW + i, _mm256_fmadd_ps(m03, px, _mm256_fmadd_ps(m13, py, _mm256_fmadd_ps(m23, pz, m33))));
+        }
+        transformPointsScalar(m, x, y, z, outX, outY, outZ, outW, i, count);
+    }
+#endif
+
+    SimdLevel detectSimdLevel() {
+#ifdef BATCH_MATH_X86
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        // The operating system must also save the AVX registers when switching between threads
+        bool avxEnabled = osxsave && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        if(avx2 && fma && avxEnabled) return SimdLevel::AVX2;
+#else
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+#endif
+        // Every x86-64 CPU supports SSE2
+        return SimdLevel::SSE2;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    SimdLevel& currentSimdLevel() {
+        static SimdLevel level = getSupportedSimdLevel();
+        return level;
+    }
+}
+
+SimdLevel getSupportedSimdLevel() {
+    static SimdLevel supported = detectSimdLevel();
+    return supported;
+}
+
+SimdLevel getSimdLevel() {
+    return currentSimdLevel();
+}
+
+void setSimdLevel(SimdLevel level) {
+    currentSimdLevel() = (int)level <= (int)getSupportedSimdLevel() ? level : getSupportedSimdLevel();
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+    switch(level){
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE2: return "SSE2";
+        default: return "Scalar";
+    }
+}
+
+void multiplyMatrices(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count) {
+    switch(getSimdLevel()){
+#ifdef BATCH_MATH_X86
+        case SimdLevel::AVX2: multiplyMatricesAVX2(left, right, out, count); break;
+        case SimdLevel::SSE2: multiplyMatricesSSE2(left, right, out, count); break;
+#endif
+        default: multiplyMatricesScalar(left, right, out, count); break;
+    }
+}
+
+void transformPoints(const glm::mat4& matrix, const PointsSoA& in, PointsSoA& out) {
+    size_t count = in.size();
+    out.resize(count);
+    const float *x = in.x.data(), *y = in.y.data(), *z = in.z.data();
+    float *outX = out.x.data(), *outY = out.y.data(), *outZ = out.z.data(), *outW = out.w.data();
+    switch(getSimdLevel()){
+#ifdef BATCH_MATH_X86
+        case SimdLevel::AVX2: transformPointsAVX2(matrix, x, y, z, outX, outY, outZ, outW, count); break;
+        case SimdLevel::SSE2: transformPointsSSE2(matrix, x, y, z, outX, outY, outZ, outW, count); break;
+#endif
+        default: transformPointsScalar(matrix, x, y, z, outX, outY, outZ, outW, 0, count); break;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Batch Math
+// ----------------
+// Multiplying the matrices of the objects one by one (with glm::mat4 operator*) leaves most of the CPU's vector units unused.
+// These functions transform a whole array in 1 call, using SIMD instructions that work on 4 floats (SSE2) or 8 floats (AVX2) at once.
+// The best instruction set is picked at runtime according to the CPU, so the same executable runs on every x86 CPU.
+// On other CPUs (e.g. ARM), the scalar version is used.
+//
+// For points, the data is stored as a structure of arrays (SoA): all the x's, then all the y's, and so on,
+// so 8 points can be loaded into 1 AVX2 register per coordinate without shuffling.
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+// The best level the CPU supports
+SimdLevel getSupportedSimdLevel();
+
+// The level used by the batch functions, by default it is the best level the CPU supports
+SimdLevel getSimdLevel();
+// Forces a level (e.g. to compare them in a benchmark), it is clamped to the levels the CPU supports
+void setSimdLevel(SimdLevel level);
+
+const char* getSimdLevelName(SimdLevel level);
+
+// Allocates memory aligned to 32 bytes (the size of an AVX2 register), so the SIMD loads are always aligned
+template<typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static const size_t ALIGNMENT = 32;
+
+    AlignedAllocator() = default;
+    template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t count) { return (T*)::operator new(count * sizeof(T), std::align_val_t(ALIGNMENT)); }
+    void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(ALIGNMENT)); }
+
+    template<typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template<typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+using AlignedFloatVector = std::vector<float, AlignedAllocator<float>>;
+
+// An array of points stored as a structure of arrays
+struct PointsSoA {
+    AlignedFloatVector x, y, z, w;
+
+    void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); w.resize(count); }
+    size_t size() const { return x.size(); }
+};
+
+// out[i] = left * right[i] for every i
+// This is what the renderer needs every frame: MVP[i] = ViewProjection * Model[i]
+void multiplyMatrices(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count);
+
+// Transforms every point (x, y, z, 1) of "in" by "matrix" and writes the results (x, y, z, w) to "out"
+// The w's of "in" are ignored, "out" is resized to the size of "in"
+void transformPoints(const glm::mat4& matrix, const PointsSoA& in, PointsSoA& out);
@@ -0,0 +1,315 @@
+#include "block_compression.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    // The 16 pixels of a block, row by row
+    struct Block {
+        uint8_t pixels[16][4];
+    };
+
+    uint16_t packColor565(const float color[3]) {
+        int r = (int)std::lround(std::min(std::max(color[0], 0.0f), 255.0f) * 31 / 255.0f);
+        int g = (int)std::lround(std::min(std::max(color[1], 0.0f), 255.0f) * 63 / 255.0f);
+        int b = (int)std::lround(std::min(std::max(color[2], 0.0f), 255.0f) * 31 / 255.0f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    // The bits are repeated to fill the byte, so 31 becomes 255 and 0 stays 0
+    void unpackColor565(uint16_t packed, int color[3]) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // The 4 colors of a BC1 block in 4-color mode (c0 > c1), which is the only mode the encoder uses
+    void makeColorPalette(uint16_t c0, uint16_t c1, int palette[4][3]) {
+        unpackColor565(c0, palette[0]);
+        unpackColor565(c1, palette[1]);
+        for(int c = 0; c < 3; c++){
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // Chooses the nearest palette color for every pixel, returns the 32 bits of indices and the total squared error
+    uint32_t chooseColorIndices(const Block& block, uint16_t c0, uint16_t c1, int& error) {
+        int palette[4][3];
+        makeColorPalette(c0, c1, palette);
+        uint32_t indices = 0;
+        error = 0;
+        for(int i = 0; i < 16; i++){
+            int best = 0, bestDistance = INT32_MAX;
+            for(int p = 0; p < 4; p++){
+                int distance = 0;
+                for(int c = 0; c < 3; c++){
+                    int d = block.pixels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if(distance < bestDistance){
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+            error += bestDistance;
+        }
+        return indices;
+    }
+
+    // Least squares fit of the 2 endpoints for the chosen indices: every pixel is w * e0 + (1 - w) * e1,
+    // with w = 1, 0, 2/3 or 1/3 for the indices 0 to 3
+    bool fitEndpoints(const Block& block, uint32_t indices, float e0[3], float e1[3]) {
+        const float WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0, ab = 0, bb = 0, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+        for(int i = 0; i < 16; i++){
+            float a = WEIGHTS[(indices >> (2 * i)) & 3], b = 1 - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for(int c = 0; c < 3; c++){
+                ax[c] += a * block.pixels[i][c];
+                bx[c] += b * block.pixels[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f) return false;
+        for(int c = 0; c < 3; c++){
+            e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+        return true;
+    }
+
+    // c0 must be greater than c1 for the 4-color mode, swapping the endpoints swaps the indices 0 <-> 1 and 2 <-> 3
+    void writeColorBlock(uint16_t c0, uint16_t c1, uint32_t indices, uint8_t* out) {
+        if(c0 < c1){
+            std::swap(c0, c1);
+            indices ^= 0x55555555;
+        } else if(c0 == c1){
+            // All the pixels have the same color
+            indices = 0;
+        }
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    void encodeColorBlock(const Block& block, uint8_t* out) {
+        // The mean and the covariance of the colors
+        float mean[3] = {0, 0, 0};
+        for(int i = 0; i < 16; i++) for(int c = 0; c < 3; c++) mean[c] += block.pixels[i][c] / 16.0f;
+        float covariance[3][3] = {};
+        for(int i = 0; i < 16; i++){
+            float d[3];
+            for(int c = 0; c < 3; c++) d[c] = block.pixels[i][c] - mean[c];
+            for(int r = 0; r < 3; r++) for(int c = 0; c < 3; c++) covariance[r][c] += d[r] * d[c];
+        }
+
+        // The principal axis is the eigenvector of the biggest eigenvalue, found by multiplying a vector by the matrix a few times
+        float axis[3] = {1, 1, 1};
+        for(int iteration = 0; iteration < 8; iteration++){
+            float next[3];
+            for(int r = 0; r < 3; r++) next[r] = covariance[r][0] * axis[0] + covariance[r][1] * axis[1] + covariance[r][2] * axis[2];
+            float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if(length < 1e-6f) break;
+            for(int c = 0; c < 3; c++) axis[c] = next[c] / length;
+        }
+
+        // The endpoints are the extreme colors along the axis, moved inward by 1/16 of the line
+        // since the colors at the ends are rarely exactly on it
+        float low = 1e30f, high = -1e30f;
+        for(int i = 0; i < 16; i++){
+            float t = 0;
+            for(int c = 0; c < 3; c++) t += (block.pixels[i][c] - mean[c]) * axis[c];
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+        float inset = (high - low) / 16;
+        low += inset;
+        high -= inset;
+        float e0[3], e1[3];
+        for(int c = 0; c < 3; c++){
+            e0[c] = mean[c] + high * axis[c];
+            e1[c] = mean[c] + low * axis[c];
+        }
+
+        uint16_t c0 = packColor565(e0), c1 = packColor565(e1);
+        int error;
+        uint32_t indices = chooseColorIndices(block, c0, c1, error);
+
+        // 1 refinement: fit the endpoints to the chosen indices, keep them if the error is lower
+        if(error > 0 && fitEndpoints(block, indices, e0, e1)){
+            uint16_t refined0 = packColor565(e0), refined1 = packColor565(e1);
+            int refinedError;
+            uint32_t refinedIndices = chooseColorIndices(block, refined0, refined1, refinedError);
+            if(refinedError < error){
+                c0 = refined0;
+                c1 = refined1;
+                indices = refinedIndices;
+            }
+        }
+        writeColorBlock(c0, c1, indices, out);
+    }
+
+    // The 8 alpha values of a BC3 block when a0 > a1
+    void makeAlphaPalette(int a0, int a1, int palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if(a0 > a1){
+            for(int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        } else {
+            for(int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void encodeAlphaBlock(const Block& block, uint8_t* out) {
+        int a0 = 0, a1 = 255;
+        for(int i = 0; i < 16; i++){
+            a0 = std::max(a0, (int)block.pixels[i][3]);
+            a1 = std::min(a1, (int)block.pixels[i][3]);
+        }
+        int palette[8];
+        makeAlphaPalette(a0, a1, palette);
+        // The 16 indices of 3 bits are packed in 48 bits, the first pixel in the lowest bits
+        uint64_t indices = 0;
+        if(a0 > a1){
+            for(int i = 0; i < 16; i++){
+                int best = 0;
+                for(int p = 1; p < 8; p++)
+                    if(std::abs(block.pixels[i][3] - palette[p]) < std::abs(block.pixels[i][3] - palette[best])) best = p;
+                indices |= (uint64_t)best << (3 * i);
+            }
+        }
+        out[0] = (uint8_t)a0;
+        out[1] = (uint8_t)a1;
+        for(int b = 0; b < 6; b++) out[2 + b] = (uint8_t)(indices >> (8 * b));
+    }
+
+    void decodeColorBlock(const uint8_t* in, bool allowThreeColors, uint8_t pixels[16][4]) {
+        uint16_t c0, c1;
+        uint32_t indices;
+        std::memcpy(&c0, in, 2);
+        std::memcpy(&c1, in + 2, 2);
+        std::memcpy(&indices, in + 4, 4);
+        int palette[4][3];
+        makeColorPalette(c0, c1, palette);
+        bool transparentBlack = false;
+        if(allowThreeColors && c0 <= c1){
+            // The 3-color mode of BC1: the middle color and black (never written by the encoder, but valid in files from other tools)
+            for(int c = 0; c < 3; c++){
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            transparentBlack = true;
+        }
+        for(int i = 0; i < 16; i++){
+            int index = (indices >> (2 * i)) & 3;
+            for(int c = 0; c < 3; c++) pixels[i][c] = (uint8_t)palette[index][c];
+            pixels[i][3] = (transparentBlack && index == 3) ? 0 : 255;
+        }
+    }
+
+    void decodeAlphaBlock(const uint8_t* in, uint8_t pixels[16][4]) {
+        int palette[8];
+        makeAlphaPalette(in[0], in[1], palette);
+        uint64_t indices = 0;
+        for(int b = 0; b < 6; b++) indices |= (uint64_t)in[2 + b] << (8 * b);
+        for(int i = 0; i < 16; i++) pixels[i][3] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+bool parseCompressedFormat(const std::string& name, GLenum& format) {
+    if(name == "bc1") format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if(name == "bc3") format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else return false;
+    return true;
+}
+
+const char* getCompressedFormatName(GLenum format) {
+    switch(format){
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return "BC1";
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+        default: return "RGBA8";
+    }
+}
+
+Image compressImage(const Image& image, GLenum format, ThreadPool* threadPool) {
+    int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    size_t blockSize = getCompressedBlockSize(format);
+    Image result;
+    result.width = image.width;
+    result.height = image.height;
+    result.format = format;
+    result.pixels.resize((size_t)blocksX * blocksY * blockSize);
+
+    auto encodeRows = [&](size_t begin, size_t end){
+        for(size_t blockY = begin; blockY < end; blockY++){
+            for(int blockX = 0; blockX < blocksX; blockX++){
+                Block block;
+                for(int y = 0; y < 4; y++){
+                    for(int x = 0; x < 4; x++){
+                        int pixelX = std::min(blockX * 4 + x, image.width - 1), pixelY = std::min((int)blockY * 4 + y, image.height - 1);
+                        std::memcpy(block.pixels[4 * y + x], &image.pixels[((size_t)pixelY * image.width + pixelX) * 4], 4);
+                    }
+                }
+                uint8_t* out = &result.pixels[(blockY * blocksX + blockX) * blockSize];
+                // A BC3 block is the alpha block followed by a BC1 color block
+                if(format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT){
+                    encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+                encodeColorBlock(block, out);
+            }
+        }
+    };
+    if(threadPool) threadPool->parallelFor((size_t)blocksY, 4, [&](size_t begin, size_t end, size_t) { encodeRows(begin, end); });
+    else encodeRows(0, (size_t)blocksY);
+    return result;
+}
+
+Image decompressImage(const Image& image) {
+    int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    size_t blockSize = getCompressedBlockSize(image.format);
+    bool bc3 = image.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    Image result;
+    result.width = image.width;
+    result.height = image.height;
+    result.pixels.resize((size_t)image.width * image.height * 4);
+    for(int blockY = 0; blockY < blocksY; blockY++){
+        for(int blockX = 0; blockX < blocksX; blockX++){
+            const uint8_t* in = &image.pixels[((size_t)blockY * blocksX + blockX) * blockSize];
+            uint8_t pixels[16][4];
+            // The color block of BC3 always uses 4 colors
+            decodeColorBlock(bc3 ? in + 8 : in, !bc3, pixels);
+            if(bc3) decodeAlphaBlock(in, pixels);
+            for(int y = 0; y < 4; y++){
+                for(int x = 0; x < 4; x++){
+                    int pixelX = blockX * 4 + x, pixelY = blockY * 4 + y;
+                    if(pixelX < image.width && pixelY < image.height)
+                        std::memcpy(&result.pixels[((size_t)pixelY * image.width + pixelX) * 4], pixels[4 * y + x], 4);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+double computePsnr(const Image& original, const Image& decoded) {
+    double squaredError = 0;
+    size_t count = 0;
+    for(size_t i = 0; i < original.pixels.size(); i += 4){
+        for(int c = 0; c < 3; c++){
+            double d = (double)original.pixels[i + c] - decoded.pixels[i + c];
+            squaredError += d * d;
+        }
+        count += 3;
+    }
+    if(squaredError == 0) return INFINITY;
+    return 10 * std::log10(255.0 * 255.0 * count / squaredError);
+}
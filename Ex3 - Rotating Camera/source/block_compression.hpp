@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include "texture.hpp"
+#include "thread_pool.hpp"
+
+// Block Compression
+// ----------------
+// An RGBA8 texture takes 4 bytes per pixel in video memory, and every pixel the GPU reads costs memory bandwidth.
+// GPUs can read compressed textures directly: the image is cut into blocks of 4x4 pixels, and every block is stored in a fixed
+// number of bytes, so the GPU can find any block without decoding the others, and decodes it in the texture unit for free.
+// - BC1 (DXT1): 8 bytes per block (0.5 byte per pixel, 8 times smaller than RGBA8). It stores 2 colors in 16 bits (5 bits of red,
+//   6 of green, 5 of blue) and 2 more colors on the line between them (at 1/3 and 2/3), then 2 bits per pixel choose 1 of the 4.
+// - BC3 (DXT5): 16 bytes per block (4 times smaller). The colors are stored like BC1, and the alpha is stored separately:
+//   2 alpha values and 6 between them, then 3 bits per pixel choose 1 of the 8.
+// The quality depends on choosing the 2 endpoint colors well. The encoder puts the line through the colors of the block along
+// their main direction (the principal axis, found from their covariance), then fits the endpoints again with least squares
+// once every pixel has chosen its color.
+//
+// Encoding is slow compared to decoding, so it is done once, offline (see tools/texture_compressor.cpp),
+// and the blocks of a level are split between the threads of the pool.
+
+// Parses "bc1" or "bc3" into GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, returns false if the name is unknown
+bool parseCompressedFormat(const std::string& name, GLenum& format);
+const char* getCompressedFormatName(GLenum format);
+
+// Compresses an RGBA8 image into blocks of "format", the blocks on the right and top edges repeat the last pixels
+// BC1 ignores the alpha
+Image compressImage(const Image& image, GLenum format, ThreadPool* threadPool = nullptr);
+
+// Decodes the blocks of a compressed image back to RGBA8 pixels, like the GPU would
+Image decompressImage(const Image& image);
+
+// The peak signal to noise ratio of the red, green and blue channels, in decibels: higher is closer, above 35 dB the difference is hard to see
+double computePsnr(const Image& original, const Image& decoded);
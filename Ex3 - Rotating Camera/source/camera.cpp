@@ -0,0 +1,27 @@
+#include "camera.hpp"
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+
+void Camera::setPerspective(float fovy, float aspectRatio, float near, float far) {
+    projection = glm::perspective(fovy, aspectRatio, near, far);
+    dirty = true;
+}
+
+void Camera::lookAt(const glm::vec3& newEye, const glm::vec3& newCenter, const glm::vec3& newUp) {
+    if(!dirty && newEye == eye && newCenter == center && newUp == up) return;
+    eye = newEye;
+    center = newCenter;
+    up = newUp;
+    view = glm::lookAt(eye, center, up);
+    dirty = true;
+}
+
+const glm::mat4& Camera::getViewProjection() {
+    if(dirty){
+        viewProjection = projection * view;
+        dirty = false;
+        version++;
+    }
+    return viewProjection;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Keeps the View and Projection matrices of the camera, and their product (View-Projection)
+// The matrices are only recomputed when something changes, not every frame
+// Every time the View-Projection changes, the version increases, so other code can know it must update what depends on it
+class Camera {
+public:
+    // Same params as glm::perspective
+    void setPerspective(float fovy, float aspectRatio, float near, float far);
+
+    // Same params as glm::lookAt, nothing is recomputed if they are the same as the last call
+    void lookAt(const glm::vec3& eye, const glm::vec3& center, const glm::vec3& up);
+
+    // Recomputes the View-Projection matrix if the view or the projection changed
+    const glm::mat4& getViewProjection();
+
+    const glm::mat4& getView() const { return view; }
+    const glm::mat4& getProjection() const { return projection; }
+    const glm::vec3& getPosition() const { return eye; }
+
+    // Increases by 1 every time the View-Projection matrix is recomputed
+    uint64_t getVersion() const { return version; }
+
+private:
+    glm::mat4 view = glm::mat4(1.0f), projection = glm::mat4(1.0f), viewProjection = glm::mat4(1.0f);
+    glm::vec3 eye = glm::vec3(0), center = glm::vec3(0, 0, -1), up = glm::vec3(0, 1, 0);
+    bool dirty = true;
+    uint64_t version = 0;
+};
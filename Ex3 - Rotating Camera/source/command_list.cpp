@@ -0,0 +1,136 @@
+#include "command_list.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <glad/gl.h>
+
+namespace {
+    enum CommandType : uint32_t { BIND_PROGRAM, BIND_VERTEX_ARRAY, UNIFORM_DATA, DRAW_INDEXED };
+
+    // Every command starts with a header, "size" is the size of the whole command (with its data) in bytes,
+    // so the commands are read by jumping from header to header
+    struct Header {
+        uint32_t type;
+        uint32_t size;
+    };
+
+    struct BindCommand {
+        Header header;
+        uint32_t name;
+        uint32_t padding;
+    };
+
+    // The data follows the command, "buffer" and "offset" are filled by prepare()
+    struct UniformDataCommand {
+        Header header;
+        uint32_t binding;
+        uint32_t size;
+        uint32_t buffer;
+        uint32_t padding;
+        uint64_t offset;
+    };
+
+    struct DrawIndexedCommand {
+        Header header;
+        uint32_t indexType;
+        uint32_t indexCount;
+        uint64_t indexOffset;
+        int32_t baseVertex;
+        uint32_t instanceCount;
+    };
+
+    uint32_t alignTo8(size_t size) { return (uint32_t)((size + 7) / 8 * 8); }
+}
+
+void CommandList::reset() {
+    used = 0;
+    commandCount = 0;
+}
+
+uint8_t* CommandList::allocate(uint32_t type, uint32_t size) {
+    // Grows by doubling, the memory is kept by reset() so the next frames don't grow it again
+    if(used + size > data.size()) data.resize(std::max(data.size() * 2, used + size));
+    uint8_t* command = data.data() + used;
+    Header header = {type, size};
+    std::memcpy(command, &header, sizeof(Header));
+    used += size;
+    commandCount++;
+    return command;
+}
+
+void CommandList::bindProgram(uint32_t program) {
+    BindCommand* command = (BindCommand*)allocate(BIND_PROGRAM, sizeof(BindCommand));
+    command->name = program;
+}
+
+void CommandList::bindVertexArray(uint32_t vertexArray) {
+    BindCommand* command = (BindCommand*)allocate(BIND_VERTEX_ARRAY, sizeof(BindCommand));
+    command->name = vertexArray;
+}
+
+void CommandList::uniformData(uint32_t binding, const void* block, uint32_t size) {
+    uint8_t* memory = allocate(UNIFORM_DATA, alignTo8(sizeof(UniformDataCommand) + size));
+    UniformDataCommand* command = (UniformDataCommand*)memory;
+    command->binding = binding;
+    command->size = size;
+    command->buffer = 0;
+    command->offset = 0;
+    std::memcpy(memory + sizeof(UniformDataCommand), block, size);
+}
+
+void CommandList::drawIndexed(uint32_t indexType, uint32_t indexCount, uint64_t indexOffset, int32_t baseVertex, uint32_t instanceCount) {
+    DrawIndexedCommand* command = (DrawIndexedCommand*)allocate(DRAW_INDEXED, sizeof(DrawIndexedCommand));
+    command->indexType = indexType;
+    command->indexCount = indexCount;
+    command->indexOffset = indexOffset;
+    command->baseVertex = baseVertex;
+    command->instanceCount = instanceCount;
+}
+
+void CommandList::prepare(UniformBuffer& uniforms) {
+    for(size_t position = 0; position < used;){
+        Header* header = (Header*)(data.data() + position);
+        if(header->type == UNIFORM_DATA){
+            UniformDataCommand* command = (UniformDataCommand*)header;
+            // write() grows the buffer when it is full instead of failing, so the offset is always the block's own
+            // The buffer keeps its name when it grows, so it can be stored before the write
+            command->buffer = uniforms.getBuffer();
+            command->offset = uniforms.write((uint8_t*)command + sizeof(UniformDataCommand), command->size);
+        }
+        position += header->size;
+    }
+}
+
+void CommandList::execute(RenderState& state) {
+    counters = Counters();
+    for(size_t position = 0; position < used;){
+        const Header* header = (const Header*)(data.data() + position);
+        switch(header->type){
+            case BIND_PROGRAM:
+                state.useProgram(((const BindCommand*)header)->name);
+                break;
+            case BIND_VERTEX_ARRAY:
+                state.bindVertexArray(((const BindCommand*)header)->name);
+                break;
+            case UNIFORM_DATA: {
+                const UniformDataCommand* command = (const UniformDataCommand*)header;
+                state.bindBufferRange(GL_UNIFORM_BUFFER, command->binding, command->buffer, (GLintptr)command->offset, command->size);
+                break;
+            }
+            case DRAW_INDEXED: {
+                const DrawIndexedCommand* command = (const DrawIndexedCommand*)header;
+                if(command->instanceCount == 1){
+                    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)command->indexCount, command->indexType,
+                                             (void*)command->indexOffset, command->baseVertex);
+                } else {
+                    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)command->indexCount, command->indexType,
+                                                      (void*)command->indexOffset, (GLsizei)command->instanceCount, command->baseVertex);
+                }
+                counters.draws++;
+                break;
+            }
+        }
+        counters.commands++;
+        position += header->size;
+    }
+}
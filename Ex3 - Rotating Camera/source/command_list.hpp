@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "render_state.hpp"
+#include "uniform_buffers.hpp"
+
+// Command Lists
+// ----------------
+// Only the thread that owns the OpenGL context can call OpenGL, so with 1 draw call per object all the work of preparing
+// the draws (computing the matrices, choosing the state) usually happens on that thread too, and it uses 1 CPU core.
+// A command list separates recording the draws from sending them:
+// - Any thread can record commands (bind a program, bind a vertex array, set the uniform data of a block, draw) into a list.
+//   Recording only copies small structs one after the other into the list's memory, it never calls OpenGL,
+//   so every worker thread records its own part of the frame into its own list at the same time as the others.
+// - Then the OpenGL thread replays the lists in order, which only has to read the commands and make the calls.
+//
+// The commands store the names of the objects as plain integers, so nothing in a list depends on OpenGL
+// (another API could replay the same lists).
+// The uniform data is copied into the list, since the uniform buffer can only be written by 1 thread.
+// Replaying is done in 2 passes:
+// 1. prepare() copies the uniform data of the list into the uniform buffer and remembers where it went,
+//    so the data of all the lists is sent with the single upload of the frame.
+// 2. execute() makes the calls, binding the blocks written by prepare().
+//
+// The memory of a list is kept between frames, so after the first frames recording never allocates.
+
+class CommandList {
+public:
+    struct Counters {
+        size_t commands = 0;
+        size_t draws = 0;
+    };
+
+    // Empties the list, call it before recording a new frame
+    void reset();
+
+    void bindProgram(uint32_t program);
+    void bindVertexArray(uint32_t vertexArray);
+    // Copies "size" bytes of data for the uniform block at "binding", the block is bound for the draws recorded after it
+    void uniformData(uint32_t binding, const void* data, uint32_t size);
+    // Draws triangles, "indexType" is GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT and "indexOffset" is in bytes
+    void drawIndexed(uint32_t indexType, uint32_t indexCount, uint64_t indexOffset, int32_t baseVertex, uint32_t instanceCount = 1);
+
+    // Pass 1 on the OpenGL thread: writes the uniform data of the list into "uniforms" (before its upload)
+    void prepare(UniformBuffer& uniforms);
+    // Pass 2 on the OpenGL thread: makes the OpenGL calls of the list in the order they were recorded
+    void execute(RenderState& state);
+
+    // The bytes used by the commands recorded since reset()
+    size_t getSize() const { return used; }
+    size_t getCommandCount() const { return commandCount; }
+    // The counts of the last execute()
+    const Counters& getCounters() const { return counters; }
+
+private:
+    // Returns the memory of a new command of "size" bytes (a multiple of 8, so the next command stays aligned)
+    uint8_t* allocate(uint32_t type, uint32_t size);
+
+    std::vector<uint8_t> data;
+    size_t used = 0;
+    size_t commandCount = 0;
+    Counters counters;
+};
@@ -0,0 +1,205 @@
+#include "frustum_culling.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FRUSTUM_CULLING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX2_FUNCTION
+#else
+// See source/batch_math.cpp
+#define AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+Frustum extractFrustum(const glm::mat4& m) {
+    // A point p is inside the clip space if -w <= x <= w, -w <= y <= w and -w <= z <= w, where (x, y, z, w) = M * p
+    // x = row0 . p and w = row3 . p, so -w <= x is the same as (row3 + row0) . p >= 0, which is a plane equation
+    // The same goes for the other 5 inequalities (Gribb & Hartmann)
+    // glm matrices are stored column by column, so the row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    glm::vec4 rows[4];
+    for(int r = 0; r < 4; r++) rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // Left
+    frustum.planes[1] = rows[3] - rows[0]; // Right
+    frustum.planes[2] = rows[3] + rows[1]; // Bottom
+    frustum.planes[3] = rows[3] - rows[1]; // Top
+    frustum.planes[4] = rows[3] + rows[2]; // Near
+    frustum.planes[5] = rows[3] - rows[2]; // Far
+    // Normalizing makes the plane equation give the real distance, which is compared with the radius of the spheres
+    for(glm::vec4& plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+namespace {
+    // The signed distance from the plane to the farthest point of the bounds in the direction of the normal:
+    // for a sphere, it is the distance to the center + the radius
+    // for a box, it is the distance to the center + the extents projected on the normal |a|*ex + |b|*ey + |c|*ez
+    // If it is negative for any plane, the whole object is outside
+
+    // Each kernel writes the indices of the visible objects from "begin" to "end" to "out" and returns how many it wrote
+    // "out" must have room for (end - begin) indices
+    // The index is always written, but the count only advances if the object is visible, which avoids a branch per object
+
+    // ---------------- Scalar ----------------
+
+    template<bool BOXES>
+    size_t cullScalar(const Frustum& frustum, const float* x, const float* y, const float* z,
+                      const float* radius, const float* extentX, const float* extentY, const float* extentZ,
+                      size_t begin, size_t end, uint32_t* out) {
+        size_t written = 0;
+        for(size_t i = begin; i < end; i++){
+            bool inside = true;
+            for(const glm::vec4& plane : frustum.planes){
+                float distance = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w;
+                if(BOXES) distance += std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+                else distance += radius[i];
+                inside = inside && distance >= 0;
+            }
+            out[written] = (uint32_t)i;
+            written += inside;
+        }
+        return written;
+    }
+
+#ifdef FRUSTUM_CULLING_X86
+    // ---------------- SSE2 (4 objects at once) ----------------
+
+    template<bool BOXES>
+    size_t cullSSE2(const Frustum& frustum, const float* x, const float* y, const float* z,
+                    const float* radius, const float* extentX, const float* extentY, const float* extentZ,
+                    size_t begin, size_t end, uint32_t* out) {
+        size_t written = 0;
+        size_t i = begin;
+        // The chunks can start anywhere, so unaligned loads are used
+        for(; i + 4 <= end; i += 4){
+            __m128 cx = _mm_loadu_ps(x + i), cy = _mm_loadu_ps(y + i), cz = _mm_loadu_ps(z + i);
+            __m128 r, ex, ey, ez;
+            if(BOXES){ ex = _mm_loadu_ps(extentX + i); ey = _mm_loadu_ps(extentY + i); ez = _mm_loadu_ps(extentZ + i); }
+            else r = _mm_loadu_ps(radius + i);
+
+            // All bits set in the lanes of the objects that are in front of all the planes so far
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(const glm::vec4& plane : frustum.planes){
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+                if(BOXES){
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), ex));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), ey));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), ez));
+                } else {
+                    distance = _mm_add_ps(distance, r);
+                }
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+            }
+
+            // 1 bit per object
+            int mask = _mm_movemask_ps(inside);
+            for(int lane = 0; lane < 4; lane++){
+                out[written] = (uint32_t)(i + lane);
+                written += (mask >> lane) & 1;
+            }
+        }
+        // The remaining objects (less than 4)
+        return written + cullScalar<BOXES>(frustum, x, y, z, radius, extentX, extentY, extentZ, i, end, out + written);
+    }
+
+    // ---------------- AVX2 (8 objects at once) ----------------
+
+    template<bool BOXES>
+    AVX2_FUNCTION
+    size_t cullAVX2(const Frustum& frustum, const float* x, const float* y, const float* z,
+                    const float* radius, const float* extentX, const float* extentY, const float* extentZ,
+                    size_t begin, size_t end, uint32_t* out) {
+        size_t written = 0;
+        size_t i = begin;
+        for(; i + 8 <= end; i += 8){
+            __m256 cx = _mm256_loadu_ps(x + i), cy = _mm256_loadu_ps(y + i), cz = _mm256_loadu_ps(z + i);
+            __m256 r, ex, ey, ez;
+            if(BOXES){ ex = _mm256_loadu_ps(extentX + i); ey = _mm256_loadu_ps(extentY + i); ez = _mm256_loadu_ps(extentZ + i); }
+            else r = _mm256_loadu_ps(radius + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(const glm::vec4& plane : frustum.planes){
+                // FMA: a * b + c in 1 instruction
+                __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), cx, _mm256_set1_ps(plane.w));
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), cy, distance);
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), cz, distance);
+                if(BOXES){
+                    distance = _mm256_fmadd_ps(_mm256_set1_ps(std::abs(plane.x)), ex, distance);
+                    distance = _mm256_fmadd_ps(_mm256_set1_ps(std::abs(plane.y)), ey, distance);
+                    distance = _mm256_fmadd_ps(_mm256_set1_ps(std::abs(plane.z)), ez, distance);
+                } else {
+                    distance = _mm256_add_ps(distance, r);
+                }
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            int mask = _mm256_movemask_ps(inside);
+            // Most of the time, 8 objects next to each other are all visible or all culled
+            if(mask == 0) continue;
+            for(int lane = 0; lane < 8; lane++){
+                out[written] = (uint32_t)(i + lane);
+                written += (mask >> lane) & 1;
+            }
+        }
+        return written + cullScalar<BOXES>(frustum, x, y, z, radius, extentX, extentY, extentZ, i, end, out + written);
+    }
+#endif
+
+    template<bool BOXES>
+    size_t cullRange(SimdLevel level, const Frustum& frustum, const float* x, const float* y, const float* z,
+                     const float* radius, const float* extentX, const float* extentY, const float* extentZ,
+                     size_t begin, size_t end, uint32_t* out) {
+#ifdef FRUSTUM_CULLING_X86
+        if(level == SimdLevel::AVX2) return cullAVX2<BOXES>(frustum, x, y, z, radius, extentX, extentY, extentZ, begin, end, out);
+        if(level == SimdLevel::SSE2) return cullSSE2<BOXES>(frustum, x, y, z, radius, extentX, extentY, extentZ, begin, end, out);
+#endif
+        (void)level;
+        return cullScalar<BOXES>(frustum, x, y, z, radius, extentX, extentY, extentZ, begin, end, out);
+    }
+}
+
+void FrustumCuller::cull(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& visible) {
+    cull(frustum, BoundsView{spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(),
+                             nullptr, nullptr, nullptr, spheres.size()}, visible);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, const BoundingBoxesSoA& boxes, std::vector<uint32_t>& visible) {
+    cull(frustum, BoundsView{boxes.centerX.data(), boxes.centerY.data(), boxes.centerZ.data(), nullptr,
+                             boxes.extentX.data(), boxes.extentY.data(), boxes.extentZ.data(), boxes.size()}, visible);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, const BoundsView& bounds, std::vector<uint32_t>& visible) {
+    // The same level as the batch math functions (see setSimdLevel)
+    SimdLevel level = getSimdLevel();
+    bool boxes = bounds.radius == nullptr;
+    auto cullChunk = [&](size_t begin, size_t end, uint32_t* out) {
+        return boxes ? cullRange<true>(level, frustum, bounds.x, bounds.y, bounds.z, bounds.radius, bounds.extentX, bounds.extentY, bounds.extentZ, begin, end, out)
+                     : cullRange<false>(level, frustum, bounds.x, bounds.y, bounds.z, bounds.radius, bounds.extentX, bounds.extentY, bounds.extentZ, begin, end, out);
+    };
+
+    size_t chunkCount = threadPool ? threadPool->getChunkCount(bounds.count, MIN_OBJECTS_PER_THREAD) : 1;
+    if(chunkCount <= 1){
+        // The kernels write into the list directly, so it is made big enough for all the objects then shrunk
+        // (resize doesn't free the memory, so after the first frame this doesn't allocate)
+        visible.resize(bounds.count);
+        visible.resize(cullChunk(0, bounds.count, visible.data()));
+    } else {
+        // Each chunk writes to its own list, then the lists are joined in order
+        if(chunkResults.size() < chunkCount) chunkResults.resize(chunkCount);
+        threadPool->parallelFor(bounds.count, MIN_OBJECTS_PER_THREAD, [&](size_t begin, size_t end, size_t chunk) {
+            std::vector<uint32_t>& result = chunkResults[chunk];
+            result.resize(end - begin);
+            result.resize(cullChunk(begin, end, result.data()));
+        });
+        visible.clear();
+        for(size_t chunk = 0; chunk < chunkCount; chunk++)
+            visible.insert(visible.end(), chunkResults[chunk].begin(), chunkResults[chunk].end());
+    }
+
+    counters.visible = visible.size();
+    counters.culled = bounds.count - visible.size();
+}
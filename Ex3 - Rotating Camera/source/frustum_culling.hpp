@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "batch_math.hpp"
+#include "thread_pool.hpp"
+
+// Frustum Culling
+// ----------------
+// The camera only sees what is inside its frustum (the pyramid between the near and far planes).
+// Sending the objects outside it to the GPU is wasted work: the GPU transforms their vertices, then throws their triangles away.
+// So before drawing, every object is tested against the 6 planes of the frustum on the CPU, and only the visible ones are drawn.
+//
+// Each object is represented by a simple shape that contains it (a bounding sphere or an axis-aligned bounding box).
+// The shape is outside the frustum if it is completely behind any of the 6 planes.
+// This test is conservative: a few objects near the corners of the frustum are drawn although they are not visible, which is fine.
+//
+// The bounds are stored as a structure of arrays (see source/batch_math.hpp), so 4 (SSE2) or 8 (AVX2) objects are tested at once.
+// With a lot of objects, the work is split between the threads of a thread pool.
+
+// The 6 planes (left, right, bottom, top, near, far) as (a, b, c, d), where a*x + b*y + c*z + d >= 0 for the points inside
+// The normals (a, b, c) point inside the frustum and are normalized, so a*x + b*y + c*z + d is the distance to the plane
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Extracts the planes of the frustum from a View-Projection matrix
+// The planes are in world space, since the View-Projection matrix changes from world space to clip space
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+struct BoundingSpheresSoA {
+    AlignedFloatVector x, y, z, radius;
+
+    void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); radius.resize(count); }
+    size_t size() const { return x.size(); }
+};
+
+// Boxes aligned with the world axes, stored as their centers and their half sizes along each axis
+struct BoundingBoxesSoA {
+    AlignedFloatVector centerX, centerY, centerZ, extentX, extentY, extentZ;
+
+    void resize(size_t count) {
+        centerX.resize(count); centerY.resize(count); centerZ.resize(count);
+        extentX.resize(count); extentY.resize(count); extentZ.resize(count);
+    }
+    size_t size() const { return centerX.size(); }
+};
+
+class FrustumCuller {
+public:
+    // The results of the last call to cull()
+    struct Counters {
+        size_t visible = 0, culled = 0;
+    };
+
+    // Below this number of objects per thread, the work is not split (waking up the threads would take longer than the test)
+    static const size_t MIN_OBJECTS_PER_THREAD = 8192;
+
+    // Without a thread pool, all the objects are tested on the calling thread
+    explicit FrustumCuller(ThreadPool* threadPool = nullptr) : threadPool(threadPool) {}
+
+    // Replaces the content of "visible" with the indices of the objects that may be visible, in increasing order
+    void cull(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& visible);
+    void cull(const Frustum& frustum, const BoundingBoxesSoA& boxes, std::vector<uint32_t>& visible);
+
+    const Counters& getCounters() const { return counters; }
+
+private:
+    // Pointers to the bounds, the radius is null for boxes and the extents are null for spheres
+    struct BoundsView {
+        const float *x, *y, *z, *radius, *extentX, *extentY, *extentZ;
+        size_t count;
+    };
+
+    void cull(const Frustum& frustum, const BoundsView& bounds, std::vector<uint32_t>& visible);
+
+    ThreadPool* threadPool;
+    // The visible indices found by each chunk, joined in order at the end
+    std::vector<std::vector<uint32_t>> chunkResults;
+    Counters counters;
+};
@@ -0,0 +1,96 @@
+#include "gpu_culling.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+bool GpuCuller::isSupported() {
+    return GLAD_GL_VERSION_4_3 ||
+           (GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object && GLAD_GL_ARB_multi_draw_indirect);
+}
+
+void GpuCuller::create(GLuint cullProgram, GLuint models, size_t objects, const std::vector<MeshCluster>& clusters,
+                       const glm::mat4& boundsTransform, float radiusScale) {
+    program = cullProgram;
+    modelBuffer = models;
+    objectCount = objects;
+    clusterCount = clusters.size();
+    itemCount = objectCount * clusterCount;
+    drawCountSupported = GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+
+    std::vector<GpuCullCluster> gpuClusters(clusterCount);
+    for(size_t c = 0; c < clusterCount; c++){
+        const MeshCluster& cluster = clusters[c];
+        gpuClusters[c] = {cluster.indexCount, cluster.firstIndex, cluster.baseVertex, 0,
+                          {cluster.center.x, cluster.center.y, cluster.center.z, cluster.radius}};
+    }
+    glGenBuffers(1, &clusterBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, gpuClusters.size() * sizeof(GpuCullCluster), gpuClusters.data(), GL_STATIC_DRAW);
+
+    // Only the GPU writes and reads the commands
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, itemCount * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &countBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // The uniforms that don't change are set once
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "boundsTransform"), 1, false, glm::value_ptr(boundsTransform));
+    glUniform1f(glGetUniformLocation(program, "radiusScale"), radiusScale);
+    glUniform1ui(glGetUniformLocation(program, "objectCount"), (GLuint)objectCount);
+    glUniform1ui(glGetUniformLocation(program, "clusterCount"), (GLuint)clusterCount);
+    glUniform1i(glGetUniformLocation(program, "compact"), drawCountSupported ? 1 : 0);
+    planesLoc = glGetUniformLocation(program, "planes");
+    glUseProgram(0);
+}
+
+void GpuCuller::cull(RenderState& state, const Frustum& frustum) {
+    // The compute shader counts the visible clusters from 0
+    GLuint zero = 0;
+    state.bindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+
+    state.useProgram(program);
+    glUniform4fv(planesLoc, 6, glm::value_ptr(frustum.planes[0]));
+    // The binding points of the buffers in the shader (binding = 0, 1, 2 and 3)
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, modelBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, clusterBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, countBuffer);
+    // 64 invocations per work group (local_size_x in the shader)
+    glDispatchCompute((GLuint)((itemCount + 63) / 64), 1, 1);
+
+    // The draw call reads the commands and the count as indirect parameters, which must wait for the writes of the compute shader
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void GpuCuller::draw(RenderState& state, GLenum indexType) {
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if(drawCountSupported){
+        // The 4th param is the offset of the count in the parameter buffer, the 5th the maximum number of draws
+        state.bindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+        if(GLAD_GL_VERSION_4_6) glMultiDrawElementsIndirectCount(GL_TRIANGLES, indexType, (void*)0, 0, (GLsizei)itemCount, 0);
+        else glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, indexType, (void*)0, 0, (GLsizei)itemCount, 0);
+    } else {
+        // The last param (stride) of 0 means the commands are packed one after the other
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, (void*)0, (GLsizei)itemCount, 0);
+    }
+}
+
+GLuint GpuCuller::readVisibleCount(RenderState& state) {
+    GLuint count = 0;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    state.bindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &count);
+    return count;
+}
+
+void GpuCuller::destroy() {
+    if(clusterBuffer) glDeleteBuffers(1, &clusterBuffer);
+    if(commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    if(countBuffer) glDeleteBuffers(1, &countBuffer);
+    clusterBuffer = commandBuffer = countBuffer = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include "frustum_culling.hpp"
+#include "mesh_builder.hpp"
+#include "render_state.hpp"
+
+// GPU-Driven Culling
+// ----------------
+// Even with instancing, the CPU decides which squares are drawn, and sends their model matrices again every frame.
+// In a GPU-driven renderer, the whole scene stays on the GPU:
+// - The model matrices and the bounding spheres of the clusters are stored in shader storage buffers (SSBOs) once.
+// - Every frame, a compute shader (assets/shaders/cull.comp) tests every cluster of every square against the frustum,
+//   and writes a DrawElementsIndirectCommand for each one into another buffer.
+// - A single glMultiDrawElementsIndirect call draws all the commands in that buffer, the CPU only sends the View-Projection matrix.
+//
+// With OpenGL 4.6 (or GL_ARB_indirect_parameters), the visible commands are packed at the start of the buffer and their number
+// is read by glMultiDrawElementsIndirectCount from a buffer too. Otherwise every cluster keeps its command, and the culled ones
+// draw 0 instances, which the GPU skips quickly.
+//
+// Needs OpenGL 4.3 (compute shaders, SSBOs and multi-draw indirect), which Mesa's llvmpipe supports,
+// otherwise the example falls back to the OpenGL 3.3 path with the CPU culling.
+
+// The layout that glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+    GLuint count;          // The number of indices
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;   // Added to the instance number when reading the instance attributes
+};
+
+// A cluster as stored in the SSBO, with the std430 layout of the compute shader
+struct GpuCullCluster {
+    GLuint indexCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint padding;
+    float sphere[4];
+};
+
+class GpuCuller {
+public:
+    // True if the context has compute shaders, SSBOs and multi-draw indirect
+    static bool isSupported();
+
+    // "program" is the compute program of assets/shaders/cull.comp
+    // "modelBuffer" holds the model matrix of every object, it is also the instance attribute buffer of the vertex array
+    // "boundsTransform" changes the spheres of the clusters to the space of the vertices sent to the GPU,
+    // and the model matrices scale them by "radiusScale"
+    void create(GLuint program, GLuint modelBuffer, size_t objectCount, const std::vector<MeshCluster>& clusters,
+                const glm::mat4& boundsTransform, float radiusScale);
+
+    // Runs the compute shader, the commands are ready for draw() after it
+    // The compute program stays in use, so the program that draws must be used again before draw()
+    void cull(RenderState& state, const Frustum& frustum);
+
+    // Draws the commands written by cull() with the current program and vertex array
+    void draw(RenderState& state, GLenum indexType);
+
+    // Reads the number of visible clusters of the last cull() back from the GPU
+    // It waits for the GPU to finish the culling, so only call it for statistics
+    GLuint readVisibleCount(RenderState& state);
+
+    size_t getItemCount() const { return itemCount; }
+    bool usesDrawCount() const { return drawCountSupported; }
+
+    void destroy();
+
+private:
+    GLuint program = 0;
+    GLuint modelBuffer = 0, clusterBuffer = 0, commandBuffer = 0, countBuffer = 0;
+    size_t objectCount = 0, clusterCount = 0, itemCount = 0;
+    bool drawCountSupported = false;
+    GLint planesLoc = -1;
+};
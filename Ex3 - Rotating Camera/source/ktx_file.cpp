@@ -0,0 +1,113 @@
+#include "ktx_file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "mapped_file.hpp"
+
+namespace {
+    const uint8_t KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+    size_t alignTo4(size_t size) { return (size + 3) / 4 * 4; }
+
+    // The size in bytes of a level of width x height pixels in "format"
+    size_t getLevelSize(GLenum format, int width, int height) {
+        if(isCompressedFormat(format)) return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getCompressedBlockSize(format);
+        return (size_t)width * height * 4;
+    }
+}
+
+bool saveKtxFile(const std::string& path, const std::vector<Image>& mips) {
+    if(mips.empty()) return false;
+    GLenum format = mips[0].format;
+    bool compressed = isCompressedFormat(format);
+
+    KtxHeader header = {};
+    std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = KTX_ENDIANNESS;
+    header.glType = compressed ? 0 : GL_UNSIGNED_BYTE;
+    header.glTypeSize = 1;
+    header.glFormat = compressed ? 0 : GL_RGBA;
+    header.glInternalFormat = format;
+    header.glBaseInternalFormat = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? GL_RGB : GL_RGBA;
+    header.pixelWidth = mips[0].width;
+    header.pixelHeight = mips[0].height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (uint32_t)mips.size();
+
+    std::ofstream file(path, std::ios::binary);
+    if(!file){
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+    const char padding[4] = {};
+    file.write((const char*)&header, sizeof(header));
+    for(const Image& mip : mips){
+        uint32_t imageSize = (uint32_t)mip.getSize();
+        file.write((const char*)&imageSize, sizeof(imageSize));
+        file.write((const char*)mip.pixels.data(), mip.getSize());
+        file.write(padding, alignTo4(mip.getSize()) - mip.getSize());
+    }
+    if(!file){
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadKtxFile(const std::string& path, std::vector<Image>& mips) {
+    mips.clear();
+    MappedFile file;
+    if(!file.open(path)) return false;
+
+    // Check everything before reading the levels, a truncated file must not be read past its end
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    KtxHeader header = {};
+    const char* error = nullptr;
+    if(size < sizeof(KtxHeader)) error = "too small";
+    else {
+        std::memcpy(&header, data, sizeof(KtxHeader));
+        if(std::memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) error = "not a KTX 1.1 file";
+        else if(header.endianness != KTX_ENDIANNESS) error = "big endian files aren't supported";
+        else if(header.glInternalFormat != GL_RGBA8 && !isCompressedFormat(header.glInternalFormat)) error = "only RGBA8, BC1 and BC3 are supported";
+        else if(header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1) error = "only 2D textures are supported";
+        else if(header.pixelWidth == 0 || header.pixelHeight == 0) error = "empty texture";
+        else if(header.numberOfMipmapLevels > (uint32_t)getMipLevelCount(header.pixelWidth, header.pixelHeight)) error = "too many levels";
+    }
+
+    // Level count 0 means the levels should be generated at load time, only level 0 is stored
+    size_t offset = sizeof(KtxHeader) + (error ? 0 : header.bytesOfKeyValueData);
+    int levels = std::max(1, (int)header.numberOfMipmapLevels);
+    int width = header.pixelWidth, height = header.pixelHeight;
+    for(int level = 0; level < levels && !error; level++){
+        uint32_t imageSize;
+        if(offset + sizeof(imageSize) > size){
+            error = "truncated";
+            break;
+        }
+        std::memcpy(&imageSize, data + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+        if(imageSize != getLevelSize(header.glInternalFormat, width, height)) error = "a level has the wrong size";
+        else if(offset + imageSize > size) error = "truncated";
+        else {
+            Image mip;
+            mip.width = width;
+            mip.height = height;
+            mip.format = header.glInternalFormat;
+            mip.pixels.assign(data + offset, data + offset + imageSize);
+            mips.push_back(std::move(mip));
+            offset += alignTo4(imageSize);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+    if(error){
+        std::cerr << "Invalid KTX file " << path << ": " << error << std::endl;
+        mips.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "texture.hpp"
+
+// KTX Texture Files
+// ----------------
+// KTX is the texture container of Khronos (the group behind OpenGL): it stores the levels exactly as glCompressedTexSubImage2D
+// (or glTexSubImage2D) expects them, with the OpenGL enums of their format, so loading it is only reading the levels
+// and sending them without decoding anything. Other tools (like the ones of the GPU vendors) can open the files written here.
+//
+// Layout of version 1.1 (little endian):
+//   KtxHeader (64 bytes)
+//   the key/value data (none here)
+//   for every level, from level 0 to the smallest: its size in bytes (uint32), then its data padded to a multiple of 4 bytes
+//
+// Create .ktx files with the TextureCompressor tool (tools/texture_compressor.cpp).
+
+struct KtxHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;             // 0x04030201 written in the byte order of the file
+    uint32_t glType;                 // 0 for compressed formats, GL_UNSIGNED_BYTE otherwise
+    uint32_t glTypeSize;             // 1 for compressed formats and bytes
+    uint32_t glFormat;               // 0 for compressed formats, GL_RGBA otherwise
+    uint32_t glInternalFormat;       // The format of the texture: GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGBA8, ...
+    uint32_t glBaseInternalFormat;   // GL_RGB or GL_RGBA
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;             // 0 for 2D textures
+    uint32_t numberOfArrayElements;  // 0 if it isn't an array texture
+    uint32_t numberOfFaces;          // 6 for cube maps, 1 otherwise
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64, "The header must have the same size on every compiler");
+
+// Writes the levels (all with the same format, level i + 1 half the size of level i) to a .ktx file
+// Returns false and prints the error if the file can't be written
+bool saveKtxFile(const std::string& path, const std::vector<Image>& mips);
+
+// Reads the levels of a 2D texture in RGBA8, BC1 or BC3 from a .ktx file into "mips"
+// Returns false and prints the error if the file can't be read or holds another kind of texture
+bool loadKtxFile(const std::string& path, std::vector<Image>& mips);
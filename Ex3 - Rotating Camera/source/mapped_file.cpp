@@ -0,0 +1,93 @@
+#include "mapped_file.hpp"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(handle == INVALID_HANDLE_VALUE){
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    file = handle;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(handle, &fileSize);
+    size = (size_t)fileSize.QuadPart;
+    // Windows can't map an empty file
+    if(size == 0) return true;
+
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping) data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!data){
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if(data) UnmapViewOfFile(data);
+    if(mapping) CloseHandle(mapping);
+    if(file) CloseHandle(file);
+    data = nullptr;
+    mapping = file = nullptr;
+    size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0){
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    struct stat status;
+    if(fstat(descriptor, &status) != 0){
+        std::cerr << "Failed to read the size of " << path << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+    size = (size_t)status.st_size;
+    // mmap fails with a size of 0
+    if(size == 0){
+        ::close(descriptor);
+        return true;
+    }
+
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps the file open, so the descriptor isn't needed anymore
+    ::close(descriptor);
+    if(address == MAP_FAILED){
+        std::cerr << "Failed to map " << path << std::endl;
+        size = 0;
+        return false;
+    }
+    // The file is read from start to end, so the OS can read the next pages before we need them
+    madvise(address, size, MADV_SEQUENTIAL);
+    data = (const char*)address;
+    return true;
+}
+
+void MappedFile::close() {
+    if(data) munmap((void*)data, size);
+    data = nullptr;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Memory Mapped File
+// ----------------
+// Instead of reading a file into a buffer with fread (which copies every byte from the OS cache into our memory),
+// the OS maps the file into the address space of the program, and the pages are loaded from the disk when they are first read.
+// This saves a copy, and the pages can be read by many threads at once.
+// The file is read-only and stays mapped until close() is called or the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file can't be opened, an empty file is opened successfully with a null data pointer
+    bool open(const std::string& path);
+    void close();
+
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
@@ -0,0 +1,64 @@
+#include "mesh.hpp"
+
+#include <cstring>
+
+void computeMeshBounds(const Vertex* vertices, size_t count, glm::vec3& low, glm::vec3& high) {
+    low = high = glm::vec3(0);
+    if(count == 0) return;
+    low = high = glm::vec3(vertices[0].x, vertices[0].y, vertices[0].z);
+    for(size_t i = 1; i < count; i++){
+        glm::vec3 position(vertices[i].x, vertices[i].y, vertices[i].z);
+        low = glm::min(low, position);
+        high = glm::max(high, position);
+    }
+}
+
+GLenum chooseIndexType(size_t vertexCount) {
+    // Some GPUs convert 8-bit indices to 16-bit ones in the driver, but it still saves memory on the others
+    if(vertexCount <= 256) return GL_UNSIGNED_BYTE;
+    if(vertexCount <= 65536) return GL_UNSIGNED_SHORT;
+    return GL_UNSIGNED_INT;
+}
+
+size_t getIndexTypeSize(GLenum indexType) {
+    switch(indexType){
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default: return 4;
+    }
+}
+
+int getIndexTypeBits(GLenum indexType) { return 8 * (int)getIndexTypeSize(indexType); }
+
+uint32_t Mesh::getIndex(size_t i) const {
+    if(indexType == GL_UNSIGNED_BYTE) return indexData[i];
+    if(indexType == GL_UNSIGNED_SHORT){
+        uint16_t index;
+        std::memcpy(&index, indexData.data() + 2*i, 2);
+        return index;
+    }
+    uint32_t index;
+    std::memcpy(&index, indexData.data() + 4*i, 4);
+    return index;
+}
+
+std::vector<uint32_t> Mesh::getIndices() const {
+    std::vector<uint32_t> indices(getIndexCount());
+    for(size_t i = 0; i < indices.size(); i++) indices[i] = getIndex(i);
+    return indices;
+}
+
+void Mesh::setIndices(const std::vector<uint32_t>& indices, GLenum type) {
+    indexType = type != 0 ? type : chooseIndexType(vertices.size());
+    if(indexType == GL_UNSIGNED_BYTE){
+        indexData.resize(indices.size());
+        for(size_t i = 0; i < indices.size(); i++) indexData[i] = (uint8_t)indices[i];
+    } else if(indexType == GL_UNSIGNED_SHORT){
+        indexData.resize(2 * indices.size());
+        uint16_t* out = (uint16_t*)indexData.data();
+        for(size_t i = 0; i < indices.size(); i++) out[i] = (uint16_t)indices[i];
+    } else {
+        indexData.resize(4 * indices.size());
+        std::memcpy(indexData.data(), indices.data(), 4 * indices.size());
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+// The layout of a vertex in the vertex buffers: a position and a color
+// The attributes are set up in main.cpp: location 0 = position (3 floats), location 1 = color (4 normalized bytes)
+struct Vertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+
+// Index Types
+// ----------------
+// The smaller the indices, the less memory the GPU reads per triangle, so every mesh uses the smallest type
+// that can index all its vertices: 8 bits for up to 256 vertices, 16 bits for up to 65536, otherwise 32 bits.
+// Meshes with more than 65536 vertices can still use 16-bit indices if they are split into clusters (see source/mesh_builder.hpp).
+GLenum chooseIndexType(size_t vertexCount);
+// 1 for GL_UNSIGNED_BYTE, 2 for GL_UNSIGNED_SHORT, 4 for GL_UNSIGNED_INT
+size_t getIndexTypeSize(GLenum indexType);
+// The number of bits, for printing
+int getIndexTypeBits(GLenum indexType);
+
+// Points to the vertices and the indices of a mesh stored somewhere else (in a Mesh, or in a mapped mesh file)
+// This is all glBufferData and glDrawElements need
+struct MeshView {
+    const Vertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    const void* indexData = nullptr;
+    size_t indexCount = 0;
+
+    size_t getIndexSize() const { return getIndexTypeSize(indexType); }
+};
+
+// The smallest box aligned with the axes that contains all the vertices
+void computeMeshBounds(const Vertex* vertices, size_t count, glm::vec3& low, glm::vec3& high);
+
+// A triangle mesh ready to be sent to the GPU: the vertices, and 3 indices per triangle
+// The indices are stored in the smallest type that can index all the vertices (see chooseIndexType),
+// so they can be sent to glBufferData and drawn with glDrawElements as they are
+struct Mesh {
+    std::vector<Vertex> vertices;
+
+    // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    std::vector<uint8_t> indexData;
+
+    size_t getIndexSize() const { return getIndexTypeSize(indexType); }
+    size_t getIndexCount() const { return indexData.size() / getIndexSize(); }
+    size_t getTriangleCount() const { return getIndexCount() / 3; }
+
+    uint32_t getIndex(size_t i) const;
+    std::vector<uint32_t> getIndices() const;
+    // Stores the indices in the type chosen by chooseIndexType for the number of vertices (the vertices must be set first),
+    // or in "type" if it isn't 0 (all the indices must fit in it)
+    void setIndices(const std::vector<uint32_t>& indices, GLenum type = 0);
+
+    MeshView getView() const { return {vertices.data(), vertices.size(), indexType, indexData.data(), getIndexCount()}; }
+};
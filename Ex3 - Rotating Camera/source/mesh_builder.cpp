@@ -0,0 +1,100 @@
+#include "mesh_builder.hpp"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+    uint32_t readIndex(const MeshView& view, size_t i) {
+        switch(view.indexType){
+            case GL_UNSIGNED_BYTE: return ((const uint8_t*)view.indexData)[i];
+            case GL_UNSIGNED_SHORT: {
+                uint16_t index;
+                std::memcpy(&index, (const uint8_t*)view.indexData + 2*i, 2);
+                return index;
+            }
+            default: {
+                uint32_t index;
+                std::memcpy(&index, (const uint8_t*)view.indexData + 4*i, 4);
+                return index;
+            }
+        }
+    }
+
+    // A sphere around the box of the vertices is not the smallest sphere, but it is fast and good enough for culling
+    void computeClusterSphere(MeshCluster& cluster, const Vertex* vertices) {
+        glm::vec3 low, high;
+        computeMeshBounds(vertices, cluster.vertexCount, low, high);
+        cluster.center = (low + high) * 0.5f;
+        float radiusSquared = 0;
+        for(uint32_t v = 0; v < cluster.vertexCount; v++){
+            glm::vec3 offset = glm::vec3(vertices[v].x, vertices[v].y, vertices[v].z) - cluster.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        cluster.radius = std::sqrt(radiusSquared);
+    }
+}
+
+ClusteredMesh buildClusteredMesh(const MeshView& view, size_t maxVertices) {
+    ClusteredMesh result;
+    Mesh& mesh = result.mesh;
+    std::vector<uint32_t> indices;
+    indices.reserve(view.indexCount);
+    mesh.vertices.reserve(view.vertexCount);
+
+    // The index of every vertex in the current cluster, or UNUSED if the cluster doesn't have it yet
+    // "usedVertices" lists the vertices set in "local", so it can be cleared without going over all the vertices
+    const uint32_t UNUSED = 0xFFFFFFFF;
+    std::vector<uint32_t> local(view.vertexCount, UNUSED);
+    std::vector<uint32_t> usedVertices;
+    MeshCluster cluster = {};
+
+    auto finishCluster = [&]() {
+        if(cluster.indexCount == 0) return;
+        cluster.vertexCount = (uint32_t)usedVertices.size();
+        computeClusterSphere(cluster, mesh.vertices.data() + cluster.baseVertex);
+        result.clusters.push_back(cluster);
+        for(uint32_t vertex : usedVertices) local[vertex] = UNUSED;
+        usedVertices.clear();
+        cluster = {};
+        cluster.firstIndex = (uint32_t)indices.size();
+        cluster.baseVertex = (int32_t)mesh.vertices.size();
+    };
+
+    for(size_t t = 0; t + 2 < view.indexCount; t += 3){
+        uint32_t triangle[3] = {readIndex(view, t), readIndex(view, t + 1), readIndex(view, t + 2)};
+        size_t newVertices = 0;
+        for(int corner = 0; corner < 3; corner++){
+            // A triangle can use the same vertex twice
+            bool repeated = corner > 0 && triangle[corner] == triangle[0];
+            repeated = repeated || (corner > 1 && triangle[corner] == triangle[1]);
+            if(local[triangle[corner]] == UNUSED && !repeated) newVertices++;
+        }
+        if(usedVertices.size() + newVertices > maxVertices) finishCluster();
+
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t& localIndex = local[triangle[corner]];
+            if(localIndex == UNUSED){
+                localIndex = (uint32_t)usedVertices.size();
+                usedVertices.push_back(triangle[corner]);
+                mesh.vertices.push_back(view.vertices[triangle[corner]]);
+            }
+            indices.push_back(localIndex);
+        }
+        cluster.indexCount += 3;
+    }
+    finishCluster();
+
+    size_t biggestCluster = 0;
+    for(const MeshCluster& c : result.clusters) biggestCluster = std::max<size_t>(biggestCluster, c.vertexCount);
+    mesh.setIndices(indices, chooseIndexType(biggestCluster));
+    return result;
+}
+
+MeshCluster makeWholeMeshCluster(const MeshView& view) {
+    MeshCluster cluster = {};
+    cluster.indexCount = (uint32_t)view.indexCount;
+    cluster.vertexCount = (uint32_t)view.vertexCount;
+    computeClusterSphere(cluster, view.vertices);
+    return cluster;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "mesh.hpp"
+
+// Mesh Clusters
+// ----------------
+// A mesh with more than 65536 vertices needs 32-bit indices, which doubles the memory the GPU reads for the indices.
+// Instead, it can be split into clusters (also called meshlets) of at most 65536 vertices each:
+// the vertices of every cluster are stored one after the other, and the indices of a cluster count from its first vertex.
+// Every cluster is drawn with glDrawElementsBaseVertex, which adds "baseVertex" to every index before reading the vertex,
+// so all the clusters share 1 vertex buffer and 1 index buffer with 16-bit (or even 8-bit) indices.
+//
+// Every cluster also gets a bounding sphere, so the clusters outside the view can be culled one by one
+// instead of drawing the whole mesh when only a part of it is visible.
+
+struct MeshCluster {
+    uint32_t firstIndex;  // The first index of the cluster in the index buffer (multiply by the index size for the offset)
+    uint32_t indexCount;
+    int32_t baseVertex;   // Added to the indices of the cluster
+    uint32_t vertexCount;
+    glm::vec3 center;     // The bounding sphere of the cluster
+    float radius;
+};
+
+struct ClusteredMesh {
+    Mesh mesh;
+    std::vector<MeshCluster> clusters;
+};
+
+// Splits the triangles in their current order (so the order of the mesh optimizer is kept) into clusters of at most "maxVertices" vertices
+// The vertices used by more than 1 cluster are duplicated, and all the clusters use the same index type,
+// which is the smallest type that fits the biggest cluster
+ClusteredMesh buildClusteredMesh(const MeshView& view, size_t maxVertices = 65536);
+
+// A single cluster with the whole mesh, for the meshes that don't need to be split
+MeshCluster makeWholeMeshCluster(const MeshView& view);
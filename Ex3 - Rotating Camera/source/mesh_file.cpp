@@ -0,0 +1,111 @@
+#include "mesh_file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    uint64_t alignTo16(uint64_t offset) { return (offset + 15) / 16 * 16; }
+
+    // The largest of "count" indices of type "indexType" (0 if there are none)
+    uint32_t findMaxIndex(const char* indexData, GLenum indexType, size_t count) {
+        uint32_t maxIndex = 0;
+        for(size_t i = 0; i < count; i++){
+            uint32_t index;
+            if(indexType == GL_UNSIGNED_BYTE) index = (uint8_t)indexData[i];
+            else if(indexType == GL_UNSIGNED_SHORT){
+                uint16_t value;
+                std::memcpy(&value, indexData + 2*i, 2);
+                index = value;
+            } else std::memcpy(&index, indexData + 4*i, 4);
+            maxIndex = std::max(maxIndex, index);
+        }
+        return maxIndex;
+    }
+}
+
+bool saveMeshFile(const std::string& path, const Mesh& mesh) {
+    MeshFileHeader header = {};
+    header.magic = MeshFileHeader::MAGIC;
+    header.version = MeshFileHeader::VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.indexType = mesh.indexType;
+    header.vertexCount = mesh.vertices.size();
+    header.vertexOffset = alignTo16(sizeof(MeshFileHeader));
+    header.indexCount = mesh.getIndexCount();
+    header.indexOffset = alignTo16(header.vertexOffset + mesh.vertices.size() * sizeof(Vertex));
+    glm::vec3 low, high;
+    computeMeshBounds(mesh.vertices.data(), mesh.vertices.size(), low, high);
+    for(int i = 0; i < 3; i++){
+        header.boundsLow[i] = low[i];
+        header.boundsHigh[i] = high[i];
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if(!file){
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+    // The zeros between the blocks, to align them
+    const char padding[16] = {};
+    file.write((const char*)&header, sizeof(header));
+    file.write(padding, header.vertexOffset - sizeof(header));
+    file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+    file.write(padding, header.indexOffset - (header.vertexOffset + mesh.vertices.size() * sizeof(Vertex)));
+    file.write((const char*)mesh.indexData.data(), mesh.indexData.size());
+    if(!file){
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::open(const std::string& path) {
+    close();
+    if(!file.open(path)) return false;
+
+    // Check everything before pointing into the file, a truncated or old file must not be read past its end
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    const char* error = nullptr;
+    if(size < sizeof(MeshFileHeader)) error = "too small";
+    else {
+        std::memcpy(&header, data, sizeof(MeshFileHeader));
+        if(header.magic != MeshFileHeader::MAGIC) error = "not a mesh file";
+        else if(header.version != MeshFileHeader::VERSION) error = "written by another version, convert it again";
+        else if(header.vertexSize != sizeof(Vertex)) error = "the vertex layout is different, convert it again";
+        else if(header.indexType != GL_UNSIGNED_BYTE && header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT) error = "unknown index type";
+        else if(header.vertexOffset % 16 != 0 || header.indexOffset % 16 != 0) error = "the data isn't aligned";
+        else {
+            size_t indexSize = getIndexTypeSize(header.indexType);
+            // Written as divisions, so huge counts or offsets in a broken header can't overflow and pass the check
+            if(header.vertexOffset > size || header.vertexCount > (size - header.vertexOffset) / sizeof(Vertex)
+                || header.indexOffset > size || header.indexCount > (size - header.indexOffset) / indexSize)
+                error = "truncated";
+            // The indices are used as they are to read the vertices (by the GPU, the clustering and the software rasterizer),
+            // so 1 index past the last vertex would read outside of the file. Reading all of them costs about as much as
+            // the upload that follows, which reads them anyway.
+            else if(header.indexCount > 0 && findMaxIndex(data + header.indexOffset, header.indexType, (size_t)header.indexCount) >= header.vertexCount)
+                error = "an index is past the last vertex";
+        }
+    }
+    if(error){
+        std::cerr << "Invalid mesh file " << path << ": " << error << std::endl;
+        close();
+        return false;
+    }
+
+    view.vertices = (const Vertex*)(data + header.vertexOffset);
+    view.vertexCount = (size_t)header.vertexCount;
+    view.indexType = header.indexType;
+    view.indexData = data + header.indexOffset;
+    view.indexCount = (size_t)header.indexCount;
+    return true;
+}
+
+void MeshFile::close() {
+    file.close();
+    header = {};
+    view = MeshView();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "mesh.hpp"
+#include "mapped_file.hpp"
+
+// Binary Mesh Files
+// ----------------
+// Text formats like OBJ must be parsed and welded every time they are loaded (see source/mesh_importer.hpp).
+// A ".mesh" file instead stores the vertices and the indices exactly as they are in memory and in the GPU buffers:
+// the Vertex structs one after the other, then the 16-bit or 32-bit indices.
+// So loading it is only mapping the file (see source/mapped_file.hpp), and the mapped memory is given directly
+// to glBufferData without copying it anywhere first.
+//
+// Layout (little endian, which is the byte order of x86 and ARM CPUs):
+//   MeshFileHeader (80 bytes)
+//   vertices at vertexOffset: vertexCount * sizeof(Vertex) bytes
+//   indices at indexOffset: indexCount * 1, 2 or 4 bytes
+// The offsets are multiples of 16, so the data is aligned for any type.
+//
+// Create .mesh files from OBJ or PLY files with the MeshConverter tool (tools/mesh_converter.cpp).
+
+struct MeshFileHeader {
+    // "MESH" read as a little endian 32-bit number
+    static const uint32_t MAGIC = 0x4853454D;
+    // Increase the version every time the layout of the file or of Vertex changes,
+    // older files will be rejected and must be converted again
+    static const uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexSize;  // sizeof(Vertex) when the file was written
+    uint32_t indexType;   // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint64_t vertexCount;
+    uint64_t vertexOffset;
+    uint64_t indexCount;
+    uint64_t indexOffset;
+    // The bounding box of the vertices, so it doesn't have to be computed at load time
+    float boundsLow[3];
+    float boundsHigh[3];
+    // Zeros, space for new fields without changing the size of the header
+    uint32_t reserved[2];
+};
+
+static_assert(sizeof(MeshFileHeader) == 80, "The header must have the same size on every compiler");
+
+// Writes the mesh to a .mesh file, returns false and prints the error if the file can't be written
+bool saveMeshFile(const std::string& path, const Mesh& mesh);
+
+// A mapped .mesh file, the vertices and indices point into the mapped memory, so they are valid while the file is open
+class MeshFile {
+public:
+    // Returns false and prints the error if the file can't be read or isn't a valid .mesh file of this version
+    bool open(const std::string& path);
+    void close();
+
+    const MeshView& getView() const { return view; }
+    glm::vec3 getBoundsLow() const { return glm::vec3(header.boundsLow[0], header.boundsLow[1], header.boundsLow[2]); }
+    glm::vec3 getBoundsHigh() const { return glm::vec3(header.boundsHigh[0], header.boundsHigh[1], header.boundsHigh[2]); }
+    size_t getFileSize() const { return file.getSize(); }
+
+private:
+    MappedFile file;
+    MeshFileHeader header = {};
+    MeshView view;
+};
@@ -0,0 +1,682 @@
+#include "mesh_importer.hpp"
+#include "mapped_file.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Smaller chunks aren't worth waking up a thread
+    const size_t MIN_BYTES_PER_CHUNK = 1 << 20;
+    const size_t MIN_VERTICES_PER_CHUNK = 1 << 16;
+
+    struct Color {
+        uint8_t r, g, b, a;
+    };
+    const Color WHITE = {255, 255, 255, 255};
+
+    uint8_t toColorByte(double value) {
+        return (uint8_t)std::lround(std::clamp(value, 0.0, 1.0) * 255);
+    }
+
+    // Normals are in [-1, 1], so they are moved to [0, 1] to be shown as colors
+    Color colorFromNormal(glm::vec3 normal) {
+        float length = glm::length(normal);
+        if(length > 0) normal /= length;
+        return {toColorByte(0.5 + 0.5 * normal.x), toColorByte(0.5 + 0.5 * normal.y), toColorByte(0.5 + 0.5 * normal.z), 255};
+    }
+
+    Vertex makeVertex(const glm::vec3& position, Color color) {
+        // Adding 0 turns -0 into +0, otherwise 2 vertices at the same position wouldn't be welded since their bytes differ
+        return {position.x + 0.0f, position.y + 0.0f, position.z + 0.0f, color.r, color.g, color.b, color.a};
+    }
+
+    // Runs function(i) for i from 0 to count - 1, on all the threads of the pool if there is one
+    template<typename Function>
+    void forEach(ThreadPool* threadPool, size_t count, const Function& function) {
+        if(!threadPool){
+            for(size_t i = 0; i < count; i++) function(i);
+            return;
+        }
+        threadPool->parallelFor(count, 1, [&](size_t begin, size_t end, size_t) {
+            for(size_t i = begin; i < end; i++) function(i);
+        });
+    }
+
+    // ---------------- Text parsing ----------------
+
+    const char* skipSpaces(const char* p, const char* end) {
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        return p;
+    }
+
+    const char* findLineEnd(const char* p, const char* end) {
+        const char* newLine = (const char*)std::memchr(p, '\n', end - p);
+        return newLine ? newLine : end;
+    }
+
+    // Reads a number after the spaces at p and moves p after it, returns false if there is no number
+    // std::from_chars is much faster than std::stof and std::istream, and doesn't depend on the locale
+    template<typename T>
+    bool parseNumber(const char*& p, const char* end, T& value) {
+        const char* start = skipSpaces(p, end);
+        if(start < end && *start == '+') start++;
+        std::from_chars_result result = std::from_chars(start, end, value);
+        if(result.ec != std::errc()) return false;
+        p = result.ptr;
+        return true;
+    }
+
+    // ---------------- Welding ----------------
+
+    static_assert(sizeof(Vertex) == 16, "The hash of a vertex reads it as 4 32-bit words");
+
+    // A hash map from a vertex to its index in "unique", using open addressing:
+    // the indices are stored in 1 array, and a vertex whose slot is taken goes to the next free slot
+    // This is much faster than std::unordered_map which allocates every entry on its own
+    class VertexWelder {
+    public:
+        explicit VertexWelder(size_t maxCount) {
+            // At most half the slots are used, so the searches stay short
+            size_t capacity = 16;
+            while(capacity < 2 * maxCount) capacity *= 2;
+            slots.assign(capacity, EMPTY);
+            mask = capacity - 1;
+        }
+
+        // Returns the index of the vertex in "unique", it is added if it isn't there yet
+        uint32_t add(const Vertex& vertex) {
+            size_t slot = hash(vertex) & mask;
+            while(true){
+                uint32_t index = slots[slot];
+                if(index == EMPTY){
+                    index = (uint32_t)unique.size();
+                    unique.push_back(vertex);
+                    slots[slot] = index;
+                    return index;
+                }
+                if(std::memcmp(&unique[index], &vertex, sizeof(Vertex)) == 0) return index;
+                slot = (slot + 1) & mask;
+            }
+        }
+
+        std::vector<Vertex> unique;
+
+    private:
+        static size_t hash(const Vertex& vertex) {
+            uint32_t words[4];
+            std::memcpy(words, &vertex, sizeof(Vertex));
+            uint64_t hash = 0x9E3779B97F4A7C15ull;
+            for(uint32_t word : words){
+                hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+                hash ^= hash >> 32;
+            }
+            return (size_t)hash;
+        }
+
+        static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+        std::vector<uint32_t> slots;
+        size_t mask;
+    };
+
+    // Welds the vertices that are exactly the same, remap[i] is the index of vertices[i] in "unique"
+    // Each chunk of vertices is welded on its own thread first, then the (much fewer) vertices left in the chunks
+    // are welded together on 1 thread
+    void weldVertices(const std::vector<Vertex>& vertices, ThreadPool* threadPool,
+                      std::vector<Vertex>& unique, std::vector<uint32_t>& remap) {
+        remap.resize(vertices.size());
+        size_t chunkCount = threadPool ? threadPool->getChunkCount(vertices.size(), MIN_VERTICES_PER_CHUNK) : 1;
+        if(chunkCount <= 1){
+            VertexWelder welder(vertices.size());
+            for(size_t i = 0; i < vertices.size(); i++) remap[i] = welder.add(vertices[i]);
+            unique = std::move(welder.unique);
+            return;
+        }
+
+        // First, remap[i] is the index of the vertex in the unique vertices of its chunk
+        std::vector<std::vector<Vertex>> chunkVertices(chunkCount);
+        threadPool->parallelFor(vertices.size(), MIN_VERTICES_PER_CHUNK, [&](size_t begin, size_t end, size_t chunk) {
+            VertexWelder welder(end - begin);
+            for(size_t i = begin; i < end; i++) remap[i] = welder.add(vertices[i]);
+            chunkVertices[chunk] = std::move(welder.unique);
+        });
+
+        size_t total = 0;
+        for(const std::vector<Vertex>& chunk : chunkVertices) total += chunk.size();
+        VertexWelder welder(total);
+        std::vector<std::vector<uint32_t>> chunkRemap(chunkCount);
+        for(size_t chunk = 0; chunk < chunkCount; chunk++){
+            chunkRemap[chunk].resize(chunkVertices[chunk].size());
+            for(size_t i = 0; i < chunkVertices[chunk].size(); i++) chunkRemap[chunk][i] = welder.add(chunkVertices[chunk][i]);
+        }
+
+        // Then it is changed to the index in the unique vertices of the whole mesh
+        // The chunks are the same as the first pass since the count is the same
+        threadPool->parallelFor(vertices.size(), MIN_VERTICES_PER_CHUNK, [&](size_t begin, size_t end, size_t chunk) {
+            for(size_t i = begin; i < end; i++) remap[i] = chunkRemap[chunk][remap[i]];
+        });
+        unique = std::move(welder.unique);
+    }
+
+    // ---------------- OBJ ----------------
+
+    // OBJ indices start at 1, and negative indices count back from the last vertex defined before the face (-1 is the last one)
+    // A chunk doesn't know how many vertices the previous chunks have, so negative indices are stored relative to the start
+    // of the chunk, and are fixed once all the chunks are parsed
+    const uint8_t HAS_NORMAL = 1, RELATIVE_POSITION = 2, RELATIVE_NORMAL = 4;
+
+    struct ObjCorner {
+        int32_t position, normal;
+        uint8_t flags;
+    };
+
+    struct ObjChunk {
+        std::vector<glm::vec3> positions;
+        std::vector<Color> colors; // 1 per position
+        std::vector<glm::vec3> normals;
+        std::vector<ObjCorner> corners; // 3 per triangle
+        bool hasColors = false;
+        std::string error;
+        // The number of positions, normals and corners in the previous chunks
+        size_t positionOffset = 0, normalOffset = 0, cornerOffset = 0;
+    };
+
+    // Converts an index from the file, "count" is the number of positions (or normals) of the chunk so far
+    bool readObjIndex(int32_t index, size_t count, int32_t& out, uint8_t& flags, uint8_t relativeFlag) {
+        if(index > 0){
+            out = index - 1;
+        } else if(index < 0){
+            out = (int32_t)count + index;
+            flags |= relativeFlag;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Parses the lines from "p" to "end", the unsupported lines (texture coordinates, groups, materials, ...) are skipped
+    void parseObjChunk(const char* p, const char* end, ObjChunk& chunk) {
+        std::vector<ObjCorner> polygon;
+        while(p < end){
+            const char* line = skipSpaces(p, end);
+            const char* lineEnd = findLineEnd(line, end);
+            p = lineEnd < end ? lineEnd + 1 : end;
+            if(lineEnd - line < 2 || (line[1] != ' ' && line[1] != '\t' && line[1] != 'n')) continue;
+
+            const char* q = line + 2;
+            if(line[0] == 'v' && line[1] != 'n'){
+                // "v x y z" or "v x y z r g b"
+                glm::vec3 position;
+                if(!parseNumber(q, lineEnd, position.x) || !parseNumber(q, lineEnd, position.y) || !parseNumber(q, lineEnd, position.z)){
+                    chunk.error = "invalid vertex: " + std::string(line, lineEnd);
+                    return;
+                }
+                Color color = WHITE;
+                double r, g, b;
+                if(parseNumber(q, lineEnd, r) && parseNumber(q, lineEnd, g) && parseNumber(q, lineEnd, b)){
+                    color = {toColorByte(r), toColorByte(g), toColorByte(b), 255};
+                    chunk.hasColors = true;
+                }
+                chunk.positions.push_back(position);
+                chunk.colors.push_back(color);
+            } else if(line[0] == 'v' && line[1] == 'n'){
+                // "vn x y z"
+                glm::vec3 normal;
+                if(!parseNumber(q, lineEnd, normal.x) || !parseNumber(q, lineEnd, normal.y) || !parseNumber(q, lineEnd, normal.z)){
+                    chunk.error = "invalid normal: " + std::string(line, lineEnd);
+                    return;
+                }
+                chunk.normals.push_back(normal);
+            } else if(line[0] == 'f' && line[1] != 'n'){
+                // "f v1 v2 v3 ...", where each corner is "v", "v/vt", "v//vn" or "v/vt/vn"
+                polygon.clear();
+                while(true){
+                    q = skipSpaces(q, lineEnd);
+                    if(q >= lineEnd) break;
+                    ObjCorner corner = {0, 0, 0};
+                    int32_t index;
+                    if(!parseNumber(q, lineEnd, index) || !readObjIndex(index, chunk.positions.size(), corner.position, corner.flags, RELATIVE_POSITION)){
+                        chunk.error = "invalid face: " + std::string(line, lineEnd);
+                        return;
+                    }
+                    if(q < lineEnd && *q == '/'){
+                        q++;
+                        // The texture coordinates aren't used
+                        int32_t textureCoordinate;
+                        if(q < lineEnd && *q != '/') parseNumber(q, lineEnd, textureCoordinate);
+                        if(q < lineEnd && *q == '/'){
+                            q++;
+                            if(parseNumber(q, lineEnd, index) && readObjIndex(index, chunk.normals.size(), corner.normal, corner.flags, RELATIVE_NORMAL))
+                                corner.flags |= HAS_NORMAL;
+                        }
+                    }
+                    polygon.push_back(corner);
+                }
+                // A polygon with n corners becomes n - 2 triangles that share its first corner
+                for(size_t i = 1; i + 1 < polygon.size(); i++){
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i]);
+                    chunk.corners.push_back(polygon[i + 1]);
+                }
+            }
+        }
+    }
+
+    bool importObj(const MappedFile& file, Mesh& mesh, ThreadPool* threadPool, MeshImportStats& stats) {
+        Clock::time_point start = Clock::now();
+        const char* data = file.getData();
+        size_t size = file.getSize();
+
+        // Each chunk parses the lines that start inside it, so a chunk that starts in the middle of a line
+        // moves its start to the next line (the previous chunk parses that line)
+        auto lineStart = [&](size_t offset) {
+            if(offset == 0 || offset >= size) return data + std::min(offset, size);
+            if(data[offset - 1] == '\n') return data + offset;
+            const char* lineEnd = findLineEnd(data + offset, data + size);
+            return lineEnd < data + size ? lineEnd + 1 : data + size;
+        };
+
+        std::vector<ObjChunk> chunks;
+        if(threadPool){
+            chunks.resize(std::max<size_t>(1, threadPool->getChunkCount(size, MIN_BYTES_PER_CHUNK)));
+            threadPool->parallelFor(size, MIN_BYTES_PER_CHUNK, [&](size_t begin, size_t end, size_t chunk) {
+                parseObjChunk(lineStart(begin), lineStart(end), chunks[chunk]);
+            });
+        } else {
+            chunks.resize(1);
+            parseObjChunk(data, data + size, chunks[0]);
+        }
+
+        // Count the positions, normals and corners before every chunk
+        size_t positionCount = 0, normalCount = 0, cornerCount = 0;
+        bool hasColors = false;
+        for(ObjChunk& chunk : chunks){
+            if(!chunk.error.empty()){
+                std::cerr << chunk.error << std::endl;
+                return false;
+            }
+            chunk.positionOffset = positionCount;
+            chunk.normalOffset = normalCount;
+            chunk.cornerOffset = cornerCount;
+            positionCount += chunk.positions.size();
+            normalCount += chunk.normals.size();
+            cornerCount += chunk.corners.size();
+            hasColors = hasColors || chunk.hasColors;
+        }
+
+        // Faces can use the vertices of any chunk, so all the positions and normals are joined
+        std::vector<glm::vec3> positions(positionCount), normals(normalCount);
+        std::vector<Color> colors(positionCount);
+        forEach(threadPool, chunks.size(), [&](size_t i) {
+            const ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionOffset);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + chunk.positionOffset);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalOffset);
+        });
+
+        // Every corner of every triangle becomes a vertex
+        std::vector<Vertex> corners(cornerCount);
+        std::atomic<bool> invalidIndex{false};
+        forEach(threadPool, chunks.size(), [&](size_t i) {
+            const ObjChunk& chunk = chunks[i];
+            for(size_t c = 0; c < chunk.corners.size(); c++){
+                const ObjCorner& corner = chunk.corners[c];
+                int64_t position = corner.position + (corner.flags & RELATIVE_POSITION ? (int64_t)chunk.positionOffset : 0);
+                if(position < 0 || position >= (int64_t)positionCount){
+                    invalidIndex = true;
+                    return;
+                }
+                Color color = hasColors ? colors[position] : WHITE;
+                if(!hasColors && (corner.flags & HAS_NORMAL)){
+                    int64_t normal = corner.normal + (corner.flags & RELATIVE_NORMAL ? (int64_t)chunk.normalOffset : 0);
+                    if(normal < 0 || normal >= (int64_t)normalCount){
+                        invalidIndex = true;
+                        return;
+                    }
+                    color = colorFromNormal(normals[normal]);
+                }
+                corners[chunk.cornerOffset + c] = makeVertex(positions[position], color);
+            }
+        });
+        if(invalidIndex){
+            std::cerr << "A face uses a vertex that doesn't exist" << std::endl;
+            return false;
+        }
+        stats.parseTime = millisecondsSince(start);
+
+        start = Clock::now();
+        std::vector<uint32_t> indices;
+        weldVertices(corners, threadPool, mesh.vertices, indices);
+        mesh.setIndices(indices);
+        stats.weldTime = millisecondsSince(start);
+        stats.cornerCount = cornerCount;
+        return true;
+    }
+
+    // ---------------- PLY ----------------
+
+    enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+    bool parsePlyType(const std::string& name, PlyType& type) {
+        if(name == "char" || name == "int8") type = PlyType::Int8;
+        else if(name == "uchar" || name == "uint8") type = PlyType::UInt8;
+        else if(name == "short" || name == "int16") type = PlyType::Int16;
+        else if(name == "ushort" || name == "uint16") type = PlyType::UInt16;
+        else if(name == "int" || name == "int32") type = PlyType::Int32;
+        else if(name == "uint" || name == "uint32") type = PlyType::UInt32;
+        else if(name == "float" || name == "float32") type = PlyType::Float32;
+        else if(name == "double" || name == "float64") type = PlyType::Float64;
+        else return false;
+        return true;
+    }
+
+    size_t getPlyTypeSize(PlyType type) {
+        switch(type){
+            case PlyType::Int8: case PlyType::UInt8: return 1;
+            case PlyType::Int16: case PlyType::UInt16: return 2;
+            case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+            default: return 8;
+        }
+    }
+
+    bool isPlyFloat(PlyType type) { return type == PlyType::Float32 || type == PlyType::Float64; }
+
+    double readPlyBinary(const char* p, PlyType type, bool bigEndian) {
+        uint8_t bytes[8];
+        size_t size = getPlyTypeSize(type);
+        std::memcpy(bytes, p, size);
+        if(bigEndian) std::reverse(bytes, bytes + size);
+        switch(type){
+            case PlyType::Int8: { int8_t value; std::memcpy(&value, bytes, 1); return value; }
+            case PlyType::UInt8: return bytes[0];
+            case PlyType::Int16: { int16_t value; std::memcpy(&value, bytes, 2); return value; }
+            case PlyType::UInt16: { uint16_t value; std::memcpy(&value, bytes, 2); return value; }
+            case PlyType::Int32: { int32_t value; std::memcpy(&value, bytes, 4); return value; }
+            case PlyType::UInt32: { uint32_t value; std::memcpy(&value, bytes, 4); return value; }
+            case PlyType::Float32: { float value; std::memcpy(&value, bytes, 4); return value; }
+            default: { double value; std::memcpy(&value, bytes, 8); return value; }
+        }
+    }
+
+    struct PlyProperty {
+        std::string name;
+        PlyType type;
+        bool isList = false;
+        PlyType countType; // The type of the number of values, for lists
+    };
+
+    struct PlyElement {
+        std::string name;
+        size_t count = 0;
+        std::vector<PlyProperty> properties;
+
+        int find(const std::string& propertyName) const {
+            for(size_t i = 0; i < properties.size(); i++) if(properties[i].name == propertyName) return (int)i;
+            return -1;
+        }
+    };
+
+    // Reads the values one by one, in ASCII or in binary
+    struct PlyReader {
+        const char* p;
+        const char* end;
+        bool ascii, bigEndian;
+
+        bool read(PlyType type, double& value) {
+            if(ascii){
+                // In ASCII files, the values are separated by spaces or new lines
+                while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+                return parseNumber(p, end, value);
+            }
+            size_t size = getPlyTypeSize(type);
+            if((size_t)(end - p) < size) return false;
+            value = readPlyBinary(p, type, bigEndian);
+            p += size;
+            return true;
+        }
+
+        // Reads all the properties of 1 item of an element, "values" gets the first value of every property
+        // and "list" gets the values of the list property "listIndex"
+        bool readItem(const PlyElement& element, double* values, int listIndex, std::vector<uint32_t>& list) {
+            for(size_t i = 0; i < element.properties.size(); i++){
+                const PlyProperty& property = element.properties[i];
+                if(!property.isList){
+                    if(!read(property.type, values[i])) return false;
+                    continue;
+                }
+                double count;
+                if(!read(property.countType, count) || count < 0) return false;
+                if((int)i == listIndex) list.resize((size_t)count);
+                for(size_t j = 0; j < (size_t)count; j++){
+                    double value;
+                    if(!read(property.type, value)) return false;
+                    if((int)i == listIndex) list[j] = (uint32_t)value;
+                }
+            }
+            return true;
+        }
+    };
+
+    bool importPly(const MappedFile& file, Mesh& mesh, ThreadPool* threadPool, MeshImportStats& stats) {
+        Clock::time_point start = Clock::now();
+        const char* data = file.getData();
+        const char* end = data + file.getSize();
+
+        // The header is text, and ends with the line "end_header"
+        const char* headerEnd = nullptr;
+        for(const char* line = data; line < end; ){
+            const char* lineEnd = findLineEnd(line, end);
+            if(std::string(line, lineEnd).rfind("end_header", 0) == 0){
+                headerEnd = lineEnd < end ? lineEnd + 1 : end;
+                break;
+            }
+            line = lineEnd + 1;
+        }
+        if(!headerEnd || std::string(data, std::min<size_t>(3, end - data)) != "ply"){
+            std::cerr << "Not a PLY file" << std::endl;
+            return false;
+        }
+
+        std::istringstream header(std::string(data, headerEnd));
+        std::vector<PlyElement> elements;
+        std::string format, line;
+        while(std::getline(header, line)){
+            std::istringstream words(line);
+            std::string keyword;
+            words >> keyword;
+            if(keyword == "format"){
+                words >> format;
+            } else if(keyword == "element"){
+                elements.emplace_back();
+                words >> elements.back().name >> elements.back().count;
+            } else if(keyword == "property" && !elements.empty()){
+                PlyProperty property;
+                std::string type;
+                words >> type;
+                if(type == "list"){
+                    std::string countType;
+                    words >> countType >> type;
+                    property.isList = true;
+                    if(!parsePlyType(countType, property.countType)) type.clear();
+                }
+                words >> property.name;
+                if(!parsePlyType(type, property.type)){
+                    std::cerr << "Unsupported PLY property: " << line << std::endl;
+                    return false;
+                }
+                elements.back().properties.push_back(property);
+            }
+        }
+        if(format != "ascii" && format != "binary_little_endian" && format != "binary_big_endian"){
+            std::cerr << "Unsupported PLY format: " << format << std::endl;
+            return false;
+        }
+        PlyReader reader = {headerEnd, end, format == "ascii", format == "binary_big_endian"};
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> faceIndices; // 3 per triangle, indices of "vertices"
+        for(const PlyElement& element : elements){
+            if(element.name == "vertex"){
+                int x = element.find("x"), y = element.find("y"), z = element.find("z");
+                if(x < 0 || y < 0 || z < 0){
+                    std::cerr << "The PLY vertices have no position" << std::endl;
+                    return false;
+                }
+                int color[4] = {element.find("red"), element.find("green"), element.find("blue"), element.find("alpha")};
+                int normal[3] = {element.find("nx"), element.find("ny"), element.find("nz")};
+                bool hasColors = color[0] >= 0 && color[1] >= 0 && color[2] >= 0;
+                bool hasNormals = normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0;
+
+                // Colors are bytes (0 to 255) or floats (0 to 1)
+                auto toVertex = [&](const double* values) {
+                    glm::vec3 position((float)values[x], (float)values[y], (float)values[z]);
+                    Color vertexColor = WHITE;
+                    if(hasColors){
+                        uint8_t channels[4] = {255, 255, 255, 255};
+                        for(int c = 0; c < 4; c++){
+                            if(color[c] < 0) continue;
+                            double value = values[color[c]];
+                            channels[c] = isPlyFloat(element.properties[color[c]].type) ? toColorByte(value) : (uint8_t)std::clamp(value, 0.0, 255.0);
+                        }
+                        vertexColor = {channels[0], channels[1], channels[2], channels[3]};
+                    } else if(hasNormals){
+                        vertexColor = colorFromNormal(glm::vec3(values[normal[0]], values[normal[1]], values[normal[2]]));
+                    }
+                    return makeVertex(position, vertexColor);
+                };
+
+                vertices.resize(element.count);
+                bool hasLists = std::any_of(element.properties.begin(), element.properties.end(), [](const PlyProperty& p) { return p.isList; });
+                if(!reader.ascii && !hasLists){
+                    // Binary vertices all have the same size, so vertex i is at i * stride and they can be decoded in parallel
+                    std::vector<size_t> offsets;
+                    size_t stride = 0;
+                    for(const PlyProperty& property : element.properties){
+                        offsets.push_back(stride);
+                        stride += getPlyTypeSize(property.type);
+                    }
+                    if((size_t)(end - reader.p) < stride * element.count){
+                        std::cerr << "The PLY file is too short" << std::endl;
+                        return false;
+                    }
+                    const char* first = reader.p;
+                    auto decode = [&](size_t begin, size_t last) {
+                        std::vector<double> values(element.properties.size());
+                        for(size_t i = begin; i < last; i++){
+                            const char* item = first + i * stride;
+                            for(size_t property = 0; property < values.size(); property++)
+                                values[property] = readPlyBinary(item + offsets[property], element.properties[property].type, reader.bigEndian);
+                            vertices[i] = toVertex(values.data());
+                        }
+                    };
+                    if(threadPool){
+                        threadPool->parallelFor(element.count, MIN_VERTICES_PER_CHUNK, [&](size_t begin, size_t last, size_t) { decode(begin, last); });
+                    } else {
+                        decode(0, element.count);
+                    }
+                    reader.p += stride * element.count;
+                } else {
+                    std::vector<double> values(element.properties.size());
+                    std::vector<uint32_t> unused;
+                    for(size_t i = 0; i < element.count; i++){
+                        if(!reader.readItem(element, values.data(), -1, unused)){
+                            std::cerr << "Invalid PLY vertex " << i << std::endl;
+                            return false;
+                        }
+                        vertices[i] = toVertex(values.data());
+                    }
+                }
+            } else if(element.name == "face"){
+                int list = element.find("vertex_indices");
+                if(list < 0) list = element.find("vertex_index");
+                if(list < 0 || !element.properties[list].isList){
+                    std::cerr << "The PLY faces have no vertex indices" << std::endl;
+                    return false;
+                }
+                std::vector<double> values(element.properties.size());
+                std::vector<uint32_t> polygon;
+                faceIndices.reserve(3 * element.count);
+                for(size_t i = 0; i < element.count; i++){
+                    if(!reader.readItem(element, values.data(), list, polygon)){
+                        std::cerr << "Invalid PLY face " << i << std::endl;
+                        return false;
+                    }
+                    for(size_t c = 1; c + 1 < polygon.size(); c++){
+                        faceIndices.push_back(polygon[0]);
+                        faceIndices.push_back(polygon[c]);
+                        faceIndices.push_back(polygon[c + 1]);
+                    }
+                }
+            } else {
+                // Other elements (edges, materials, ...) are skipped
+                std::vector<double> values(element.properties.size());
+                std::vector<uint32_t> unused;
+                for(size_t i = 0; i < element.count; i++){
+                    if(!reader.readItem(element, values.data(), -1, unused)){
+                        std::cerr << "Invalid PLY element " << element.name << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+        for(uint32_t index : faceIndices){
+            if(index >= vertices.size()){
+                std::cerr << "A face uses a vertex that doesn't exist" << std::endl;
+                return false;
+            }
+        }
+        stats.parseTime = millisecondsSince(start);
+
+        // PLY vertices are already shared between the faces, but files often have copies of the same vertex
+        start = Clock::now();
+        std::vector<uint32_t> remap;
+        weldVertices(vertices, threadPool, mesh.vertices, remap);
+        for(uint32_t& index : faceIndices) index = remap[index];
+        mesh.setIndices(faceIndices);
+        stats.weldTime = millisecondsSince(start);
+        stats.cornerCount = faceIndices.size();
+        return true;
+    }
+}
+
+bool importMesh(const std::string& path, Mesh& mesh, ThreadPool* threadPool, MeshImportStats* stats) {
+    Clock::time_point start = Clock::now();
+    MeshImportStats localStats;
+    if(!stats) stats = &localStats;
+    *stats = MeshImportStats();
+    stats->threadCount = threadPool ? threadPool->getThreadCount() : 1;
+
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    if(extension != "obj" && extension != "ply"){
+        std::cerr << "Unsupported mesh format: " << path << std::endl;
+        return false;
+    }
+
+    MappedFile file;
+    if(!file.open(path)) return false;
+    stats->fileSize = file.getSize();
+
+    mesh = Mesh();
+    bool success = extension == "obj" ? importObj(file, mesh, threadPool, *stats) : importPly(file, mesh, threadPool, *stats);
+    if(!success){
+        std::cerr << "Failed to import " << path << std::endl;
+        mesh = Mesh();
+        return false;
+    }
+    stats->totalTime = millisecondsSince(start);
+    return true;
+}
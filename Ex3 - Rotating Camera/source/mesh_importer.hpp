@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include "mesh.hpp"
+#include "thread_pool.hpp"
+
+// Mesh Importer
+// ----------------
+// Loads a triangle mesh from an OBJ or a PLY file (chosen by the extension of the path).
+//
+// The file is memory mapped (see source/mapped_file.hpp) then parsed in chunks on all the threads of the thread pool:
+// - OBJ: the file is split into chunks of whole lines, every chunk is parsed on its own,
+//   then the indices of the faces are fixed according to the number of vertices in the previous chunks.
+// - PLY: binary vertices are decoded in parallel since they all have the same size, the rest is decoded on 1 thread.
+//
+// Polygons are split into triangles (as a fan around their first corner).
+// Every corner of every triangle becomes a Vertex, and the corners that are exactly the same (same position and color)
+// are welded into 1 vertex using a hash map, so each vertex is stored and transformed by the GPU only once.
+//
+// Colors are read from the file if it has them (PLY red/green/blue/alpha or OBJ "v x y z r g b"),
+// otherwise they are calculated from the normals (if any), otherwise the mesh is white.
+
+struct MeshImportStats {
+    size_t fileSize = 0;
+    // The number of triangle corners before welding
+    size_t cornerCount = 0;
+    unsigned threadCount = 1;
+    double parseTime = 0, weldTime = 0, totalTime = 0; // In milliseconds
+};
+
+// Returns false and prints the error if the file can't be read or isn't valid
+// Without a thread pool, all the work is done on the calling thread
+bool importMesh(const std::string& path, Mesh& mesh, ThreadPool* threadPool = nullptr, MeshImportStats* stats = nullptr);
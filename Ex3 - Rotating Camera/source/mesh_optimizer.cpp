@@ -0,0 +1,241 @@
+#include "mesh_optimizer.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    // Simulates a FIFO cache with timestamps: a vertex is in the cache if less than "cacheSize" vertices
+    // were added after it, so nothing has to be removed from the cache
+    class FifoCache {
+    public:
+        FifoCache(size_t vertexCount, unsigned cacheSize) : addedAt(vertexCount, 0), cacheSize(cacheSize), time(cacheSize) {}
+
+        // Returns true if the vertex wasn't in the cache (the vertex shader must run on it)
+        bool access(uint32_t vertex) {
+            if(time - addedAt[vertex] < cacheSize) return false;
+            addedAt[vertex] = time++;
+            return true;
+        }
+
+        // Empties the cache, as if "cacheSize" other vertices were added
+        void clear() { time += cacheSize; }
+
+    private:
+        std::vector<uint64_t> addedAt;
+        uint64_t cacheSize, time;
+    };
+
+    glm::vec3 getPosition(const Vertex& vertex) { return glm::vec3(vertex.x, vertex.y, vertex.z); }
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    FifoCache cache(vertexCount, cacheSize);
+    for(uint32_t index : indices) stats.transformedVertices += cache.access(index);
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount > 0) stats.acmr = (float)stats.transformedVertices / triangleCount;
+    if(vertexCount > 0) stats.atvr = (float)stats.transformedVertices / vertexCount;
+    return stats;
+}
+
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& clusters, unsigned cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    clusters.clear();
+
+    // The triangles that use every vertex: the triangles of vertex v are adjacency[offsets[v]] to adjacency[offsets[v + 1] - 1]
+    // "live" is the number of triangles of every vertex that are not drawn yet
+    std::vector<uint32_t> live(vertexCount, 0);
+    for(uint32_t index : indices) live[index]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); i++) adjacency[next[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    // The time at which every vertex entered the cache, a vertex is in the cache if time - cacheTime[v] <= cacheSize
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<bool> emitted(triangleCount, false);
+    // The vertices of the last drawn triangles, the order goes back to them when it is stuck
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    size_t cursor = 0;
+    bool startCluster = true;
+
+    // Tipsify: draw all the triangles around a vertex (a fan), then move to the next vertex that is
+    // still in the cache and has few triangles left, so its remaining triangles are drawn before it leaves the cache
+    int64_t fanning = vertexCount > 0 ? 0 : -1;
+    while(fanning >= 0){
+        candidates.clear();
+        for(uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++){
+            uint32_t triangle = adjacency[a];
+            if(emitted[triangle]) continue;
+            emitted[triangle] = true;
+            if(startCluster){
+                clusters.push_back((uint32_t)(output.size() / 3));
+                startCluster = false;
+            }
+            for(int corner = 0; corner < 3; corner++){
+                uint32_t vertex = indices[3 * triangle + corner];
+                output.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                live[vertex]--;
+                if(time - cacheTime[vertex] > cacheSize) cacheTime[vertex] = time++;
+            }
+        }
+
+        // The best next vertex is the oldest one in the cache whose triangles can all be drawn before it leaves the cache
+        // (each triangle adds at most 2 other vertices to the cache)
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for(uint32_t vertex : candidates){
+            if(live[vertex] == 0) continue;
+            int64_t priority = 0;
+            if(time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize) priority = time - cacheTime[vertex];
+            if(priority > bestPriority){
+                best = vertex;
+                bestPriority = priority;
+            }
+        }
+
+        if(best < 0){
+            // Stuck: go back to the most recent vertex that still has triangles, or else to any vertex that has triangles
+            // Its neighbors aren't in the cache anymore, so a new cluster starts
+            startCluster = true;
+            while(!deadEnd.empty() && best < 0){
+                uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if(live[vertex] > 0) best = vertex;
+            }
+            while(best < 0 && cursor < vertexCount){
+                if(live[cursor] > 0) best = (int64_t)cursor;
+                else cursor++;
+            }
+        }
+        fanning = best;
+    }
+    return output;
+}
+
+std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                       const std::vector<uint32_t>& clusters, float threshold, unsigned cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0) return indices;
+    float meshACMR = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+
+    // Split the clusters where the cache has already paid off: once the ACMR of a cluster is close to the ACMR of the whole mesh,
+    // starting a new cluster there (with an empty cache) costs little, and smaller clusters can be sorted better
+    std::vector<uint32_t> starts;
+    FifoCache cache(vertices.size(), cacheSize);
+    for(size_t c = 0; c < clusters.size(); c++){
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        starts.push_back(clusters[c]);
+        cache.clear();
+        size_t misses = 0, triangles = 0;
+        for(size_t t = clusters[c]; t < end; t++){
+            for(int corner = 0; corner < 3; corner++) misses += cache.access(indices[3 * t + corner]);
+            triangles++;
+            if(t + 1 < end && misses <= threshold * meshACMR * triangles){
+                starts.push_back((uint32_t)(t + 1));
+                cache.clear();
+                misses = triangles = 0;
+            }
+        }
+    }
+
+    // The center of the mesh (every triangle weighted by its area)
+    glm::vec3 meshCenter(0);
+    float meshArea = 0;
+    for(size_t t = 0; t < triangleCount; t++){
+        glm::vec3 p0 = getPosition(vertices[indices[3*t]]), p1 = getPosition(vertices[indices[3*t + 1]]), p2 = getPosition(vertices[indices[3*t + 2]]);
+        float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+        meshCenter += area * (p0 + p1 + p2) / 3.0f;
+        meshArea += area;
+    }
+    if(meshArea > 0) meshCenter /= meshArea;
+
+    // A cluster is likely in front of the others if it faces away from the center of the mesh and is far from it,
+    // which is measured by dot(cluster center - mesh center, cluster normal)
+    std::vector<float> sortKeys(starts.size());
+    for(size_t c = 0; c < starts.size(); c++){
+        size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+        glm::vec3 center(0), normal(0);
+        float area = 0;
+        for(size_t t = starts[c]; t < end; t++){
+            glm::vec3 p0 = getPosition(vertices[indices[3*t]]), p1 = getPosition(vertices[indices[3*t + 1]]), p2 = getPosition(vertices[indices[3*t + 2]]);
+            // The length of the cross product is twice the area of the triangle, so the normals are weighted by area too
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(cross);
+            center += triangleArea * (p0 + p1 + p2) / 3.0f;
+            normal += cross;
+            area += triangleArea;
+        }
+        if(area > 0) center /= area;
+        float normalLength = glm::length(normal);
+        if(normalLength > 0) normal /= normalLength;
+        sortKeys[c] = glm::dot(center - meshCenter, normal);
+    }
+
+    std::vector<uint32_t> order(starts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for(uint32_t c : order){
+        size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+        output.insert(output.end(), indices.begin() + 3 * starts[c], indices.begin() + 3 * end);
+    }
+    return output;
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const uint32_t UNUSED = 0xFFFFFFFF;
+    std::vector<uint32_t> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for(uint32_t& index : indices){
+        if(remap[index] == UNUSED){
+            remap[index] = (uint32_t)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(reordered);
+}
+
+void optimizeMesh(Mesh& mesh, MeshOptimizationReport* report) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> indices = mesh.getIndices();
+    VertexCacheStats before = analyzeVertexCache(indices, mesh.vertices.size());
+
+    std::vector<uint32_t> clusters;
+    indices = optimizeVertexCache(indices, mesh.vertices.size(), clusters);
+    indices = optimizeOverdraw(indices, mesh.vertices, clusters);
+    // This must be last, since it depends on the final order of the triangles
+    optimizeVertexFetch(mesh.vertices, indices);
+    // There may be fewer vertices now, so the indices are set again to pick their type
+    mesh.setIndices(indices);
+
+    if(report){
+        report->before = before;
+        report->after = analyzeVertexCache(indices, mesh.vertices.size());
+        report->clusterCount = clusters.size();
+        report->time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void printMeshOptimizationReport(const MeshOptimizationReport& report) {
+    std::cout << "Optimized the mesh in " << report.time << " ms (" << report.clusterCount << " clusters)" << std::endl;
+    std::cout << "  ACMR: " << report.before.acmr << " -> " << report.after.acmr
+              << ", ATVR: " << report.before.atvr << " -> " << report.after.atvr
+              << ", vertex shader runs: " << report.before.transformedVertices << " -> " << report.after.transformedVertices
+              << " (cache of " << VERTEX_CACHE_SIZE << " vertices)" << std::endl;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "mesh.hpp"
+
+// Mesh Optimizer
+// ----------------
+// The order of the triangles and the vertices doesn't change the image, but it changes how fast the GPU draws it:
+//
+// 1. Vertex cache: after the vertex shader runs on a vertex, the GPU keeps the result in a small cache (the post-transform cache).
+//    If the next triangles use the same vertex while it is still in the cache, the vertex shader doesn't run again.
+//    Reordering the triangles so that neighbors are drawn one after the other (Tipsify, Sander et al. 2007) can run
+//    the vertex shader about once per vertex, instead of up to 3 times per triangle (6 times per vertex) in a bad order.
+//
+// 2. Overdraw: a pixel is shaded again every time a triangle covers it. If the triangles in front are drawn first,
+//    the depth test rejects the pixels of the triangles behind them before they are shaded.
+//    The triangles are split into clusters (small groups that keep the cache order), and the clusters that face outward
+//    from the center of the mesh are drawn first, since they are usually in front of the others.
+//
+// 3. Vertex fetch: the vertices are reordered in the order the triangles first use them,
+//    so the GPU reads the vertex buffer from start to end instead of jumping around in memory.
+//
+// The quality of the order is measured with a simulated FIFO cache:
+// ACMR (average cache miss ratio) = vertex shader runs / triangles, 0.5 is the best possible for big meshes, 3 is the worst
+// ATVR (average transformed vertex ratio) = vertex shader runs / vertices, 1 is the best possible
+
+// A typical size for the post-transform cache of GPUs
+const unsigned VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats {
+    size_t transformedVertices = 0;
+    float acmr = 0, atvr = 0;
+};
+
+// Simulates a FIFO cache of "cacheSize" vertices
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Returns the triangles in the Tipsify order, "clusters" gets the index of the first triangle of every cluster,
+// a new cluster starts every time the order must jump to a part of the mesh that isn't next to the cached vertices
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& clusters,
+                                          unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Splits the clusters further where it costs little to the cache and sorts them so the clusters facing outward are drawn first
+// "threshold" is how much worse than the ACMR of the whole mesh a cluster can get (1.05 = 5% worse)
+std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                       const std::vector<uint32_t>& clusters, float threshold = 1.05f,
+                                       unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders the vertices in the order they are first used by the indices, and changes the indices to match
+// The vertices not used by any triangle are removed
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+struct MeshOptimizationReport {
+    VertexCacheStats before, after;
+    size_t clusterCount = 0;
+    double time = 0; // In milliseconds
+};
+
+// Runs the 3 optimizations on the mesh
+void optimizeMesh(Mesh& mesh, MeshOptimizationReport* report = nullptr);
+
+void printMeshOptimizationReport(const MeshOptimizationReport& report);
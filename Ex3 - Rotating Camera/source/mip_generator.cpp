@@ -0,0 +1,243 @@
+#include "mip_generator.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIP_GENERATOR_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    // The weights of the filter for the source pixels 2x + first ... 2x + first + taps - 1 of the output pixel x
+    struct Kernel {
+        int first;
+        int taps;
+        float weights[6];
+    };
+
+    // The modified Bessel function of the first kind of order 0, used by the Kaiser window
+    double besselI0(double x) {
+        double sum = 1, term = 1;
+        for(int k = 1; k < 32; k++){
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    Kernel makeKernel(MipFilter filter) {
+        if(filter == MipFilter::Box) return {0, 2, {0.5f, 0.5f}};
+
+        // The output pixel x covers the source pixels 2x and 2x + 1, its center is at 2x + 1 in source pixels
+        // The taps are 0.5, 1.5 and 2.5 source pixels away from it on both sides
+        // sinc(d / 2) is the ideal low-pass filter for halving the size, the Kaiser window makes it reach 0 at 3 pixels
+        const double PI = 3.14159265358979323846, RADIUS = 3, BETA = 4;
+        Kernel kernel = {-2, 6, {}};
+        double sum = 0;
+        for(int t = 0; t < kernel.taps; t++){
+            double d = t - 2.5;
+            double x = PI * d / 2;
+            double sinc = std::sin(x) / x;
+            double ratio = d / RADIUS;
+            double window = besselI0(BETA * std::sqrt(1 - ratio * ratio)) / besselI0(BETA);
+            kernel.weights[t] = (float)(sinc * window);
+            sum += kernel.weights[t];
+        }
+        // The weights must add up to 1, or the filter would make the image brighter or darker
+        for(int t = 0; t < kernel.taps; t++) kernel.weights[t] = (float)(kernel.weights[t] / sum);
+        return kernel;
+    }
+
+    int clampIndex(int i, int count) { return std::min(std::max(i, 0), count - 1); }
+
+    // out[x] = sum of weight[t] * line[2x + first + t], for the pixels of 1 row
+    void filterRowScalar(const float* line, int width, float* out, int outWidth, const Kernel& kernel) {
+        for(int x = 0; x < outWidth; x++){
+            float sum[4] = {0, 0, 0, 0};
+            for(int t = 0; t < kernel.taps; t++){
+                const float* pixel = line + 4 * clampIndex(2 * x + kernel.first + t, width);
+                for(int c = 0; c < 4; c++) sum[c] += kernel.weights[t] * pixel[c];
+            }
+            for(int c = 0; c < 4; c++) out[4 * x + c] = sum[c];
+        }
+    }
+
+    // out[x] = sum of weight[t] * rows[t][x], the rows are the source rows of the output row
+    void filterColumnsScalar(const float* const* rows, int width, float* out, const Kernel& kernel) {
+        for(int x = 0; x < width; x++){
+            for(int c = 0; c < 4; c++){
+                float sum = 0;
+                for(int t = 0; t < kernel.taps; t++) sum += kernel.weights[t] * rows[t][4 * x + c];
+                out[4 * x + c] = sum;
+            }
+        }
+    }
+
+#ifdef MIP_GENERATOR_X86
+    // 1 pixel (red, green, blue, alpha) is 1 register
+    void filterRowSSE2(const float* line, int width, float* out, int outWidth, const Kernel& kernel) {
+        __m128 weights[6];
+        for(int t = 0; t < kernel.taps; t++) weights[t] = _mm_set1_ps(kernel.weights[t]);
+        for(int x = 0; x < outWidth; x++){
+            __m128 sum = _mm_setzero_ps();
+            for(int t = 0; t < kernel.taps; t++)
+                sum = _mm_add_ps(sum, _mm_mul_ps(weights[t], _mm_loadu_ps(line + 4 * clampIndex(2 * x + kernel.first + t, width))));
+            _mm_storeu_ps(out + 4 * x, sum);
+        }
+    }
+
+    void filterColumnsSSE2(const float* const* rows, int width, float* out, const Kernel& kernel) {
+        __m128 weights[6];
+        for(int t = 0; t < kernel.taps; t++) weights[t] = _mm_set1_ps(kernel.weights[t]);
+        for(int x = 0; x < width; x++){
+            __m128 sum = _mm_setzero_ps();
+            for(int t = 0; t < kernel.taps; t++) sum = _mm_add_ps(sum, _mm_mul_ps(weights[t], _mm_loadu_ps(rows[t] + 4 * x)));
+            _mm_storeu_ps(out + 4 * x, sum);
+        }
+    }
+#endif
+
+    bool useSSE2() {
+#ifdef MIP_GENERATOR_X86
+        return getSimdLevel() != SimdLevel::Scalar;
+#else
+        return false;
+#endif
+    }
+
+    // Runs function(begin, end) on the rows, split between the threads of the pool if there is one
+    template<typename Function>
+    void forEachRow(int rows, ThreadPool* threadPool, Function function) {
+        if(threadPool){
+            threadPool->parallelFor((size_t)rows, 16, [&](size_t begin, size_t end, size_t) { function((int)begin, (int)end); });
+        } else {
+            function(0, rows);
+        }
+    }
+
+    float srgbToLinear(float value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // pow is slow, so the conversions read tables: 256 entries from sRGB bytes,
+    // and 8192 entries to sRGB bytes (enough that the nearest entry rounds to the same byte, except for rare ties)
+    const int SRGB_TABLE_SIZE = 8192;
+
+    const float* getLinearTable() {
+        static std::vector<float> table = []{
+            std::vector<float> values(256);
+            for(int i = 0; i < 256; i++) values[i] = srgbToLinear(i / 255.0f);
+            return values;
+        }();
+        return table.data();
+    }
+
+    const uint8_t* getSrgbTable() {
+        static std::vector<uint8_t> table = []{
+            std::vector<uint8_t> values(SRGB_TABLE_SIZE);
+            for(int i = 0; i < SRGB_TABLE_SIZE; i++) values[i] = (uint8_t)std::lround(255.0f * linearToSrgb(i / (float)(SRGB_TABLE_SIZE - 1)));
+            return values;
+        }();
+        return table.data();
+    }
+
+    float clamp01(float value) { return std::min(std::max(value, 0.0f), 1.0f); }
+}
+
+bool parseMipFilter(const std::string& name, MipFilter& filter) {
+    if(name == "box") filter = MipFilter::Box;
+    else if(name == "kaiser") filter = MipFilter::Kaiser;
+    else return false;
+    return true;
+}
+
+const char* getMipFilterName(MipFilter filter) {
+    return filter == MipFilter::Kaiser ? "kaiser" : "box";
+}
+
+FloatImage convertToLinear(const Image& image) {
+    const float* table = getLinearTable();
+    FloatImage result;
+    result.width = image.width;
+    result.height = image.height;
+    result.pixels.resize((size_t)image.width * image.height * 4);
+    for(size_t i = 0; i < result.pixels.size(); i += 4){
+        for(int c = 0; c < 3; c++) result.pixels[i + c] = table[image.pixels[i + c]];
+        result.pixels[i + 3] = image.pixels[i + 3] / 255.0f;
+    }
+    return result;
+}
+
+Image convertToSrgb(const FloatImage& image) {
+    const uint8_t* table = getSrgbTable();
+    Image result;
+    result.width = image.width;
+    result.height = image.height;
+    result.pixels.resize((size_t)image.width * image.height * 4);
+    for(size_t i = 0; i < result.pixels.size(); i += 4){
+        for(int c = 0; c < 3; c++) result.pixels[i + c] = table[std::lround(clamp01(image.pixels[i + c]) * (SRGB_TABLE_SIZE - 1))];
+        result.pixels[i + 3] = (uint8_t)std::lround(clamp01(image.pixels[i + 3]) * 255.0f);
+    }
+    return result;
+}
+
+FloatImage downsample(const FloatImage& image, MipFilter filter, ThreadPool* threadPool) {
+    Kernel kernel = makeKernel(filter);
+    bool sse2 = useSSE2();
+    int outWidth = std::max(image.width / 2, 1), outHeight = std::max(image.height / 2, 1);
+
+    // 1. The rows: every row of the image becomes a row of outWidth pixels
+    AlignedFloatVector rows((size_t)outWidth * image.height * 4);
+    forEachRow(image.height, threadPool, [&](int begin, int end){
+        for(int y = begin; y < end; y++){
+            const float* line = image.pixels.data() + (size_t)y * image.width * 4;
+            float* out = rows.data() + (size_t)y * outWidth * 4;
+#ifdef MIP_GENERATOR_X86
+            if(sse2){
+                filterRowSSE2(line, image.width, out, outWidth, kernel);
+                continue;
+            }
+#endif
+            filterRowScalar(line, image.width, out, outWidth, kernel);
+        }
+    });
+
+    // 2. The columns: every output row is the weighted sum of the filtered rows around it
+    FloatImage result;
+    result.width = outWidth;
+    result.height = outHeight;
+    result.pixels.resize((size_t)outWidth * outHeight * 4);
+    forEachRow(outHeight, threadPool, [&](int begin, int end){
+        for(int y = begin; y < end; y++){
+            const float* sources[6];
+            for(int t = 0; t < kernel.taps; t++)
+                sources[t] = rows.data() + (size_t)clampIndex(2 * y + kernel.first + t, image.height) * outWidth * 4;
+            float* out = result.pixels.data() + (size_t)y * outWidth * 4;
+#ifdef MIP_GENERATOR_X86
+            if(sse2){
+                filterColumnsSSE2(sources, outWidth, out, kernel);
+                continue;
+            }
+#endif
+            filterColumnsScalar(sources, outWidth, out, kernel);
+        }
+    });
+    (void)sse2;
+    return result;
+}
+
+std::vector<Image> generateGammaCorrectMipChain(const Image& image, MipFilter filter, ThreadPool* threadPool) {
+    std::vector<Image> mips = {image};
+    FloatImage level = convertToLinear(image);
+    int levels = getMipLevelCount(image.width, image.height);
+    for(int i = 1; i < levels; i++){
+        level = downsample(level, filter, threadPool);
+        mips.push_back(convertToSrgb(level));
+    }
+    return mips;
+}
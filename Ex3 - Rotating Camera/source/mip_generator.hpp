@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "texture.hpp"
+#include "batch_math.hpp"
+#include "thread_pool.hpp"
+
+// Gamma-Correct Mip Generation
+// ----------------
+// The colors of an image are stored in sRGB: the values are not proportional to the light, more values are spent on the dark colors
+// because the eye sees more differences there. Averaging sRGB values (like generateMipChain in source/texture.hpp) makes the
+// small levels darker than the image really looks: the average of black and white in sRGB is 128, which is only 21% of the light.
+// So the pixels are converted to linear floats first, filtered there, and converted back to sRGB for every level.
+// Alpha isn't a color, so it is filtered as it is.
+//
+// 2 filters halve the size of a level:
+// - Box: the average of 2x2 pixels. Fast, but a bit blurry, and fine patterns can turn into wrong coarser patterns (aliasing).
+// - Kaiser: a windowed sinc that reads 6x6 pixels, it keeps the small levels sharper and removes more aliasing.
+//   It can go slightly below 0 or above 1 next to sharp edges, the values are clamped.
+// Both are separable: the rows are filtered first, then the columns of the result, which needs 6 + 6 reads per pixel instead of 36.
+// A pixel is 4 floats (red, green, blue, alpha), exactly 1 SSE2 register, so all the channels are filtered at once.
+// The rows are split between the threads of the pool.
+
+enum class MipFilter { Box, Kaiser };
+
+// Parses "box" or "kaiser", returns false if the name is unknown
+bool parseMipFilter(const std::string& name, MipFilter& filter);
+const char* getMipFilterName(MipFilter filter);
+
+// An image with 4 linear floats per pixel
+struct FloatImage {
+    int width = 0, height = 0;
+    AlignedFloatVector pixels;
+};
+
+FloatImage convertToLinear(const Image& image);
+// Values outside [0, 1] are clamped
+Image convertToSrgb(const FloatImage& image);
+
+// Halves the width and height of the image (a side of 1 pixel stays 1)
+FloatImage downsample(const FloatImage& image, MipFilter filter, ThreadPool* threadPool = nullptr);
+
+// All the levels of the image down to 1x1, level 0 is the image itself
+// Every level is made from the linear floats of the level before it, so the rounding to 8 bits never adds up
+std::vector<Image> generateGammaCorrectMipChain(const Image& image, MipFilter filter, ThreadPool* threadPool = nullptr);
@@ -0,0 +1,145 @@
+#include "program_builder.hpp"
+#include "program_cache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    GLenum getShaderType(const std::string& path) {
+        std::string extension = path.substr(path.find_last_of('.') + 1);
+        if(extension == "vert") return GL_VERTEX_SHADER;
+        if(extension == "frag") return GL_FRAGMENT_SHADER;
+        if(extension == "geom") return GL_GEOMETRY_SHADER;
+        if(extension == "comp") return GL_COMPUTE_SHADER;
+        std::cerr << "Unknown shader type for " << path << std::endl;
+        return GL_VERTEX_SHADER;
+    }
+
+    // Sends the source code to the driver and starts compiling it
+    // Note that we don't query GL_COMPILE_STATUS here, since querying it would wait for the compilation to finish
+    GLuint startCompiling(const std::string& path) {
+        GLuint shader = glCreateShader(getShaderType(path));
+
+        std::ifstream file(path);
+        if(!file) std::cerr << "Failed to open " << path << std::endl;
+        std::string sourceCode = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        const char* sourceCodeCStr = sourceCode.c_str();
+
+        glShaderSource(shader, 1, &sourceCodeCStr, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    std::string getShaderLog(GLuint shader) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(length, '\0');
+        if(length > 0) glGetShaderInfoLog(shader, length, nullptr, log.data());
+        return log;
+    }
+
+    std::string getProgramLog(GLuint program) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string log(length, '\0');
+        if(length > 0) glGetProgramInfoLog(program, length, nullptr, log.data());
+        return log;
+    }
+}
+
+ProgramBuilder::ProgramBuilder() {
+    parallel = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+    // 0xFFFFFFFF lets the driver use as many compiler threads as it wants
+    if(GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    else if(GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+int ProgramBuilder::build(const std::string& name, const std::vector<std::string>& shaderPaths) {
+    Build build;
+    build.name = name;
+    build.program = glCreateProgram();
+    build.cacheKey = getProgramCacheKey(shaderPaths);
+    build.status = Status::Building;
+    build.fromCache = false;
+    build.startTime = std::chrono::steady_clock::now();
+    build.buildTime = 0;
+
+    if(loadProgramBinary(build.program, build.cacheKey)){
+        build.fromCache = true;
+    } else {
+        // Start compiling all the shaders, then link right away
+        // The driver links once the compilation finishes, so nothing here waits for the compiler
+        for(const std::string& path : shaderPaths){
+            GLuint shader = startCompiling(path);
+            glAttachShader(build.program, shader);
+            build.shaders.push_back(shader);
+        }
+        glLinkProgram(build.program);
+    }
+
+    builds.push_back(build);
+    return (int)builds.size() - 1;
+}
+
+void ProgramBuilder::poll() {
+    for(Build& build : builds){
+        if(build.status != Status::Building) continue;
+        if(parallel){
+            GLint completed = GL_FALSE;
+            glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &completed);
+            if(!completed) continue;
+        }
+        finish(build);
+    }
+}
+
+ProgramBuilder::Status ProgramBuilder::wait(int index) {
+    Build& build = builds[index];
+    if(build.status == Status::Building) finish(build);
+    return build.status;
+}
+
+bool ProgramBuilder::isIdle() const {
+    for(const Build& build : builds)
+        if(build.status == Status::Building) return false;
+    return true;
+}
+
+void ProgramBuilder::destroy() {
+    for(Build& build : builds){
+        for(GLuint shader : build.shaders) glDeleteShader(shader);
+        glDeleteProgram(build.program);
+    }
+    builds.clear();
+}
+
+void ProgramBuilder::finish(Build& build) {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(build.program, GL_LINK_STATUS, &linked);
+    build.buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build.startTime).count();
+
+    if(linked){
+        build.status = Status::Ready;
+        if(!build.fromCache) saveProgramBinary(build.program, build.cacheKey);
+        std::cout << "Program \"" << build.name << "\" " << (build.fromCache ? "loaded from cache" : "compiled")
+                  << " in " << build.buildTime << " ms" << std::endl;
+    } else {
+        build.status = Status::Failed;
+        std::cerr << "Program \"" << build.name << "\" failed to build" << std::endl;
+        // Print the errors of the shaders that failed to compile, then the errors of the link step
+        for(GLuint shader : build.shaders){
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if(!compiled) std::cerr << getShaderLog(shader) << std::endl;
+        }
+        std::cerr << getProgramLog(build.program) << std::endl;
+    }
+
+    // The shaders are not needed anymore after linking
+    for(GLuint shader : build.shaders){
+        glDetachShader(build.program, shader);
+        glDeleteShader(shader);
+    }
+    build.shaders.clear();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <glad/gl.h>
+
+// Asynchronous Program Builder
+// ----------------
+// Normally glCompileShader and glLinkProgram block the main thread until the driver finishes compiling.
+// With the extension GL_KHR_parallel_shader_compile, the driver compiles and links on its own threads,
+// and we can ask if it finished using GL_COMPLETION_STATUS_KHR without waiting for it.
+// So we start building all the programs at once, keep rendering with a simple fallback program,
+// and switch to the real program once poll() finds that it is ready.
+// Without the extension, everything still works but each build finishes (synchronously) the first time it is polled.
+//
+// The programs are also stored in the program binary cache, so a program built in a previous run is ready immediately.
+//
+// Usage:
+//      ProgramBuilder builder;
+//      int build = builder.build("simple", {"assets/shaders/simple.vert", "assets/shaders/simple.frag"});
+//      while(...){
+//          builder.poll();
+//          glUseProgram(builder.getProgram(build, fallbackProgram));
+//          ...
+//      }
+//      builder.destroy();
+class ProgramBuilder {
+public:
+    enum class Status { Building, Ready, Failed };
+
+    ProgramBuilder();
+
+    // Starts building a program from the given shader files without waiting for the compilation
+    // The shader type is deduced from the file extension (.vert, .frag)
+    // Returns the index of the build, which is used to query it later
+    int build(const std::string& name, const std::vector<std::string>& shaderPaths);
+
+    // Checks the builds in progress without blocking, should be called once per frame
+    // The compile time of every program that finished is printed to the console
+    void poll();
+
+    // Blocks until the given build finishes, useful for small programs that are needed right away (e.g. the fallback)
+    Status wait(int build);
+
+    Status getStatus(int build) const { return builds[build].status; }
+
+    // Returns the program if it is ready, otherwise returns "fallback"
+    GLuint getProgram(int build, GLuint fallback = 0) const {
+        return builds[build].status == Status::Ready ? builds[build].program : fallback;
+    }
+
+    // The time from calling build() until the program was found to be ready (in milliseconds)
+    double getBuildTime(int build) const { return builds[build].buildTime; }
+
+    // Returns true if no build is still in progress
+    bool isIdle() const;
+
+    // Deletes all the programs created by this builder, must be called before the OpenGL context is destroyed
+    void destroy();
+
+private:
+    struct Build {
+        std::string name;
+        GLuint program;
+        std::vector<GLuint> shaders;
+        std::string cacheKey;
+        Status status;
+        bool fromCache;
+        std::chrono::steady_clock::time_point startTime;
+        double buildTime;
+    };
+
+    // Reads the link status of a build (which may block if the driver didn't finish) and reports it
+    void finish(Build& build);
+
+    std::vector<Build> builds;
+    // True if the driver supports parallel shader compilation
+    bool parallel;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+
+// Program Binary Cache
+// ----------------
+// Compiling and linking shaders from source is slow, and it is repeated on every launch.
+// After a program is linked, the driver can give us the compiled program as a binary blob (glGetProgramBinary).
+// We save this blob in a file, and on the next launch we give it back to the driver (glProgramBinary) instead of compiling.
+//
+// The binary only works for the same shader sources on the same driver,
+// so the file name is a hash of the shader sources together with the vendor, renderer and version strings of the driver.
+// If the driver still rejects the binary (e.g. after a driver update), we fall back to compiling from source.
+//
+// Usage:
+//      std::string cacheKey = getProgramCacheKey({"assets/shaders/simple.vert", "assets/shaders/simple.frag"});
+//      if(!loadProgramBinary(program, cacheKey)){
+//          ... attach the shaders and link the program as usual ...
+//          saveProgramBinary(program, cacheKey);
+//      }
+
+// The folder where the program binaries are stored (relative to the working directory)
+const std::string PROGRAM_CACHE_DIRECTORY = "cache";
+
+// Returns a key (hexadecimal hash) for a program built from the given shader files on the current driver
+// Must be called after the OpenGL context is created, since it reads the driver strings
+std::string getProgramCacheKey(const std::vector<std::string>& shaderPaths);
+
+// Tries to load the cached binary of the program into "program"
+// Returns true if the program is now linked and ready to use
+// Returns false if there is no cached binary or the driver rejected it, then the program must be built from source
+// In that case, the program is marked as retrievable so that its binary can be saved after linking it
+bool loadProgramBinary(GLuint program, const std::string& cacheKey);
+
+// Saves the binary of a linked program to the cache, so that the next launch can skip compiling it
+// Does nothing if the program failed to link or the driver doesn't support program binaries
+void saveProgramBinary(GLuint program, const std::string& cacheKey);
@@ -0,0 +1,99 @@
+#include "render_queue.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    // The highest DEPTH_BITS bits of the float, which are in the same order as the floats since they are positive
+    uint64_t quantizeDepth(float depth) {
+        depth = std::max(depth, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &depth, 4);
+        return bits >> (32 - RenderQueue::DEPTH_BITS);
+    }
+
+    uint64_t mask(uint32_t value, int bits) { return value & ((1u << bits) - 1); }
+}
+
+RenderQueue::RenderQueue(size_t capacity) : commands(capacity), entries(capacity), sorted(capacity) {}
+
+void RenderQueue::clear() {
+    count = 0;
+    counters = Counters();
+}
+
+uint64_t RenderQueue::makeOpaqueKey(uint32_t program, uint32_t vertexArray, uint32_t material, float depth) {
+    uint64_t key = 0;
+    key = (key << PROGRAM_BITS) | mask(program, PROGRAM_BITS);
+    key = (key << VERTEX_ARRAY_BITS) | mask(vertexArray, VERTEX_ARRAY_BITS);
+    key = (key << MATERIAL_BITS) | mask(material, MATERIAL_BITS);
+    key = (key << DEPTH_BITS) | quantizeDepth(depth);
+    // The unused bits at the bottom
+    return key << (63 - PROGRAM_BITS - VERTEX_ARRAY_BITS - MATERIAL_BITS - DEPTH_BITS);
+}
+
+uint64_t RenderQueue::makeTransparentKey(uint32_t program, uint32_t vertexArray, uint32_t material, float depth) {
+    uint64_t key = 1;
+    // Inverting the depth bits puts the far draws first
+    key = (key << DEPTH_BITS) | (~quantizeDepth(depth) & ((1u << DEPTH_BITS) - 1));
+    key = (key << PROGRAM_BITS) | mask(program, PROGRAM_BITS);
+    key = (key << VERTEX_ARRAY_BITS) | mask(vertexArray, VERTEX_ARRAY_BITS);
+    key = (key << MATERIAL_BITS) | mask(material, MATERIAL_BITS);
+    return key << (63 - PROGRAM_BITS - VERTEX_ARRAY_BITS - MATERIAL_BITS - DEPTH_BITS);
+}
+
+void RenderQueue::sort() {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Least significant digit radix sort: the entries are sorted by byte 0, then by byte 1 keeping the order of byte 0, ...
+    // The histograms of all the bytes are counted in 1 pass over the keys
+    size_t histograms[8][256] = {};
+    for(size_t i = 0; i < count; i++){
+        uint64_t key = entries[i].key;
+        for(int b = 0; b < 8; b++) histograms[b][(key >> (8 * b)) & 0xFF]++;
+    }
+
+    Entry* source = entries.data();
+    Entry* destination = sorted.data();
+    for(int b = 0; b < 8; b++){
+        size_t* histogram = histograms[b];
+        // All the keys have the same byte, so this pass wouldn't change the order
+        if(count == 0 || histogram[(source[0].key >> (8 * b)) & 0xFF] == count) continue;
+
+        // The first position of every byte value in the output
+        size_t offset = 0;
+        for(int value = 0; value < 256; value++){
+            size_t valueCount = histogram[value];
+            histogram[value] = offset;
+            offset += valueCount;
+        }
+        for(size_t i = 0; i < count; i++){
+            const Entry& entry = source[i];
+            destination[histogram[(entry.key >> (8 * b)) & 0xFF]++] = entry;
+        }
+        std::swap(source, destination);
+    }
+    // After an odd number of passes, the sorted entries are in the other array
+    if(source != entries.data()) std::copy(source, source + count, entries.data());
+
+    counters.sortTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderQueue::submit(RenderState& state) {
+    GLuint lastProgram = 0, lastVertexArray = 0;
+    for(size_t i = 0; i < count; i++){
+        const DrawCommand& command = commands[entries[i].command];
+        if(i == 0 || command.program != lastProgram) counters.programSwitches++;
+        if(i == 0 || command.vertexArray != lastVertexArray) counters.vertexArraySwitches++;
+        lastProgram = command.program;
+        lastVertexArray = command.vertexArray;
+
+        // The state cache skips the calls when the program or the vertex array is the same as the last draw
+        state.useProgram(command.program);
+        state.bindVertexArray(command.vertexArray);
+        state.bindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UNIFORMS_BINDING, command.uniformBuffer, command.uniformOffset, sizeof(ObjectUniforms));
+        glDrawElementsBaseVertex(GL_TRIANGLES, command.indexCount, command.indexType, (void*)command.indexOffset, command.baseVertex);
+    }
+    counters.draws += count;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/gl.h>
+#include "render_state.hpp"
+#include "uniform_buffers.hpp"
+
+// Render Queue
+// ----------------
+// Changing the program or the vertex array between 2 draw calls is one of the most expensive things the driver does,
+// but the order in which the loop visits the objects has nothing to do with the state they need.
+// Instead of drawing right away, every draw is pushed into a queue with a 64-bit sort key, then the queue is sorted
+// and drawn in the order of the keys. The key is built so that sorting it puts the draws in the best order:
+//
+// Opaque draws (bit 63 = 0):      | 0 | program (10) | vertex array (10) | material (12) | depth (24) | unused (7) |
+// Transparent draws (bit 63 = 1): | 1 | far to near depth (24) | program (10) | vertex array (10) | material (12) | unused (7) |
+//
+// - The opaque draws are drawn first, grouped by program then vertex array then material, so each one is switched as few
+//   times as possible. Inside a group they are drawn from near to far. This only pays off when the depth test is enabled
+//   (GL_LESS with depth writes): the near draws then fill the depth buffer first, and the GPU rejects the hidden pixels of
+//   the far ones before shading them. Without the depth test the order decides what is seen, and the far draws would
+//   cover the near ones, so the opaque keys must only be used with it.
+// - The transparent draws are drawn after, from far to near, since blending is only correct in that order.
+// The program, vertex array and material in the key are small numbers (0, 1, 2, ...) chosen by the caller, not OpenGL names.
+// The depth is the distance to the camera, for positive floats the order of their bits is the order of their values,
+// so the highest 24 bits of the float are used directly.
+//
+// The keys are sorted with a radix sort (8 passes of 8 bits), which takes the same time whatever the order of the draws,
+// and the passes where all the keys have the same byte are skipped.
+// All the memory is allocated when the queue is created, so pushing, sorting and drawing never allocate.
+
+// Everything needed to draw 1 object with glDrawElementsBaseVertex
+struct DrawCommand {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint uniformBuffer;      // The buffer and the offset of the Object block of the draw (see source/uniform_buffers.hpp)
+    size_t uniformOffset;
+    GLenum indexType;
+    GLsizei indexCount;
+    size_t indexOffset;        // In bytes
+    GLint baseVertex;
+};
+
+class RenderQueue {
+public:
+    static const int PROGRAM_BITS = 10;
+    static const int VERTEX_ARRAY_BITS = 10;
+    static const int MATERIAL_BITS = 12;
+    static const int DEPTH_BITS = 24;
+
+    struct Counters {
+        size_t draws = 0;
+        size_t programSwitches = 0;
+        size_t vertexArraySwitches = 0;
+        size_t dropped = 0;        // The draws pushed when the queue was full
+        double sortTime = 0;       // In milliseconds
+    };
+
+    explicit RenderQueue(size_t capacity);
+
+    // Empties the queue and resets the counters, call it at the start of every frame
+    void clear();
+
+    // Returns false (and drops the draw) if the queue is full
+    bool push(uint64_t key, const DrawCommand& command) {
+        if(count == commands.size()){
+            counters.dropped++;
+            return false;
+        }
+        commands[count] = command;
+        entries[count] = {key, (uint32_t)count};
+        count++;
+        return true;
+    }
+
+    // Sorts the draws by key, the draws with the same key keep the order they were pushed in
+    void sort();
+
+    // Draws all the draws in the order of the keys (call sort first), and counts the program and vertex array switches
+    void submit(RenderState& state);
+
+    size_t size() const { return count; }
+    size_t getCapacity() const { return commands.size(); }
+    // The i-th draw in the order of the keys (after sort)
+    const DrawCommand& getCommand(size_t i) const { return commands[entries[i].command]; }
+    uint64_t getKey(size_t i) const { return entries[i].key; }
+    const Counters& getCounters() const { return counters; }
+
+    // "depth" is the distance from the camera, negative depths are treated as 0
+    static uint64_t makeOpaqueKey(uint32_t program, uint32_t vertexArray, uint32_t material, float depth);
+    static uint64_t makeTransparentKey(uint32_t program, uint32_t vertexArray, uint32_t material, float depth);
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t command;
+    };
+
+    std::vector<DrawCommand> commands;
+    std::vector<Entry> entries, sorted;
+    size_t count = 0;
+    Counters counters;
+};
@@ -0,0 +1,134 @@
+#include "render_state.hpp"
+
+void RenderState::invalidate() {
+    program.known = false;
+    vertexArray.known = false;
+    for(Cached<GLuint>& buffer : buffers) buffer.known = false;
+    for(Cached<BufferRange>& range : uniformRanges) range.known = false;
+    activeTexture.known = false;
+    for(auto& unit : textures) for(Cached<GLuint>& texture : unit) texture.known = false;
+    for(Cached<bool>& capability : capabilities) capability.known = false;
+    blend.known = false;
+    depthFunction.known = false;
+    depthWrite.known = false;
+    cullMode.known = false;
+    viewportRect.known = false;
+    clear.known = false;
+}
+
+int RenderState::getBufferSlot(GLenum target) {
+    switch(target){
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_SHADER_STORAGE_BUFFER: return 3;
+        case GL_DRAW_INDIRECT_BUFFER: return 4;
+        case GL_PIXEL_UNPACK_BUFFER: return 5;
+        case GL_COPY_WRITE_BUFFER: return 6;
+        default: return -1;
+    }
+}
+
+int RenderState::getTextureSlot(GLenum target) {
+    switch(target){
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_3D: return 2;
+        case GL_TEXTURE_CUBE_MAP: return 3;
+        default: return -1;
+    }
+}
+
+int RenderState::getCapabilitySlot(GLenum capability) {
+    switch(capability){
+        case GL_BLEND: return 0;
+        case GL_DEPTH_TEST: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        default: return -1;
+    }
+}
+
+void RenderState::useProgram(GLuint value) {
+    if(change(program, value)) glUseProgram(value);
+}
+
+void RenderState::bindVertexArray(GLuint value) {
+    if(change(vertexArray, value)){
+        glBindVertexArray(value);
+        buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)].known = false;
+    }
+}
+
+void RenderState::bindBuffer(GLenum target, GLuint buffer) {
+    int slot = getBufferSlot(target);
+    if(slot < 0){
+        counters.issued++;
+        glBindBuffer(target, buffer);
+    } else if(change(buffers[slot], buffer)){
+        glBindBuffer(target, buffer);
+    }
+}
+
+void RenderState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    counters.issued++;
+    glBindBufferBase(target, index, buffer);
+    int slot = getBufferSlot(target);
+    if(slot >= 0) buffers[slot] = {buffer, true};
+    // The whole buffer is bound, which isn't a range the cache can compare with
+    if(target == GL_UNIFORM_BUFFER && index < (GLuint)UNIFORM_BINDING_COUNT) uniformRanges[index].known = false;
+}
+
+void RenderState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    if(target == GL_UNIFORM_BUFFER && index < (GLuint)UNIFORM_BINDING_COUNT){
+        if(!change(uniformRanges[index], BufferRange{buffer, offset, size})) return;
+    } else {
+        counters.issued++;
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+    int slot = getBufferSlot(target);
+    if(slot >= 0) buffers[slot] = {buffer, true};
+}
+
+void RenderState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if(change(activeTexture, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+    int slot = getTextureSlot(target);
+    if(slot < 0 || unit >= (GLuint)TEXTURE_UNIT_COUNT){
+        counters.issued++;
+        glBindTexture(target, texture);
+    } else if(change(textures[unit][slot], texture)){
+        glBindTexture(target, texture);
+    }
+}
+
+void RenderState::setEnabled(GLenum capability, bool enabled) {
+    int slot = getCapabilitySlot(capability);
+    if(slot >= 0 && !change(capabilities[slot], enabled)) return;
+    if(slot < 0) counters.issued++;
+    if(enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void RenderState::blendFunc(GLenum source, GLenum destination) {
+    if(change(blend, BlendFunction{source, destination})) glBlendFunc(source, destination);
+}
+
+void RenderState::depthFunc(GLenum function) {
+    if(change(depthFunction, function)) glDepthFunc(function);
+}
+
+void RenderState::depthMask(bool write) {
+    if(change(depthWrite, write)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void RenderState::cullFace(GLenum face) {
+    if(change(cullMode, face)) glCullFace(face);
+}
+
+void RenderState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if(change(viewportRect, Rect{x, y, width, height})) glViewport(x, y, width, height);
+}
+
+void RenderState::clearColor(float r, float g, float b, float a) {
+    if(change(clear, Color{r, g, b, a})) glClearColor(r, g, b, a);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/gl.h>
+
+// Render State Cache
+// ----------------
+// OpenGL is a state machine: glUseProgram, glBindVertexArray, glEnable, ... change the state, and the draw calls use it.
+// Every one of these calls costs CPU time in the driver (it checks the parameters and often marks the state as changed
+// so it is validated again at the next draw call), even when the new value is the same as the old one.
+// A render loop usually sets the whole state it needs every frame, since it can't know what changed since the last frame.
+//
+// RenderState remembers the last value of every state it sets, and only calls OpenGL when the value really changes.
+// The state is unknown at first (something else may have changed it), so the first call always goes to OpenGL.
+// All the state changes must then go through it, or invalidate() must be called after changing the state directly.
+//
+// The counters show how many calls were sent to OpenGL (issued) and how many were skipped since beginFrame().
+class RenderState {
+public:
+    struct Counters {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    // The number of texture units tracked, the texture bindings of higher units always go to OpenGL
+    static const int TEXTURE_UNIT_COUNT = 16;
+    // The number of uniform buffer binding points tracked
+    static const int UNIFORM_BINDING_COUNT = 8;
+
+    RenderState() { invalidate(); }
+
+    // Forgets all the cached state, so the next call of every function goes to OpenGL
+    void invalidate();
+
+    // Resets the counters
+    void beginFrame() { counters = Counters(); }
+    const Counters& getCounters() const { return counters; }
+
+    void useProgram(GLuint program);
+    // The GL_ELEMENT_ARRAY_BUFFER binding belongs to the vertex array, so it is forgotten when the vertex array changes
+    void bindVertexArray(GLuint vertexArray);
+    // Tracks GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER,
+    // GL_DRAW_INDIRECT_BUFFER, GL_PIXEL_UNPACK_BUFFER and GL_COPY_WRITE_BUFFER, the other targets always go to OpenGL
+    void bindBuffer(GLenum target, GLuint buffer);
+    // glBindBufferBase always goes to OpenGL, it also binds the buffer to the generic target, which the cache remembers
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // Skips the call if the binding point already has the same range, for the first UNIFORM_BINDING_COUNT uniform binding points
+    // Like glBindBufferBase, it also binds the buffer to the generic target
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // Calls glActiveTexture only if the unit changes, then glBindTexture only if the texture of this unit and target changes
+    // Tracks GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D and GL_TEXTURE_CUBE_MAP
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // glEnable / glDisable of GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE and GL_SCISSOR_TEST
+    void setEnabled(GLenum capability, bool enabled);
+    void blendFunc(GLenum source, GLenum destination);
+    void depthFunc(GLenum function);
+    void depthMask(bool write);
+    void cullFace(GLenum face);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void clearColor(float r, float g, float b, float a);
+
+private:
+    // A cached value, "known" is false until it is set once (or after invalidate)
+    template<typename T>
+    struct Cached {
+        T value;
+        bool known;
+    };
+
+    // Returns true if the value changed (so the caller must call OpenGL), and counts the call as issued or skipped
+    template<typename T>
+    bool change(Cached<T>& cached, const T& value) {
+        if(cached.known && cached.value == value){
+            counters.skipped++;
+            return false;
+        }
+        cached.value = value;
+        cached.known = true;
+        counters.issued++;
+        return true;
+    }
+
+    struct Rect {
+        GLint x, y;
+        GLsizei width, height;
+        bool operator==(const Rect& other) const { return x == other.x && y == other.y && width == other.width && height == other.height; }
+    };
+    struct Color {
+        float r, g, b, a;
+        bool operator==(const Color& other) const { return r == other.r && g == other.g && b == other.b && a == other.a; }
+    };
+    struct BufferRange {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+        bool operator==(const BufferRange& other) const { return buffer == other.buffer && offset == other.offset && size == other.size; }
+    };
+    struct BlendFunction {
+        GLenum source, destination;
+        bool operator==(const BlendFunction& other) const { return source == other.source && destination == other.destination; }
+    };
+
+    static const int BUFFER_TARGET_COUNT = 7;
+    static const int TEXTURE_TARGET_COUNT = 4;
+    static const int CAPABILITY_COUNT = 4;
+    // Returns the slot of the target or capability in the arrays below, or -1 if it isn't tracked
+    static int getBufferSlot(GLenum target);
+    static int getTextureSlot(GLenum target);
+    static int getCapabilitySlot(GLenum capability);
+
+    Cached<GLuint> program;
+    Cached<GLuint> vertexArray;
+    Cached<GLuint> buffers[BUFFER_TARGET_COUNT];
+    Cached<BufferRange> uniformRanges[UNIFORM_BINDING_COUNT];
+    Cached<GLuint> activeTexture;
+    Cached<GLuint> textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+    Cached<bool> capabilities[CAPABILITY_COUNT];
+    Cached<BlendFunction> blend;
+    Cached<GLenum> depthFunction;
+    Cached<bool> depthWrite;
+    Cached<GLenum> cullMode;
+    Cached<Rect> viewportRect;
+    Cached<Color> clear;
+
+    Counters counters;
+};
@@ -0,0 +1,465 @@
+#include "software_rasterizer.hpp"
+#include "batch_math.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SOFTWARE_RASTERIZER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double getMilliseconds(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // The triangles of a chunk in the setup pass, enough to keep the threads busy without making too many lists
+    const size_t SETUP_CHUNK_SIZE = 1024;
+    // The clip planes: near, far, then the guard band on the left, right, bottom and top
+    const int CLIP_PLANE_COUNT = 6;
+    // Clipping a triangle by 6 planes adds at most 1 vertex per plane
+    const int MAX_CLIPPED_VERTICES = 3 + CLIP_PLANE_COUNT;
+    // The farthest a vertex may be outside the screen, in pixels
+    // With 4 fractional bits, the corners stay below 2^17 and the edge values of a partly covered tile fit in 32 bits
+    const float GUARD_BAND_PIXELS = 4096;
+    const int SUBPIXELS = 1 << SoftwareRasterizer::SUBPIXEL_BITS;
+
+    // What the fill functions need to know about 1 triangle inside 1 tile
+    struct TriangleSpans {
+        // The pixels to fill (the last ones included), "startX" is "minX" rounded down to a multiple of 4
+        int startX, minX, maxX, minY, maxY;
+        // The 3 edge values at the center of pixel (startX, minY), and how much they change from 1 pixel to the next
+        int32_t start[3], stepX[3], stepY[3];
+        float originX, originY;
+        const float* value;
+        const float* dx;
+        const float* dy;
+    };
+
+    // Rounds to the nearest integer like _mm_cvtps_epi32 (ties to even), so both versions make the same image
+    uint32_t toByte(float value) {
+        return (uint32_t)std::nearbyint(std::min(std::max(value, 0.0f), 255.0f));
+    }
+
+    uint32_t packColor(float r, float g, float b, float a) {
+        return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+    }
+
+    // ---------------- Scalar ----------------
+
+    void fillScalar(const TriangleSpans& spans, uint32_t* pixels, int stride) {
+        int32_t row[3] = {spans.start[0], spans.start[1], spans.start[2]};
+        for(int y = spans.minY; y <= spans.maxY; y++){
+            int32_t edge[3] = {row[0], row[1], row[2]};
+            // The values at x = originX on this row, only the x part changes along the row
+            // (the SSE2 version does the same operations in the same order, so both make the same image)
+            float fy = y + (0.5f - spans.originY);
+            float rowValue[5];
+            for(int i = 0; i < 5; i++) rowValue[i] = spans.value[i] + spans.dy[i] * fy;
+            uint32_t* line = pixels + (size_t)y * stride;
+            for(int x = spans.startX; x <= spans.maxX; x++){
+                // A pixel is inside if none of the 3 values is negative, so the sign bit of their OR is 0
+                if(x >= spans.minX && (edge[0] | edge[1] | edge[2]) >= 0){
+                    float fx = x + (0.5f - spans.originX);
+                    float attributes[5];
+                    for(int i = 0; i < 5; i++) attributes[i] = rowValue[i] + spans.dx[i] * fx;
+                    float w = 1.0f / attributes[0];
+                    line[x] = packColor(attributes[1] * w, attributes[2] * w, attributes[3] * w, attributes[4] * w);
+                }
+                for(int i = 0; i < 3; i++) edge[i] += spans.stepX[i];
+            }
+            for(int i = 0; i < 3; i++) row[i] += spans.stepY[i];
+        }
+    }
+
+#if SOFTWARE_RASTERIZER_X86
+    // ---------------- SSE2 ----------------
+    // 4 pixels of a row at once: the lanes are x, x + 1, x + 2 and x + 3
+
+    void fillSSE2(const TriangleSpans& spans, uint32_t* pixels, int stride) {
+        const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i minX = _mm_set1_epi32(spans.minX - 1), maxX = _mm_set1_epi32(spans.maxX + 1);
+        const __m128i minusOne = _mm_set1_epi32(-1);
+        const __m128 zero = _mm_setzero_ps(), maxColor = _mm_set1_ps(255.0f), one = _mm_set1_ps(1.0f);
+        const __m128 center = _mm_set1_ps(0.5f - spans.originX);
+
+        __m128i stepX4[3], row[3];
+        for(int i = 0; i < 3; i++){
+            stepX4[i] = _mm_set1_epi32(spans.stepX[i] * 4);
+            // The values of the 4 lanes: start + lane * stepX
+            row[i] = _mm_add_epi32(_mm_set1_epi32(spans.start[i]), _mm_setr_epi32(0, spans.stepX[i], spans.stepX[i] * 2, spans.stepX[i] * 3));
+        }
+        __m128 dx[5];
+        for(int i = 0; i < 5; i++) dx[i] = _mm_set1_ps(spans.dx[i]);
+
+        for(int y = spans.minY; y <= spans.maxY; y++){
+            __m128i edge[3] = {row[0], row[1], row[2]};
+            float fy = y + (0.5f - spans.originY);
+            // The values at x = originX on this row, only the x part changes along the row
+            __m128 rowValue[5];
+            for(int i = 0; i < 5; i++) rowValue[i] = _mm_set1_ps(spans.value[i] + spans.dy[i] * fy);
+            uint32_t* line = pixels + (size_t)y * stride;
+
+            for(int x = spans.startX; x <= spans.maxX; x += 4){
+                __m128i laneX = _mm_add_epi32(_mm_set1_epi32(x), laneOffsets);
+                __m128i inRow = _mm_and_si128(_mm_cmpgt_epi32(laneX, minX), _mm_cmplt_epi32(laneX, maxX));
+                __m128i signs = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+                __m128i inside = _mm_and_si128(_mm_cmpgt_epi32(signs, minusOne), inRow);
+                for(int i = 0; i < 3; i++) edge[i] = _mm_add_epi32(edge[i], stepX4[i]);
+                if(_mm_movemask_epi8(inside) == 0) continue;
+
+                __m128 fx = _mm_add_ps(_mm_cvtepi32_ps(laneX), center);
+                __m128 invW = _mm_add_ps(rowValue[0], _mm_mul_ps(dx[0], fx));
+                __m128 w = _mm_div_ps(one, invW);
+                __m128i color = _mm_setzero_si128();
+                for(int i = 1; i < 5; i++){
+                    __m128 channel = _mm_mul_ps(_mm_add_ps(rowValue[i], _mm_mul_ps(dx[i], fx)), w);
+                    channel = _mm_min_ps(_mm_max_ps(channel, zero), maxColor);
+                    // _mm_cvtps_epi32 rounds to the nearest integer
+                    color = _mm_or_si128(color, _mm_slli_epi32(_mm_cvtps_epi32(channel), 8 * (i - 1)));
+                }
+
+                // "x" is a multiple of 4 and so is the stride, the 4 pixels are always inside the row
+                __m128i* target = (__m128i*)(line + x);
+                __m128i old = _mm_loadu_si128(target);
+                _mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(inside, color), _mm_andnot_si128(inside, old)));
+            }
+            for(int i = 0; i < 3; i++) row[i] = _mm_add_epi32(row[i], _mm_set1_epi32(spans.stepY[i]));
+        }
+    }
+#endif
+}
+
+void SoftwareRasterizer::create(int width, int height, ThreadPool* threadPool) {
+    this->width = width;
+    this->height = height;
+    this->threadPool = threadPool;
+    stride = (width + 3) / 4 * 4;
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    // x / w = guardBandX is GUARD_BAND_PIXELS away from the center of the screen
+    guardBandX = GUARD_BAND_PIXELS / (width * 0.5f);
+    guardBandY = GUARD_BAND_PIXELS / (height * 0.5f);
+    pixels.assign((size_t)stride * height, 0);
+    draws.clear();
+    triangleCount = 0;
+}
+
+void SoftwareRasterizer::clear(float r, float g, float b, float a) {
+    std::fill(pixels.begin(), pixels.end(), packColor(r * 255, g * 255, b * 255, a * 255));
+}
+
+void SoftwareRasterizer::drawIndexed(const Vertex* vertices, const void* indices, GLenum indexType, size_t indexCount, int32_t baseVertex, const glm::mat4& MVP) {
+    size_t count = indexCount / 3;
+    if(count == 0) return;
+    draws.push_back({vertices, indices, indexType, baseVertex, MVP, triangleCount});
+    triangleCount += count;
+}
+
+void SoftwareRasterizer::flush() {
+    stats = Stats();
+    stats.draws = draws.size();
+    stats.triangles = triangleCount;
+
+    // 1. Setup: every chunk of triangles goes to its own bin
+    Clock::time_point start = Clock::now();
+    binCount = threadPool ? threadPool->getChunkCount(triangleCount, SETUP_CHUNK_SIZE) : 1;
+    if(bins.size() < binCount) bins.resize(binCount);
+    for(size_t i = 0; i < binCount; i++){
+        Bin& bin = bins[i];
+        bin.triangles.clear();
+        bin.tiles.resize((size_t)tilesX * tilesY);
+        for(std::vector<uint32_t>& tile : bin.tiles) tile.clear();
+        bin.stats = Stats();
+    }
+    if(threadPool) threadPool->parallelFor(triangleCount, SETUP_CHUNK_SIZE, [&](size_t begin, size_t end, size_t chunk) {
+        setupTriangles(begin, end, bins[chunk]);
+    });
+    else setupTriangles(0, triangleCount, bins[0]);
+    for(size_t i = 0; i < binCount; i++){
+        stats.clipped += bins[i].stats.clipped;
+        stats.culled += bins[i].stats.culled;
+        stats.binned += bins[i].stats.binned;
+    }
+    stats.setupTime = getMilliseconds(start);
+
+    // 2. Raster: every tile is filled by 1 thread
+    start = Clock::now();
+    int tileCount = tilesX * tilesY;
+    if(threadPool) threadPool->parallelFor(tileCount, 1, [&](size_t begin, size_t end, size_t) {
+        for(size_t tile = begin; tile < end; tile++) rasterizeTile((int)tile);
+    });
+    else for(int tile = 0; tile < tileCount; tile++) rasterizeTile(tile);
+    stats.rasterTime = getMilliseconds(start);
+
+    draws.clear();
+    triangleCount = 0;
+}
+
+void SoftwareRasterizer::setupTriangles(size_t begin, size_t end, Bin& bin) {
+    // The draw that contains the first triangle: the last one that starts at or before it
+    size_t drawIndex = std::upper_bound(draws.begin(), draws.end(), begin, [](size_t triangle, const Draw& draw) {
+        return triangle < draw.firstTriangle;
+    }) - draws.begin() - 1;
+
+    for(size_t triangle = begin; triangle < end; drawIndex++){
+        const Draw& draw = draws[drawIndex];
+        size_t drawEnd = drawIndex + 1 < draws.size() ? draws[drawIndex + 1].firstTriangle : triangleCount;
+        drawEnd = std::min(drawEnd, end);
+        for(; triangle < drawEnd; triangle++){
+            size_t first = (triangle - draw.firstTriangle) * 3;
+            ClipVertex corners[3];
+            for(int i = 0; i < 3; i++){
+                uint32_t index;
+                switch(draw.indexType){
+                    case GL_UNSIGNED_BYTE: index = ((const uint8_t*)draw.indices)[first + i]; break;
+                    case GL_UNSIGNED_SHORT: index = ((const uint16_t*)draw.indices)[first + i]; break;
+                    default: index = ((const uint32_t*)draw.indices)[first + i]; break;
+                }
+                const Vertex& vertex = draw.vertices[(int64_t)index + draw.baseVertex];
+                corners[i].position = draw.MVP * glm::vec4(vertex.x, vertex.y, vertex.z, 1.0f);
+                corners[i].color = glm::vec4(vertex.r, vertex.g, vertex.b, vertex.a);
+            }
+            clipTriangle(corners[0], corners[1], corners[2], bin);
+        }
+    }
+}
+
+void SoftwareRasterizer::clipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, Bin& bin) {
+    // The distance of a vertex to each plane, in clip space: the vertex is on the visible side if it isn't negative
+    auto distance = [&](const glm::vec4& p, int plane) {
+        switch(plane){
+            case 0: return p.w + p.z;
+            case 1: return p.w - p.z;
+            case 2: return guardBandX * p.w + p.x;
+            case 3: return guardBandX * p.w - p.x;
+            case 4: return guardBandY * p.w + p.y;
+            default: return guardBandY * p.w - p.y;
+        }
+    };
+    // 1 bit per plane the vertex is outside of, in the order of distance()
+    auto outside = [&](const glm::vec4& p) {
+        float bandX = guardBandX * p.w, bandY = guardBandY * p.w;
+        return (p.w + p.z < 0) | (p.w - p.z < 0) << 1 | (bandX + p.x < 0) << 2 | (bandX - p.x < 0) << 3 |
+               (bandY + p.y < 0) << 4 | (bandY - p.y < 0) << 5;
+    };
+    int outsideA = outside(a.position), outsideB = outside(b.position), outsideC = outside(c.position);
+    // All the corners are outside of the same plane
+    if(outsideA & outsideB & outsideC){
+        bin.stats.culled++;
+        return;
+    }
+    // Almost always: no plane cuts the triangle
+    if((outsideA | outsideB | outsideC) == 0){
+        setupTriangle(a, b, c, bin);
+        return;
+    }
+
+    // Sutherland-Hodgman: the polygon is cut by 1 plane after the other, keeping the part on the visible side
+    bin.stats.clipped++;
+    ClipVertex polygons[2][MAX_CLIPPED_VERTICES];
+    polygons[0][0] = a;
+    polygons[0][1] = b;
+    polygons[0][2] = c;
+    int count = 3, current = 0;
+    int planes = outsideA | outsideB | outsideC;
+    for(int plane = 0; plane < CLIP_PLANE_COUNT && count >= 3; plane++){
+        if(!(planes & (1 << plane))) continue;
+        const ClipVertex* input = polygons[current];
+        ClipVertex* output = polygons[1 - current];
+        int outputCount = 0;
+        for(int i = 0; i < count; i++){
+            const ClipVertex& from = input[i];
+            const ClipVertex& to = input[(i + 1) % count];
+            float fromDistance = distance(from.position, plane), toDistance = distance(to.position, plane);
+            if(fromDistance >= 0) output[outputCount++] = from;
+            // The edge crosses the plane: add the point where it does
+            if((fromDistance >= 0) != (toDistance >= 0)){
+                float t = fromDistance / (fromDistance - toDistance);
+                output[outputCount++] = {from.position + (to.position - from.position) * t, from.color + (to.color - from.color) * t};
+            }
+        }
+        count = outputCount;
+        current = 1 - current;
+    }
+    if(count < 3){
+        bin.stats.culled++;
+        return;
+    }
+    // The polygon is convex, so it is split into a fan of triangles around its first vertex
+    const ClipVertex* polygon = polygons[current];
+    for(int i = 1; i + 1 < count; i++) setupTriangle(polygon[0], polygon[i], polygon[i + 1], bin);
+}
+
+void SoftwareRasterizer::setupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, Bin& bin) {
+    const ClipVertex* corners[3] = {&a, &b, &c};
+    Triangle triangle;
+    float invW[3];
+    for(int i = 0; i < 3; i++){
+        const glm::vec4& p = corners[i]->position;
+        // After clipping by the near plane w is positive, except for degenerate matrices
+        if(!(p.w > 0)){
+            bin.stats.culled++;
+            return;
+        }
+        invW[i] = 1.0f / p.w;
+        // The viewport transform (like glViewport(0, 0, width, height)), then the snap to 1/16 of a pixel
+        float screenX = (p.x * invW[i] * 0.5f + 0.5f) * width;
+        float screenY = (p.y * invW[i] * 0.5f + 0.5f) * height;
+        triangle.x[i] = (int32_t)std::floor(screenX * SUBPIXELS + 0.5f);
+        triangle.y[i] = (int32_t)std::floor(screenY * SUBPIXELS + 0.5f);
+    }
+
+    // Twice the signed area, positive if the corners are counter-clockwise
+    int64_t area = (int64_t)(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                   (int64_t)(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+    if(area == 0){
+        bin.stats.culled++;
+        return;
+    }
+    // Nothing is culled (like the OpenGL path), clockwise triangles are turned around so the inside is always on the same side
+    if(area < 0){
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        std::swap(corners[1], corners[2]);
+        std::swap(invW[1], invW[2]);
+    }
+
+    // The pixels whose centers (at 8/16 of the pixel) can be inside
+    int lowX = std::min({triangle.x[0], triangle.x[1], triangle.x[2]}), highX = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+    int lowY = std::min({triangle.y[0], triangle.y[1], triangle.y[2]}), highY = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+    triangle.minX = std::max((lowX - SUBPIXELS / 2 + SUBPIXELS - 1) >> SUBPIXEL_BITS, 0);
+    triangle.minY = std::max((lowY - SUBPIXELS / 2 + SUBPIXELS - 1) >> SUBPIXEL_BITS, 0);
+    triangle.maxX = std::min((highX - SUBPIXELS / 2) >> SUBPIXEL_BITS, width - 1);
+    triangle.maxY = std::min((highY - SUBPIXELS / 2) >> SUBPIXEL_BITS, height - 1);
+    // Outside the screen, or too small to cover any pixel center
+    if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY){
+        bin.stats.culled++;
+        return;
+    }
+
+    // The planes of the values divided by w, from the corners snapped to the subpixels (in pixels, relative to corner 0)
+    // value = value0 + (value1 - value0) * b1 + (value2 - value0) * b2, where b1 and b2 are the barycentric coordinates
+    float x1 = (triangle.x[1] - triangle.x[0]) / (float)SUBPIXELS, y1 = (triangle.y[1] - triangle.y[0]) / (float)SUBPIXELS;
+    float x2 = (triangle.x[2] - triangle.x[0]) / (float)SUBPIXELS, y2 = (triangle.y[2] - triangle.y[0]) / (float)SUBPIXELS;
+    float inverseArea = 1.0f / (x1 * y2 - y1 * x2);
+    triangle.originX = triangle.x[0] / (float)SUBPIXELS;
+    triangle.originY = triangle.y[0] / (float)SUBPIXELS;
+    for(int i = 0; i < 5; i++){
+        float values[3];
+        for(int j = 0; j < 3; j++) values[j] = i == 0 ? invW[j] : corners[j]->color[i - 1] * invW[j];
+        float delta1 = values[1] - values[0], delta2 = values[2] - values[0];
+        triangle.value[i] = values[0];
+        triangle.dx[i] = (delta1 * y2 - delta2 * y1) * inverseArea;
+        triangle.dy[i] = (delta2 * x1 - delta1 * x2) * inverseArea;
+    }
+
+    uint32_t index = (uint32_t)bin.triangles.size();
+    bin.triangles.push_back(triangle);
+    for(int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+        for(int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++){
+            bin.tiles[(size_t)tileY * tilesX + tileX].push_back(index);
+            bin.stats.binned++;
+        }
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile) {
+    int tileX0 = tile % tilesX * TILE_SIZE, tileY0 = tile / tilesX * TILE_SIZE;
+    int tileX1 = std::min(tileX0 + TILE_SIZE, width) - 1, tileY1 = std::min(tileY0 + TILE_SIZE, height) - 1;
+#if SOFTWARE_RASTERIZER_X86
+    bool simd = getSimdLevel() != SimdLevel::Scalar;
+#endif
+
+    // The bins in the order of the chunks, so the triangles are drawn in the order they were submitted
+    for(size_t b = 0; b < binCount; b++){
+        const Bin& bin = bins[b];
+        for(uint32_t index : bin.tiles[tile]){
+            const Triangle& triangle = bin.triangles[index];
+            TriangleSpans spans;
+            spans.minX = std::max(triangle.minX, tileX0);
+            spans.maxX = std::min(triangle.maxX, tileX1);
+            spans.minY = std::max(triangle.minY, tileY0);
+            spans.maxY = std::min(triangle.maxY, tileY1);
+            spans.startX = spans.minX & ~3;
+
+            // The edge from corner i + 1 to corner i + 2: E(p) = dx * (p.y - y) - dy * (p.x - x), positive inside
+            // Each edge is checked at the 4 corners of the rectangle: if it is negative at all of them, the triangle misses the tile,
+            // and if it is positive at all of them, the edge doesn't need to be tested for these pixels
+            bool missed = false;
+            for(int i = 0; i < 3 && !missed; i++){
+                int from = (i + 1) % 3, to = (i + 2) % 3;
+                int64_t edgeX = triangle.x[to] - triangle.x[from], edgeY = triangle.y[to] - triangle.y[from];
+                // Top-left rule: the pixels exactly on the edge are only inside for the top edges (horizontal, going left since the
+                // corners are counter-clockwise with y going up) and the left edges (going down)
+                int64_t bias = edgeY < 0 || (edgeY == 0 && edgeX < 0) ? 0 : -1;
+                auto evaluate = [&](int pixelX, int pixelY) {
+                    int64_t px = (int64_t)pixelX * SUBPIXELS + SUBPIXELS / 2, py = (int64_t)pixelY * SUBPIXELS + SUBPIXELS / 2;
+                    return edgeX * (py - triangle.y[from]) - edgeY * (px - triangle.x[from]) + bias;
+                };
+                int64_t corners[4] = {evaluate(spans.minX, spans.minY), evaluate(spans.maxX, spans.minY),
+                                      evaluate(spans.minX, spans.maxY), evaluate(spans.maxX, spans.maxY)};
+                int64_t low = std::min({corners[0], corners[1], corners[2], corners[3]});
+                int64_t high = std::max({corners[0], corners[1], corners[2], corners[3]});
+                if(high < 0){
+                    missed = true;
+                } else if(low >= 0){
+                    spans.start[i] = spans.stepX[i] = spans.stepY[i] = 0;
+                } else {
+                    // Partly inside: the values are at most a few tiles of steps away from 0, so 32 bits are enough
+                    spans.start[i] = (int32_t)evaluate(spans.startX, spans.minY);
+                    spans.stepX[i] = (int32_t)(-edgeY * SUBPIXELS);
+                    spans.stepY[i] = (int32_t)(edgeX * SUBPIXELS);
+                }
+            }
+            if(missed) continue;
+
+            spans.originX = triangle.originX;
+            spans.originY = triangle.originY;
+            spans.value = triangle.value;
+            spans.dx = triangle.dx;
+            spans.dy = triangle.dy;
+#if SOFTWARE_RASTERIZER_X86
+            if(simd){
+                fillSSE2(spans, pixels.data(), stride);
+                continue;
+            }
+#endif
+            fillScalar(spans, pixels.data(), stride);
+        }
+    }
+}
+
+uint64_t SoftwareRasterizer::getChecksum() const {
+    uint64_t hash = 14695981039346656037ull;
+    for(int y = 0; y < height; y++){
+        const uint8_t* bytes = (const uint8_t*)getRow(y);
+        for(size_t i = 0; i < (size_t)width * 4; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool SoftwareRasterizer::savePpm(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if(!file) return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    // PPM stores the rows from top to bottom
+    std::vector<uint8_t> line((size_t)width * 3);
+    for(int y = height - 1; y >= 0; y--){
+        const uint32_t* row = getRow(y);
+        for(int x = 0; x < width; x++){
+            line[x * 3 + 0] = (uint8_t)(row[x] & 0xFF);
+            line[x * 3 + 1] = (uint8_t)(row[x] >> 8 & 0xFF);
+            line[x * 3 + 2] = (uint8_t)(row[x] >> 16 & 0xFF);
+        }
+        file.write((const char*)line.data(), line.size());
+    }
+    return (bool)file;
+}
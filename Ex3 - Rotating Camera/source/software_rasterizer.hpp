@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "mesh.hpp"
+#include "thread_pool.hpp"
+
+// Software Rasterizer
+// ----------------
+// Draws the same meshes as the OpenGL path (the vertex layout of source/mesh.hpp, 8, 16 or 32-bit indices and 1 MVP per draw)
+// on the CPU, without any driver. It is useful on machines without a GPU, and to compare against llvmpipe
+// (the software OpenGL driver used by --headless without a GPU) which does the same work behind the OpenGL API.
+//
+// A frame is done in 2 passes over all the triangles queued by drawIndexed(), both split between the threads of the pool:
+// 1. Setup: every triangle is transformed by its MVP, clipped against the near and far planes (and a guard band far outside
+//    the screen, so the fixed point coordinates can't overflow), projected to the screen and snapped to 1/16 of a pixel.
+//    Then its 3 edge equations and the planes of its interpolated values are computed, and it is added to the list of every
+//    64x64 tile its bounding box touches. Every thread has its own lists, so no locks are needed, and the triangles of a thread
+//    come after the ones of the threads before it, like the draws were submitted.
+// 2. Raster: every tile is filled by 1 thread, which reads the lists of all the setup threads in order.
+//    The tiles don't share pixels, so they are filled at the same time, and the triangles stay in submission order inside a tile.
+//
+// A pixel is covered when its center is on the inner side of the 3 edges (the half-space test). Pixels exactly on an edge
+// belong to the triangle only if the edge is a top or a left edge, so 2 triangles sharing an edge never both draw the same pixel.
+// The edge values increase by a constant from 1 pixel to the next, so they are only additions, 4 pixels at a time with SSE2.
+// The colors are interpolated perspective-correctly: color / w and 1 / w are linear on the screen, so both are interpolated
+// and divided per pixel (like the GPU does).
+// Like the OpenGL path (no depth test, no culling, no blending), both windings are drawn and later triangles cover earlier ones.
+class SoftwareRasterizer {
+public:
+    static const int TILE_SIZE = 64;
+    // The positions on the screen are in fixed point with 4 fractional bits (1/16 of a pixel), like most GPUs
+    static const int SUBPIXEL_BITS = 4;
+
+    struct Stats {
+        size_t draws = 0;
+        size_t triangles = 0;      // Submitted
+        size_t clipped = 0;        // Cut by the near or far plane (or the guard band)
+        size_t culled = 0;         // Outside the screen, or without any area
+        size_t binned = 0;         // Triangles added to the tiles, a triangle is counted once per tile it touches
+        double setupTime = 0;      // In milliseconds
+        double rasterTime = 0;
+    };
+
+    // Creates a color buffer of width x height pixels
+    // The work is split between the threads of "threadPool", or done on the calling thread if it is null
+    void create(int width, int height, ThreadPool* threadPool = nullptr);
+
+    // Fills the color buffer (the values are from 0 to 1, like glClearColor)
+    void clear(float r, float g, float b, float a);
+
+    // Queues the triangles of "indexCount" indices ("indexType" is GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT) to be drawn with "MVP"
+    // Like glDrawElementsBaseVertex, "baseVertex" is added to every index
+    // Nothing is copied: the vertices and the indices must stay alive until flush()
+    void drawIndexed(const Vertex* vertices, const void* indices, GLenum indexType, size_t indexCount, int32_t baseVertex, const glm::mat4& MVP);
+
+    // Draws all the queued triangles into the color buffer, then empties the queue
+    void flush();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // A row of "width" pixels with 4 bytes each (red, green, blue, alpha), the rows go from bottom to top like in OpenGL
+    const uint32_t* getRow(int y) const { return &pixels[(size_t)y * stride]; }
+    // A hash of all the pixels (FNV-1a), 2 renders give the same value only if their images are the same
+    uint64_t getChecksum() const;
+    // Writes the image as a binary PPM file (without the alpha), returns false if the file can't be written
+    bool savePpm(const std::string& path) const;
+
+    // The counts of the last flush()
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Draw {
+        const Vertex* vertices;
+        const void* indices;
+        GLenum indexType;
+        int32_t baseVertex;
+        glm::mat4 MVP;
+        size_t firstTriangle;      // The number of triangles queued before this draw
+    };
+
+    struct ClipVertex {
+        glm::vec4 position;
+        glm::vec4 color;
+    };
+
+    struct Triangle {
+        // The corners in fixed point, counter-clockwise on the screen
+        int32_t x[3], y[3];
+        // The pixels of the bounding box (the last ones included), inside the screen
+        int minX, minY, maxX, maxY;
+        // The interpolated values: 1 / w, then red / w, green / w, blue / w and alpha / w
+        // Each one is value + dx * (pixel x - originX) + dy * (pixel y - originY), at the center of the pixel
+        float originX, originY;
+        float value[5], dx[5], dy[5];
+    };
+
+    // What 1 thread made in the setup pass: its triangles, and for every tile the indices of the triangles that touch it
+    struct Bin {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> tiles;
+        Stats stats;
+    };
+
+    void setupTriangles(size_t begin, size_t end, Bin& bin);
+    void clipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, Bin& bin);
+    void setupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, Bin& bin);
+    void rasterizeTile(int tile);
+
+    int width = 0, height = 0;
+    // The rows are padded to a multiple of 4 pixels, so 4 pixels can always be loaded and stored at once
+    int stride = 0;
+    int tilesX = 0, tilesY = 0;
+    // How far outside the screen a clipped triangle may reach, relative to w
+    float guardBandX = 1, guardBandY = 1;
+    std::vector<uint32_t> pixels;
+    ThreadPool* threadPool = nullptr;
+
+    std::vector<Draw> draws;
+    size_t triangleCount = 0;
+    std::vector<Bin> bins;
+    size_t binCount = 0;
+    Stats stats;
+};
@@ -0,0 +1,65 @@
+#include "stream_buffer.hpp"
+
+#include <iostream>
+
+bool StreamBuffer::create(size_t size) {
+    if(!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage){
+        std::cerr << "glBufferStorage is not supported by the driver" << std::endl;
+        return false;
+    }
+    regionSize = size;
+
+    // Unlike glBufferData, the size of a buffer created by glBufferStorage can't change later (immutable storage)
+    // This is what allows the driver to keep it mapped while the GPU uses it
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, REGION_COUNT * regionSize, nullptr, flags);
+    mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, REGION_COUNT * regionSize, flags);
+    if(!mapped){
+        std::cerr << "Failed to map the stream buffer" << std::endl;
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void* StreamBuffer::beginRegion() {
+    region = (region + 1) % REGION_COUNT;
+
+    GLsync& fence = fences[region];
+    if(fence){
+        // First check without waiting, so we can count how often the CPU really had to wait for the GPU
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            stallCount++;
+            // GL_SYNC_FLUSH_COMMANDS_BIT makes sure the fence was sent to the GPU, otherwise we could wait forever
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while(result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return mapped + region * regionSize;
+}
+
+void StreamBuffer::endRegion() {
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::destroy() {
+    for(GLsync& fence : fences){
+        if(fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if(buffer){
+        if(mapped){
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+}
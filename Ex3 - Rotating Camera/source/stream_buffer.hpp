@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/gl.h>
+
+// Streaming Buffer
+// ----------------
+// When the geometry changes every frame, re-sending it with glBufferData or glBufferSubData is slow:
+// the driver may have to wait for the GPU to finish reading the old data, or allocate a new buffer and copy our data into it.
+//
+// Instead, we allocate 1 buffer that is big enough for 3 frames (3 regions) using glBufferStorage,
+// and we map it once for the whole run (GL_MAP_PERSISTENT_BIT), so the CPU writes the data directly into the buffer memory.
+// With GL_MAP_COHERENT_BIT, whatever the CPU writes is visible to the GPU without any flush.
+// While the GPU draws from the region of frame N, the CPU writes the region of frame N+1.
+// A fence (glFenceSync) is placed after the draw calls of each region, and before writing into a region again,
+// we wait on its fence to be sure the GPU finished reading it. With 3 regions, this wait almost never blocks.
+//
+// Usage:
+//      char* data = (char*)stream.beginRegion();
+//      ... write the vertices and indices into data ...
+//      ... draw using stream.getRegionOffset() as the offset of the data in the buffer ...
+//      stream.endRegion();
+class StreamBuffer {
+public:
+    static const int REGION_COUNT = 3;
+
+    // Creates the buffer with "REGION_COUNT" regions of "regionSize" bytes each, and maps it
+    // Returns false if the driver doesn't support glBufferStorage (OpenGL 4.4 or GL_ARB_buffer_storage)
+    bool create(size_t regionSize);
+
+    // Waits until the GPU finished reading the next region, then returns a pointer to write into it
+    void* beginRegion();
+
+    // Places a fence after the draw calls that read the current region, must be called after these draw calls
+    void endRegion();
+
+    GLuint getBuffer() const { return buffer; }
+    size_t getRegionSize() const { return regionSize; }
+    // The offset (in bytes) of the current region from the start of the buffer
+    size_t getRegionOffset() const { return region * regionSize; }
+
+    // How many times beginRegion() had to wait for the GPU
+    uint64_t getStallCount() const { return stallCount; }
+
+    void destroy();
+
+private:
+    GLuint buffer = 0;
+    char* mapped = nullptr;
+    size_t regionSize = 0;
+    int region = REGION_COUNT - 1;
+    GLsync fences[REGION_COUNT] = {};
+    uint64_t stallCount = 0;
+};
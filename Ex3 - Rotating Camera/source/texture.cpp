@@ -0,0 +1,233 @@
+#include "texture.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+int getMipLevelCount(int width, int height) {
+    int levels = 1;
+    for(int size = std::max(width, height); size > 1; size /= 2) levels++;
+    return levels;
+}
+
+std::vector<Image> generateMipChain(const Image& image) {
+    std::vector<Image> mips = {image};
+    int levels = getMipLevelCount(image.width, image.height);
+    for(int level = 1; level < levels; level++){
+        const Image& source = mips.back();
+        Image mip;
+        mip.width = std::max(source.width / 2, 1);
+        mip.height = std::max(source.height / 2, 1);
+        mip.pixels.resize((size_t)mip.width * mip.height * 4);
+        for(int y = 0; y < mip.height; y++){
+            // A side of 1 pixel can't be halved, so the same pixel is read twice
+            int y0 = std::min(2 * y, source.height - 1), y1 = std::min(2 * y + 1, source.height - 1);
+            for(int x = 0; x < mip.width; x++){
+                int x0 = std::min(2 * x, source.width - 1), x1 = std::min(2 * x + 1, source.width - 1);
+                const uint8_t* p00 = &source.pixels[((size_t)y0 * source.width + x0) * 4];
+                const uint8_t* p01 = &source.pixels[((size_t)y0 * source.width + x1) * 4];
+                const uint8_t* p10 = &source.pixels[((size_t)y1 * source.width + x0) * 4];
+                const uint8_t* p11 = &source.pixels[((size_t)y1 * source.width + x1) * 4];
+                uint8_t* out = &mip.pixels[((size_t)y * mip.width + x) * 4];
+                for(int c = 0; c < 4; c++) out[c] = (uint8_t)((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+        mips.push_back(std::move(mip));
+    }
+    return mips;
+}
+
+Image createCheckerboardImage(int size, int cells) {
+    Image image;
+    image.width = image.height = size;
+    image.pixels.resize((size_t)size * size * 4);
+    int cellSize = std::max(size / cells, 1);
+    for(int y = 0; y < size; y++){
+        for(int x = 0; x < size; x++){
+            int cellX = x / cellSize, cellY = y / cellSize;
+            uint8_t* pixel = &image.pixels[((size_t)y * size + x) * 4];
+            if((cellX + cellY) % 2 == 0){
+                // The light cells get a color from their position in the grid
+                pixel[0] = (uint8_t)(255 * cellX / std::max(cells - 1, 1));
+                pixel[1] = (uint8_t)(255 * cellY / std::max(cells - 1, 1));
+                pixel[2] = 255;
+            } else {
+                pixel[0] = pixel[1] = pixel[2] = 32;
+            }
+            pixel[3] = 255;
+        }
+    }
+    return image;
+}
+
+GLuint createTextureStorage(RenderState& state, int width, int height, int levels, GLenum format) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    state.bindTexture(0, GL_TEXTURE_2D, texture);
+    if(GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage){
+        glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+    } else {
+        // Without immutable storage, every level is allocated by itself, and GL_TEXTURE_MAX_LEVEL tells the driver
+        // that there are no more levels, otherwise it would treat the texture as incomplete
+        for(int level = 0; level < levels; level++){
+            if(isCompressedFormat(format)){
+                GLsizei size = (GLsizei)(((width + 3) / 4) * ((height + 3) / 4) * getCompressedBlockSize(format));
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, size, nullptr);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+    return texture;
+}
+
+void TextureUploader::create(size_t size) {
+    bufferSize = size;
+    glGenBuffers(BUFFER_COUNT, buffers);
+    for(GLuint buffer : buffers){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+    // Nothing must stay bound to GL_PIXEL_UNPACK_BUFFER, or the other texture calls would read from it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUploader::beginFrame(RenderState& state) {
+    current = (current + 1) % BUFFER_COUNT;
+    used = 0;
+    copies.clear();
+
+    GLsync& fence = fences[current];
+    if(fence){
+        // First check without waiting, so we can count how often the CPU really had to wait for the GPU
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            stats.stalls++;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while(result == GL_TIMEOUT_EXPIRED);
+            stats.stallTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // The fence says the GPU doesn't read the buffer anymore, so it is mapped without synchronization,
+    // and GL_MAP_INVALIDATE_BUFFER_BIT tells the driver the old content can be thrown away
+    state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[current]);
+    mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool TextureUploader::upload(GLuint texture, int level, int y, int width, int height, GLenum format, const void* pixels, size_t size) {
+    if(!mapped || size > getFreeSpace()) return false;
+    std::memcpy(mapped + used, pixels, size);
+    copies.push_back({texture, level, y, width, height, format, used, size});
+    // Every copy starts at a multiple of 4 bytes, the rows of RGBA8 pixels and the blocks are always aligned like that
+    used += size;
+    return true;
+}
+
+void TextureUploader::endFrame(RenderState& state) {
+    if(!mapped) return;
+    state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[current]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    mapped = nullptr;
+    for(const Copy& copy : copies){
+        state.bindTexture(0, GL_TEXTURE_2D, copy.texture);
+        // The last param is the offset of the pixels in the buffer bound to GL_PIXEL_UNPACK_BUFFER
+        // The compressed blocks are copied as they are, the GPU decodes them when the texture is read
+        if(isCompressedFormat(copy.format)){
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, copy.level, 0, copy.y, copy.width, copy.height, copy.format, (GLsizei)copy.size, (void*)copy.offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, copy.level, 0, copy.y, copy.width, copy.height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)copy.offset);
+        }
+    }
+    state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(!copies.empty()) fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stats.uploads += copies.size();
+    stats.bytes += used;
+}
+
+void TextureUploader::destroy() {
+    for(GLsync& fence : fences){
+        if(fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if(buffers[0]) glDeleteBuffers(BUFFER_COUNT, buffers);
+    for(GLuint& buffer : buffers) buffer = 0;
+    mapped = nullptr;
+}
+
+void TextureStreamer::add(GLuint texture, std::vector<Image> mips) {
+    int levels = (int)mips.size();
+    pending.push_back({texture, std::move(mips), levels - 1, 0, levels});
+}
+
+void TextureStreamer::update(RenderState& state, TextureUploader& uploader) {
+    if(pending.empty()) return;
+    uploader.beginFrame(state);
+    // The levels that were completed in this frame, GL_TEXTURE_BASE_LEVEL is changed after their copies are started
+    std::vector<StreamedTexture*> completed;
+    while(true){
+        // The texture with the smallest missing level goes first
+        StreamedTexture* next = nullptr;
+        for(StreamedTexture& texture : pending){
+            if(texture.level < 0) continue;
+            if(!next || texture.mips[texture.level].getSize() < next->mips[next->level].getSize()) next = &texture;
+        }
+        if(!next) break;
+
+        // As many rows of the level as fit in the buffer, the rest of the level is sent in the next frames
+        // A row is a row of blocks for a compressed level, so the first row sent is a multiple of 4 and so is their height
+        const Image& image = next->mips[next->level];
+        size_t rowSize = image.getRowSize();
+        int rowHeight = image.getRowHeight();
+        int firstRow = next->row / rowHeight;
+        int remainingRows = (image.height - next->row + rowHeight - 1) / rowHeight;
+        int rows = std::min(remainingRows, (int)(uploader.getFreeSpace() / rowSize));
+        if(rows <= 0) break;
+        int height = std::min(rows * rowHeight, image.height - next->row);
+        uploader.upload(next->texture, next->level, next->row, image.width, height, image.format,
+                        &image.pixels[(size_t)firstRow * rowSize], (size_t)rows * rowSize);
+        next->row += height;
+        if(next->row < image.height) break;
+
+        next->resident = next->level;
+        next->row = 0;
+        if(std::find(completed.begin(), completed.end(), next) == completed.end()) completed.push_back(next);
+        // The level becomes -1 after level 0, the texture is moved to "done" at the end of the frame
+        next->level--;
+    }
+    uploader.endFrame(state);
+
+    for(StreamedTexture* texture : completed){
+        state.bindTexture(0, GL_TEXTURE_2D, texture->texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture->resident);
+    }
+    for(size_t i = 0; i < pending.size();){
+        if(pending[i].level < 0){
+            pending[i].mips.clear();
+            done.push_back(std::move(pending[i]));
+            pending.erase(pending.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+int TextureStreamer::getResidentLevel(GLuint texture) const {
+    for(const StreamedTexture& streamed : pending) if(streamed.texture == texture) return streamed.resident;
+    for(const StreamedTexture& streamed : done) if(streamed.texture == texture) return streamed.resident;
+    return -1;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/gl.h>
+#include "render_state.hpp"
+
+// Textures
+// ----------------
+// A texture is an image the fragment shader reads with texture(sampler, uv). To look good from far away,
+// it also has mip levels: level 0 is the full image, level 1 is half its width and height, ... down to 1x1 pixel.
+// The GPU reads the level whose pixels are about the size of the screen pixels, so far textures don't flicker.
+//
+// 1. Immutable storage: glTexStorage2D allocates all the levels at once and their size can't change later, so the driver
+//    knows the texture is complete and never checks it again. The data is sent afterward with glTexSubImage2D.
+//    (OpenGL 4.2 or GL_ARB_texture_storage, otherwise every level is allocated with glTexImage2D)
+//
+// 2. Uploads through pixel buffers: glTexSubImage2D from a CPU pointer must copy the pixels before it returns,
+//    and may wait for the GPU. When a buffer is bound to GL_PIXEL_UNPACK_BUFFER, the last param of glTexSubImage2D
+//    is an offset in that buffer instead of a pointer, and the GPU copies the pixels into the texture later by itself.
+//    The uploader has a ring of 3 pixel buffers: every frame the pixels are written into the next one,
+//    and a fence tells when the GPU finished reading it, so the CPU almost never waits (like source/stream_buffer.hpp).
+//
+// 3. Lowest mip first: a texture of 2048x2048 pixels is 16 MB for level 0 alone, too much to send in 1 frame without a stall.
+//    The streamer sends the levels from the smallest (1x1) to the biggest, only a few hundred KB per frame,
+//    and after every level it moves GL_TEXTURE_BASE_LEVEL (the biggest level the GPU may read) to the new level.
+//    The texture is blurry for the first frames and gets sharper as the bigger levels arrive.
+//
+// The levels can also be compressed (see source/block_compression.hpp): they are sent the same way,
+// in rows of 4x4 blocks instead of rows of pixels, with glCompressedTexSubImage2D.
+
+// Returns true for the compressed formats the examples use (BC1 and BC3, called S3TC DXT1 and DXT5 by OpenGL)
+inline bool isCompressedFormat(GLenum format) {
+    return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+// The bytes of 1 block of 4x4 pixels: 8 for BC1, 16 for BC3
+inline size_t getCompressedBlockSize(GLenum format) {
+    return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+}
+
+// An image with 4 bytes per pixel (red, green, blue, alpha), the rows go from bottom to top like in OpenGL
+// If "format" is a compressed format, "pixels" holds the 4x4 blocks instead, row of blocks by row of blocks
+struct Image {
+    int width = 0, height = 0;
+    GLenum format = GL_RGBA8;
+    std::vector<uint8_t> pixels;
+
+    size_t getSize() const { return pixels.size(); }
+    // The pixel rows sent together: 1, or 4 (a row of blocks) for compressed images
+    int getRowHeight() const { return isCompressedFormat(format) ? 4 : 1; }
+    // The bytes of 1 row of pixels, or of 1 row of blocks (the width is rounded up to whole blocks)
+    size_t getRowSize() const { return isCompressedFormat(format) ? (size_t)(width + 3) / 4 * getCompressedBlockSize(format) : (size_t)width * 4; }
+};
+
+// The number of levels down to 1x1: floor(log2(biggest side)) + 1
+int getMipLevelCount(int width, int height);
+
+// Level i + 1 is made by averaging the 2x2 pixels of level i (a box filter), the last level is 1x1
+// The first image of the result is "image" itself
+std::vector<Image> generateMipChain(const Image& image);
+
+// A checkerboard with colored cells, there are no image files in the assets so the examples make their textures
+// Its fine details disappear in the small levels, so the streaming is easy to see
+Image createCheckerboardImage(int size, int cells);
+
+// Creates a texture with room for "levels" levels in "format" (GL_RGBA8 or a compressed format) and no data yet
+// It is filtered with the mip levels (trilinear) and repeats outside [0, 1]
+// GL_TEXTURE_BASE_LEVEL starts at the smallest level, which is the first one the streamer sends
+GLuint createTextureStorage(RenderState& state, int width, int height, int levels, GLenum format = GL_RGBA8);
+
+class TextureUploader {
+public:
+    static const int BUFFER_COUNT = 3;
+
+    struct Stats {
+        size_t uploads = 0;        // glTexSubImage2D calls
+        size_t bytes = 0;
+        size_t stalls = 0;         // The frames that had to wait for the GPU to finish reading a buffer
+        double stallTime = 0;      // In milliseconds
+    };
+
+    // "bufferSize" is the most bytes sent in 1 frame, it must hold at least 1 row (of pixels or blocks) of the biggest level
+    void create(size_t bufferSize);
+
+    // Waits until the GPU finished reading the next buffer of the ring, then maps it so upload() can write into it
+    void beginFrame(RenderState& state);
+
+    // Copies "size" bytes with "height" rows of "width" pixels in "format" into the buffer, to be sent at "y" in the level of the texture
+    // For compressed formats, "y" is a multiple of 4 and "height" too, unless the rows reach the top of the level
+    // Returns false (and copies nothing) if the buffer doesn't have room for them in this frame
+    bool upload(GLuint texture, int level, int y, int width, int height, GLenum format, const void* pixels, size_t size);
+
+    // Unmaps the buffer and starts all the copies of the frame from the buffer to the textures, then places the fence
+    void endFrame(RenderState& state);
+
+    // The bytes upload() can still write in this frame
+    size_t getFreeSpace() const { return bufferSize - used; }
+    size_t getBufferSize() const { return bufferSize; }
+    const Stats& getStats() const { return stats; }
+
+    void destroy();
+
+private:
+    struct Copy {
+        GLuint texture;
+        int level, y, width, height;
+        GLenum format;
+        size_t offset, size;
+    };
+
+    GLuint buffers[BUFFER_COUNT] = {};
+    GLsync fences[BUFFER_COUNT] = {};
+    int current = BUFFER_COUNT - 1;
+    size_t bufferSize = 0;
+    uint8_t* mapped = nullptr;
+    size_t used = 0;
+    std::vector<Copy> copies;
+    Stats stats;
+};
+
+class TextureStreamer {
+public:
+    // Streams the levels of "mips" into "texture" (created by createTextureStorage with mips.size() levels and their format)
+    void add(GLuint texture, std::vector<Image> mips);
+
+    // Sends as many rows as fit in the uploader's buffer, always from the smallest level still missing of any texture
+    // Call it once per frame, before drawing with the textures
+    void update(RenderState& state, TextureUploader& uploader);
+
+    // Returns true when all the levels of all the textures were sent
+    bool isDone() const { return pending.empty(); }
+
+    // The biggest level the texture can show now (its GL_TEXTURE_BASE_LEVEL), the level count until the first level arrives,
+    // or -1 if the texture isn't streamed by this streamer
+    int getResidentLevel(GLuint texture) const;
+
+private:
+    struct StreamedTexture {
+        GLuint texture;
+        std::vector<Image> mips;
+        int level;      // The level being sent
+        int row;        // The first pixel row of this level that wasn't sent yet
+        int resident;   // The biggest level that was completely sent
+    };
+
+    std::vector<StreamedTexture> pending, done;
+};
@@ -0,0 +1,162 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <climits>
+
+void SkylinePacker::reset(int layerWidth, int layerHeight) {
+    width = layerWidth;
+    height = layerHeight;
+    usedArea = 0;
+    skyline.assign(1, {0, 0, layerWidth});
+}
+
+bool SkylinePacker::pack(int rectWidth, int rectHeight, int& x, int& y) {
+    // Tries to put the left edge of the rectangle at the start of every segment
+    // The rectangle rests on the highest segment under it
+    int bestY = INT_MAX, bestX = 0;
+    size_t best = SIZE_MAX;
+    for(size_t i = 0; i < skyline.size(); i++){
+        int left = skyline[i].x;
+        if(left + rectWidth > width) break;
+        int top = 0;
+        for(size_t j = i; j < skyline.size() && skyline[j].x < left + rectWidth; j++) top = std::max(top, skyline[j].y);
+        if(top + rectHeight <= height && top < bestY){
+            bestY = top;
+            bestX = left;
+            best = i;
+        }
+    }
+    if(best == SIZE_MAX) return false;
+    x = bestX;
+    y = bestY;
+
+    // The rectangle becomes a new segment, and the parts of the segments under it are removed
+    int right = x + rectWidth;
+    skyline.insert(skyline.begin() + best, {x, y + rectHeight, rectWidth});
+    size_t i = best + 1;
+    while(i < skyline.size() && skyline[i].x < right){
+        int end = skyline[i].x + skyline[i].width;
+        if(end <= right){
+            skyline.erase(skyline.begin() + i);
+        } else {
+            skyline[i].width = end - right;
+            skyline[i].x = right;
+            break;
+        }
+    }
+    // Neighbor segments at the same height become 1 segment
+    for(size_t j = 0; j + 1 < skyline.size();){
+        if(skyline[j].y == skyline[j + 1].y){
+            skyline[j].width += skyline[j + 1].width;
+            skyline.erase(skyline.begin() + j + 1);
+        } else {
+            j++;
+        }
+    }
+    usedArea += (size_t)rectWidth * rectHeight;
+    return true;
+}
+
+bool buildTextureAtlas(const std::vector<Image>& images, int layerSize, int padding, TextureAtlas& atlas) {
+    atlas = TextureAtlas();
+    atlas.width = atlas.height = layerSize;
+    // Level i has padding / 2^i pixels of padding, the last level keeps 1
+    atlas.levels = 1;
+    while((padding >> atlas.levels) >= 1 && atlas.levels < getMipLevelCount(layerSize, layerSize)) atlas.levels++;
+    // The rectangles (with their padding) start and end on multiples of this, so they fall on whole pixels in every level
+    int alignment = 1 << (atlas.levels - 1);
+    auto align = [&](int size) { return (size + alignment - 1) / alignment * alignment; };
+
+    // From the tallest to the shortest, then the widest to the narrowest
+    std::vector<size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        if(images[a].height != images[b].height) return images[a].height > images[b].height;
+        return images[a].width > images[b].width;
+    });
+
+    std::vector<SkylinePacker> packers;
+    std::vector<Image> layerImages;
+    atlas.regions.resize(images.size());
+    for(size_t index : order){
+        const Image& image = images[index];
+        int allocatedWidth = align(image.width + 2 * padding), allocatedHeight = align(image.height + 2 * padding);
+        if(allocatedWidth > layerSize || allocatedHeight > layerSize) return false;
+
+        // The first layer with room for it, or a new layer
+        int x = 0, y = 0;
+        size_t layer = 0;
+        while(layer < packers.size() && !packers[layer].pack(allocatedWidth, allocatedHeight, x, y)) layer++;
+        if(layer == packers.size()){
+            packers.emplace_back();
+            packers.back().reset(layerSize, layerSize);
+            packers.back().pack(allocatedWidth, allocatedHeight, x, y);
+            Image layerImage;
+            layerImage.width = layerImage.height = layerSize;
+            layerImage.pixels.resize((size_t)layerSize * layerSize * 4);
+            layerImages.push_back(std::move(layerImage));
+        }
+
+        // Copies the image and its padding: the pixels outside the image repeat the nearest edge pixel
+        Image& destination = layerImages[layer];
+        for(int row = 0; row < allocatedHeight; row++){
+            int sourceRow = std::min(std::max(row - padding, 0), image.height - 1);
+            for(int column = 0; column < allocatedWidth; column++){
+                int sourceColumn = std::min(std::max(column - padding, 0), image.width - 1);
+                const uint8_t* source = &image.pixels[((size_t)sourceRow * image.width + sourceColumn) * 4];
+                uint8_t* pixel = &destination.pixels[((size_t)(y + row) * layerSize + x + column) * 4];
+                std::copy(source, source + 4, pixel);
+            }
+        }
+
+        AtlasRegion& region = atlas.regions[index];
+        region.layer = (int)layer;
+        region.x = x + padding;
+        region.y = y + padding;
+        region.width = image.width;
+        region.height = image.height;
+        region.uvRect[0] = (float)region.x / layerSize;
+        region.uvRect[1] = (float)region.y / layerSize;
+        region.uvRect[2] = (float)region.width / layerSize;
+        region.uvRect[3] = (float)region.height / layerSize;
+    }
+
+    for(Image& layerImage : layerImages){
+        std::vector<Image> mips = generateMipChain(layerImage);
+        mips.resize(atlas.levels);
+        atlas.layers.push_back(std::move(mips));
+    }
+    for(const SkylinePacker& packer : packers) atlas.occupancy += packer.getOccupancy() / packers.size();
+    return true;
+}
+
+GLuint createTextureArray(RenderState& state, const TextureAtlas& atlas) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    state.bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    GLsizei layerCount = (GLsizei)atlas.layers.size();
+    if(GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage){
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, atlas.levels, GL_RGBA8, atlas.width, atlas.height, layerCount);
+    } else {
+        for(int level = 0; level < atlas.levels; level++){
+            const Image& mip = atlas.layers[0][level];
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, mip.width, mip.height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, atlas.levels - 1);
+    }
+    // The layers are sent once, before the first frame, so they are sent directly instead of through the pixel buffers
+    // The 3rd coordinate of glTexSubImage3D is the layer, and the depth is the number of layers
+    for(GLsizei layer = 0; layer < layerCount; layer++){
+        for(int level = 0; level < atlas.levels; level++){
+            const Image& mip = atlas.layers[layer][level];
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels.data());
+        }
+    }
+    // The texture coordinates stay inside the rectangles, so they are clamped instead of repeated
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <glad/gl.h>
+#include "texture.hpp"
+#include "render_state.hpp"
+
+// Texture Atlases and Texture Arrays
+// ----------------
+// With 1 texture per object, every draw needs its own glBindTexture, and objects with different textures can't be drawn
+// by 1 instanced call. Instead, many small images are packed into a few big ones (an atlas), and every object only remembers
+// where its image is: the layer, and the rectangle of the layer (an offset and a scale applied to its texture coordinates).
+// The layers are the layers of 1 GL_TEXTURE_2D_ARRAY: an array of images of the same size and format that the shader
+// reads with texture(sampler2DArray, vec3(uv, layer)), so all the objects are drawn with 1 bound texture.
+//
+// 1. Packing: the images are placed in a layer with a skyline packer. The skyline is the top edge of the images already placed,
+//    stored as horizontal segments, and a new image goes where its bottom would be lowest (then leftmost) on the skyline.
+//    The images are packed from the tallest to the shortest, which leaves less empty space under the skyline.
+//    When an image doesn't fit in any layer, a new layer is started.
+//
+// 2. Padding: the filtering reads the pixels around the coordinate, so next to the edge of its rectangle, an object would read
+//    the pixels of its neighbor (bleeding). Every image is surrounded by "padding" pixels repeating its edge pixels.
+//    Each mip level halves the padding, so only the levels that still have 1 pixel of padding are made:
+//    with 4 pixels, the levels 0, 1 and 2. The rectangles start at multiples of 4 pixels, so they stay on whole pixels in these levels.
+
+// The attribute locations of the rectangle and the layer of every instance in instanced_atlas.vert
+// 2 to 5 are used by the model matrix, 6 and 7 by the normals and texture coordinates (see source/vertex_format.hpp)
+const GLuint ATLAS_RECT_LOCATION = 8;
+const GLuint ATLAS_LAYER_LOCATION = 9;
+
+// Where an image was placed in the atlas
+struct AtlasRegion {
+    int layer;
+    int x, y, width, height;  // In pixels of level 0, without the padding
+    // The texture coordinates of the image are uv * (uvRect[2], uvRect[3]) + (uvRect[0], uvRect[1])
+    float uvRect[4];
+};
+
+// Places rectangles in a layer from the bottom up (see the explanation above)
+class SkylinePacker {
+public:
+    // Starts an empty layer of width x height pixels
+    void reset(int width, int height);
+
+    // Finds the place of a rectangle, returns false if it doesn't fit anywhere
+    bool pack(int width, int height, int& x, int& y);
+
+    // The part of the layer covered by the packed rectangles (from 0 to 1)
+    float getOccupancy() const { return (float)usedArea / ((float)width * height); }
+
+private:
+    // A horizontal part of the skyline, from x to x + width at the height y
+    struct Segment {
+        int x, y, width;
+    };
+
+    std::vector<Segment> skyline;
+    int width = 0, height = 0;
+    size_t usedArea = 0;
+};
+
+struct TextureAtlas {
+    int width = 0, height = 0;        // The size of every layer
+    int levels = 0;
+    // The mip levels of every layer
+    std::vector<std::vector<Image>> layers;
+    // 1 region for every packed image, in the order of the images
+    std::vector<AtlasRegion> regions;
+    float occupancy = 0;              // The average occupancy of the layers
+};
+
+// Packs RGBA8 images into layers of layerSize x layerSize pixels with "padding" pixels around every image (a power of 2)
+// Returns false if an image with its padding is bigger than a layer
+bool buildTextureAtlas(const std::vector<Image>& images, int layerSize, int padding, TextureAtlas& atlas);
+
+// Creates a GL_TEXTURE_2D_ARRAY with 1 layer per layer of the atlas, and sends all their levels
+// The storage is immutable with OpenGL 4.2 or GL_ARB_texture_storage (glTexStorage3D), otherwise allocated level by level
+GLuint createTextureArray(RenderState& state, const TextureAtlas& atlas);
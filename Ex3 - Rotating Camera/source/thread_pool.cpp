@@ -0,0 +1,91 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if(threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // The calling thread works too, so we only need threadCount - 1 workers
+    for(unsigned i = 1; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for(std::thread& worker : workers) worker.join();
+}
+
+size_t ThreadPool::getChunkCount(size_t items, size_t minChunkSize) const {
+    if(items == 0) return 0;
+    minChunkSize = std::max<size_t>(minChunkSize, 1);
+    // A few chunks per thread, so a thread that finishes early can take more work
+    // Rounded down, so every chunk gets at least "minChunkSize" items (or all of them if there are fewer)
+    size_t maxChunks = (size_t)getThreadCount() * 4;
+    return std::max<size_t>(1, std::min(items / minChunkSize, maxChunks));
+}
+
+// The items are shared as evenly as possible: the chunks differ by 1 item at most, and none is empty
+size_t ThreadPool::getChunkBegin(size_t chunk, size_t items, size_t chunks) {
+    return chunk * items / chunks;
+}
+
+void ThreadPool::parallelFor(size_t items, size_t minChunkSize, const ChunkFunction& chunkFunction) {
+    size_t chunks = getChunkCount(items, minChunkSize);
+    if(chunks == 0) return;
+
+    // Not worth waking up the workers for a single chunk
+    if(chunks == 1 || workers.empty()){
+        for(size_t chunk = 0; chunk < chunks; chunk++)
+            chunkFunction(getChunkBegin(chunk, items, chunks), getChunkBegin(chunk + 1, items, chunks), chunk);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        function = &chunkFunction;
+        count = items;
+        chunkCount = chunks;
+        nextChunk = 0;
+        busyWorkers = workers.size();
+        jobIndex++;
+    }
+    workAvailable.notify_all();
+
+    runChunks();
+
+    // Wait for the workers to finish their last chunks
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]{ return busyWorkers == 0; });
+    function = nullptr;
+}
+
+void ThreadPool::runChunks() {
+    while(true){
+        size_t chunk = nextChunk.fetch_add(1);
+        if(chunk >= chunkCount) break;
+        (*function)(getChunkBegin(chunk, count, chunkCount), getChunkBegin(chunk + 1, count, chunkCount), chunk);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t lastJob = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&]{ return stopping || jobIndex != lastJob; });
+            if(stopping) return;
+            lastJob = jobIndex;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        workDone.notify_one();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+// Thread Pool
+// ----------------
+// Creating threads is slow, so the worker threads are created once and wait until there is work to do.
+// parallelFor() splits a range of items into chunks and runs them on all the threads (including the calling thread),
+// then returns once all the chunks are done.
+//
+// The chunks are numbered, and chunk number i always covers the same items for the same count,
+// so each chunk can write its results into its own output (e.g. outputs[chunk]) and the outputs can be joined in order.
+class ThreadPool {
+public:
+    // The function called for every chunk: items from "begin" to "end" (excluded), and the chunk number
+    using ChunkFunction = std::function<void(size_t begin, size_t end, size_t chunk)>;
+
+    // "threadCount" includes the calling thread, 0 means 1 thread per CPU core
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadCount() const { return (unsigned)workers.size() + 1; }
+
+    // The number of chunks parallelFor() splits "count" items into
+    // Each chunk has at least "minChunkSize" items, except the single chunk of a count smaller than that
+    size_t getChunkCount(size_t count, size_t minChunkSize) const;
+
+    // Runs "function" on every chunk and waits until they are all done
+    void parallelFor(size_t count, size_t minChunkSize, const ChunkFunction& function);
+
+private:
+    // The first item of "chunk" when "items" items are split into "chunks" chunks (the end of the last chunk for chunk = chunks)
+    static size_t getChunkBegin(size_t chunk, size_t items, size_t chunks);
+
+    void workerLoop();
+    // Takes chunks of the current job and runs them until there are no more chunks
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable, workDone;
+    bool stopping = false;
+
+    // The current job
+    uint64_t jobIndex = 0;
+    const ChunkFunction* function = nullptr;
+    size_t count = 0, chunkCount = 0;
+    std::atomic<size_t> nextChunk{0};
+    size_t busyWorkers = 0;
+};
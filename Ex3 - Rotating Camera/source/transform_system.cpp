@@ -0,0 +1,75 @@
+#include "transform_system.hpp"
+#include "camera.hpp"
+#include "batch_math.hpp"
+
+#include <algorithm>
+
+int TransformSystem::add(const glm::mat4& local, int parent) {
+    locals.push_back(local);
+    worlds.push_back(local);
+    mvps.push_back(local);
+    parents.push_back(parent);
+    dirty.push_back(1);
+    anyDirty = true;
+    return (int)locals.size() - 1;
+}
+
+void TransformSystem::reserve(size_t count) {
+    locals.reserve(count);
+    worlds.reserve(count);
+    mvps.reserve(count);
+    parents.reserve(count);
+    dirty.reserve(count);
+}
+
+void TransformSystem::setLocal(int index, const glm::mat4& local) {
+    locals[index] = local;
+    dirty[index] = 1;
+    anyDirty = true;
+}
+
+void TransformSystem::update(Camera& camera) {
+    counters = Counters();
+    const glm::mat4& viewProjection = camera.getViewProjection();
+    bool cameraChanged = camera.getVersion() != cameraVersion;
+    cameraVersion = camera.getVersion();
+
+    // Nothing moved and the camera didn't change, so every matrix from the last frame is still correct
+    if(!anyDirty && !cameraChanged){
+        counters.worldReused = counters.mvpReused = locals.size();
+        return;
+    }
+
+    if(anyDirty){
+        for(size_t i = 0; i < locals.size(); i++){
+            int parent = parents[i];
+            // If the parent moved, the child moves with it
+            // The parent comes before the child, so its dirty flag is already up to date
+            if(parent >= 0 && dirty[parent]) dirty[i] = 1;
+
+            if(dirty[i]){
+                worlds[i] = parent >= 0 ? worlds[parent] * locals[i] : locals[i];
+                counters.worldRecomputed++;
+            }
+        }
+    }
+    counters.worldReused = locals.size() - counters.worldRecomputed;
+
+    if(cameraChanged){
+        // Every MVP must be recomputed, so they are all multiplied in 1 batch using SIMD (see source/batch_math.hpp)
+        multiplyMatrices(viewProjection, worlds.data(), mvps.data(), worlds.size());
+        counters.mvpRecomputed = worlds.size();
+    } else {
+        for(size_t i = 0; i < locals.size(); i++){
+            if(dirty[i]){
+                mvps[i] = viewProjection * worlds[i];
+                counters.mvpRecomputed++;
+            }
+        }
+    }
+    counters.mvpReused = locals.size() - counters.mvpRecomputed;
+
+    // The flags are cleared after the loop, since the children need to see the flags of their parents
+    std::fill(dirty.begin(), dirty.end(), 0);
+    anyDirty = false;
+}
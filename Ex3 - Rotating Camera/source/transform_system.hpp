@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class Camera;
+
+// Transform System
+// ----------------
+// Keeps the matrices of all the objects in flat arrays (one array per matrix type, indexed by the object number):
+//  - local: the transformation relative to the parent (or to the world if the object has no parent)
+//  - world: parent's world * local, changes from the local space of the object to the world space
+//  - MVP: View-Projection * world, sent to the shader
+// Most objects don't move every frame, so instead of recomputing all the matrices every frame,
+// changing the local matrix of an object marks it as dirty, and update() only recomputes the dirty objects (and their children).
+// The MVPs are recomputed for the objects that moved, or for all the objects if the camera changed.
+//
+// To update everything in a single pass, a parent must always be added before its children.
+class TransformSystem {
+public:
+    // How many matrices were recomputed and how many were reused from the last frame during the last update()
+    struct Counters {
+        size_t worldRecomputed = 0, worldReused = 0;
+        size_t mvpRecomputed = 0, mvpReused = 0;
+    };
+
+    // Adds an object and returns its index, "parent" is the index of its parent or -1 if it has no parent
+    int add(const glm::mat4& local, int parent = -1);
+
+    void reserve(size_t count);
+    size_t size() const { return locals.size(); }
+
+    // Changes the local matrix of an object, it is recomputed in the next update()
+    void setLocal(int index, const glm::mat4& local);
+    const glm::mat4& getLocal(int index) const { return locals[index]; }
+
+    const glm::mat4& getWorld(int index) const { return worlds[index]; }
+    const glm::mat4& getMVP(int index) const { return mvps[index]; }
+
+    // The world matrices of all the objects, next to each other in memory (e.g. to send them all to a buffer)
+    const glm::mat4* getWorldData() const { return worlds.data(); }
+    const glm::mat4* getMVPData() const { return mvps.data(); }
+
+    // Recomputes the dirty world matrices and the MVPs that depend on them or on the camera
+    void update(Camera& camera);
+
+    const Counters& getCounters() const { return counters; }
+
+private:
+    std::vector<glm::mat4> locals, worlds, mvps;
+    std::vector<int> parents;
+    std::vector<uint8_t> dirty;
+    uint64_t cameraVersion = 0;
+    bool anyDirty = false;
+    Counters counters;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/gl.h>
+
+// Uniform Buffer Objects
+// ----------------
+// A uniform set with glUniform* belongs to 1 program, so the values shared by all the programs (the camera, the time)
+// must be sent again to every program, and every draw call needs its own glUniform* calls.
+// Instead, the uniforms can be grouped in blocks, and the blocks are read from a buffer (a uniform buffer object):
+//
+//      layout(std140) uniform Frame {       // Shared by all the draws of a frame
+//          mat4 view;
+//          mat4 projection;
+//          mat4 viewProjection;
+//          float time;
+//      };
+//      layout(std140) uniform Object {      // Different for every draw
+//          mat4 MVP;
+//          vec4 atlasRect;                  // Where the image of the object is in the texture atlas (see source/texture_atlas.hpp)
+//          float atlasLayer;
+//      };
+//
+// Every frame, all the blocks are written one after the other into 1 big array on the CPU, then sent with a single upload.
+// Before a draw, glBindBufferRange points a binding point at the part of the buffer that holds the block for this draw,
+// so the Frame block is bound once per frame for all the programs, and only the Object block changes between draws.
+// The start of every block must be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT (often 256 bytes, 16 on Mesa).
+//
+// std140 is a layout with fixed rules, so the C++ structs below match the blocks without asking the driver for the offsets:
+// a mat4 is 16 floats, and the size of a block is rounded up to a multiple of 16 bytes.
+// A shader can declare fewer members than the struct (simple.vert only reads the MVP), the members it declares must come first.
+
+// The binding points of the blocks, every program's blocks are attached to them by bindUniformBlocks()
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+const GLuint OBJECT_UNIFORMS_BINDING = 1;
+
+struct FrameUniforms {
+    float view[16];
+    float projection[16];
+    float viewProjection[16];
+    float time;
+    float padding[3];
+};
+
+struct ObjectUniforms {
+    float MVP[16];
+    float atlasRect[4];
+    float atlasLayer;
+    float padding[3];
+};
+
+// Sets the 16 floats of a matrix to the identity
+void setIdentityMatrix(float* matrix);
+
+// Attaches the blocks named "Frame" and "Object" of the program (if it has them) to their binding points
+// GLSL 330 can't choose the binding point in the shader (layout(binding = 0) needs GLSL 420), so it is done after linking
+void bindUniformBlocks(GLuint program);
+
+class UniformBuffer {
+public:
+    // "capacity" is the most bytes expected in 1 frame, including the alignment (see getAlignedSize)
+    // If a frame writes more, the buffer grows (and prints a warning), so the capacity should be enough from the start
+    void create(size_t capacity);
+
+    // The space that a block of "size" bytes takes in the buffer, rounded up to the offset alignment
+    // Can be called before create(), the alignment is asked to the driver only the first time
+    size_t getAlignedSize(size_t size) const;
+
+    // Starts writing the blocks of a new frame from the start of the buffer
+    void beginFrame() { used = 0; }
+
+    // Copies a block and returns its offset in the buffer, the block is sent to the GPU by upload()
+    // Every block is written before upload() in a frame, since the buffer may grow here
+    size_t write(const void* block, size_t size);
+
+    // Sends all the blocks written since beginFrame() in 1 call
+    // The buffer gets new memory first (glBufferData with no data), so the GPU can still read the blocks of the last frame
+    // Leaves the buffer bound to GL_UNIFORM_BUFFER
+    void upload();
+
+    // Points a binding point at a block written in this frame
+    void bindRange(GLuint binding, size_t offset, size_t size) const;
+
+    GLuint getBuffer() const { return buffer; }
+    size_t getCapacity() const { return data.size(); }
+    // The bytes written in this frame
+    size_t getUsedSize() const { return used; }
+
+    void destroy();
+
+private:
+    GLuint buffer = 0;
+    std::vector<uint8_t> data;
+    size_t used = 0;
+    mutable size_t alignment = 0;
+};
@@ -0,0 +1,225 @@
+#include "vertex_format.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/packing.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+namespace {
+    size_t alignTo4(size_t offset) { return (offset + 3) / 4 * 4; }
+
+    // Returns -1 or 1, unlike glm::sign which returns 0 for 0
+    glm::vec2 signNotZero(glm::vec2 v) { return glm::vec2(v.x >= 0 ? 1.0f : -1.0f, v.y >= 0 ? 1.0f : -1.0f); }
+
+    const VertexAttribute* findAttribute(const VertexLayout& layout, GLuint location) {
+        for(const VertexAttribute& attribute : layout.attributes) if(attribute.location == location) return &attribute;
+        return nullptr;
+    }
+
+    template<typename T>
+    void write(uint8_t* destination, const T& value) { std::memcpy(destination, &value, sizeof(T)); }
+
+    template<typename T>
+    T read(const uint8_t* source) {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        return value;
+    }
+}
+
+VertexLayout getVertexLayout(const VertexFormat& format) {
+    VertexLayout layout;
+    size_t offset = 0;
+    auto add = [&](GLuint location, GLint components, GLenum type, GLboolean normalized, size_t size) {
+        layout.attributes.push_back({location, components, type, normalized, offset});
+        offset = alignTo4(offset + size);
+    };
+
+    // The 3 components of the 16-bit positions take 6 bytes, the 2 bytes after them are padding
+    switch(format.position){
+        case PositionFormat::Float32: add(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, 12); break;
+        case PositionFormat::Half: add(POSITION_LOCATION, 3, GL_HALF_FLOAT, GL_FALSE, 6); break;
+        case PositionFormat::Snorm16: add(POSITION_LOCATION, 3, GL_SHORT, GL_TRUE, 6); break;
+    }
+    add(COLOR_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4);
+    switch(format.normal){
+        case NormalFormat::None: break;
+        case NormalFormat::Float32: add(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, 12); break;
+        case NormalFormat::Octahedral: add(NORMAL_LOCATION, 2, GL_SHORT, GL_TRUE, 4); break;
+        case NormalFormat::Int2_10_10_10: add(NORMAL_LOCATION, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4); break;
+    }
+    switch(format.uv){
+        case UVFormat::None: break;
+        case UVFormat::Float32: add(UV_LOCATION, 2, GL_FLOAT, GL_FALSE, 8); break;
+        case UVFormat::Half: add(UV_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE, 4); break;
+    }
+    layout.stride = offset;
+    return layout;
+}
+
+void setupVertexAttributes(const VertexLayout& layout, size_t baseOffset) {
+    for(const VertexAttribute& attribute : layout.attributes){
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized,
+                              (GLsizei)layout.stride, (void*)(baseOffset + attribute.offset));
+    }
+}
+
+bool parsePositionFormat(const std::string& name, PositionFormat& format) {
+    if(name == "float") format = PositionFormat::Float32;
+    else if(name == "half") format = PositionFormat::Half;
+    else if(name == "snorm16") format = PositionFormat::Snorm16;
+    else return false;
+    return true;
+}
+
+const char* getPositionFormatName(PositionFormat format) {
+    switch(format){
+        case PositionFormat::Half: return "half";
+        case PositionFormat::Snorm16: return "snorm16";
+        default: return "float";
+    }
+}
+
+const char* getNormalFormatName(NormalFormat format) {
+    switch(format){
+        case NormalFormat::Float32: return "float";
+        case NormalFormat::Octahedral: return "octahedral";
+        case NormalFormat::Int2_10_10_10: return "2_10_10_10";
+        default: return "none";
+    }
+}
+
+const char* getUVFormatName(UVFormat format) {
+    switch(format){
+        case UVFormat::Float32: return "float";
+        case UVFormat::Half: return "half";
+        default: return "none";
+    }
+}
+
+glm::vec2 encodeOctahedral(glm::vec3 normal) {
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half (z < 0) over the upper half
+    normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 encoded(normal.x, normal.y);
+    if(normal.z < 0) encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signNotZero(encoded);
+    return encoded;
+}
+
+glm::vec3 decodeOctahedral(glm::vec2 encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    if(normal.z < 0){
+        glm::vec2 unfolded = (1.0f - glm::abs(glm::vec2(normal.y, normal.x))) * signNotZero(glm::vec2(normal.x, normal.y));
+        normal.x = unfolded.x;
+        normal.y = unfolded.y;
+    }
+    return glm::normalize(normal);
+}
+
+EncodedVertices encodeVertices(const VertexFormat& format, const Vertex* vertices, size_t count,
+                               const glm::vec3* normals, const glm::vec2* uvs) {
+    EncodedVertices encoded;
+    encoded.format = format;
+    encoded.layout = getVertexLayout(format);
+    encoded.count = count;
+    encoded.data.assign(count * encoded.layout.stride, 0);
+
+    // snorm16 positions store (position - center) / halfSize, which is in [-1, 1] inside the bounding box
+    glm::vec3 center(0), halfSize(1);
+    if(format.position == PositionFormat::Snorm16 && count > 0){
+        glm::vec3 low, high;
+        computeMeshBounds(vertices, count, low, high);
+        center = (low + high) * 0.5f;
+        // A flat mesh (like the square) has a size of 0 along 1 axis
+        halfSize = glm::max((high - low) * 0.5f, glm::vec3(1e-6f));
+        encoded.dequantization = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), halfSize);
+    }
+
+    const VertexLayout& layout = encoded.layout;
+    const VertexAttribute* colorAttribute = findAttribute(layout, COLOR_LOCATION);
+    const VertexAttribute* normalAttribute = findAttribute(layout, NORMAL_LOCATION);
+    const VertexAttribute* uvAttribute = findAttribute(layout, UV_LOCATION);
+    for(size_t i = 0; i < count; i++){
+        uint8_t* out = encoded.data.data() + i * layout.stride;
+        const Vertex& vertex = vertices[i];
+        glm::vec3 position(vertex.x, vertex.y, vertex.z);
+
+        switch(format.position){
+            case PositionFormat::Float32:
+                write(out, position);
+                break;
+            case PositionFormat::Half:
+                for(int c = 0; c < 3; c++) write(out + 2*c, glm::packHalf1x16(position[c]));
+                break;
+            case PositionFormat::Snorm16: {
+                glm::vec3 normalized = (position - center) / halfSize;
+                for(int c = 0; c < 3; c++) write(out + 2*c, glm::packSnorm1x16(normalized[c]));
+                break;
+            }
+        }
+
+        uint8_t color[4] = {vertex.r, vertex.g, vertex.b, vertex.a};
+        std::memcpy(out + colorAttribute->offset, color, 4);
+
+        if(normalAttribute){
+            glm::vec3 normal = normals[i];
+            float length = glm::length(normal);
+            normal = length > 0 ? normal / length : glm::vec3(0, 0, 1);
+            uint8_t* destination = out + normalAttribute->offset;
+            switch(format.normal){
+                case NormalFormat::Float32: write(destination, normal); break;
+                case NormalFormat::Octahedral: {
+                    glm::vec2 octahedral = encodeOctahedral(normal);
+                    write(destination, glm::packSnorm1x16(octahedral.x));
+                    write(destination + 2, glm::packSnorm1x16(octahedral.y));
+                    break;
+                }
+                // glm packs x in the lowest 10 bits like GL_INT_2_10_10_10_REV
+                case NormalFormat::Int2_10_10_10: write(destination, glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f))); break;
+                default: break;
+            }
+        }
+
+        if(uvAttribute){
+            uint8_t* destination = out + uvAttribute->offset;
+            if(format.uv == UVFormat::Float32) write(destination, uvs[i]);
+            else write(destination, glm::packHalf2x16(uvs[i]));
+        }
+    }
+    return encoded;
+}
+
+DecodedVertex decodeVertex(const EncodedVertices& vertices, size_t index) {
+    const VertexLayout& layout = vertices.layout;
+    const uint8_t* in = vertices.data.data() + index * layout.stride;
+    DecodedVertex decoded = {glm::vec3(0), glm::vec3(0), glm::vec2(0)};
+
+    switch(vertices.format.position){
+        case PositionFormat::Float32: decoded.position = read<glm::vec3>(in); break;
+        case PositionFormat::Half:
+            for(int c = 0; c < 3; c++) decoded.position[c] = glm::unpackHalf1x16(read<uint16_t>(in + 2*c));
+            break;
+        case PositionFormat::Snorm16:
+            for(int c = 0; c < 3; c++) decoded.position[c] = glm::unpackSnorm1x16(read<uint16_t>(in + 2*c));
+            decoded.position = glm::vec3(vertices.dequantization * glm::vec4(decoded.position, 1.0f));
+            break;
+    }
+
+    if(const VertexAttribute* attribute = findAttribute(layout, NORMAL_LOCATION)){
+        const uint8_t* source = in + attribute->offset;
+        switch(vertices.format.normal){
+            case NormalFormat::Float32: decoded.normal = read<glm::vec3>(source); break;
+            case NormalFormat::Octahedral:
+                decoded.normal = decodeOctahedral(glm::vec2(glm::unpackSnorm1x16(read<uint16_t>(source)), glm::unpackSnorm1x16(read<uint16_t>(source + 2))));
+                break;
+            case NormalFormat::Int2_10_10_10: decoded.normal = glm::vec3(glm::unpackSnorm3x10_1x2(read<uint32_t>(source))); break;
+            default: break;
+        }
+    }
+
+    if(const VertexAttribute* attribute = findAttribute(layout, UV_LOCATION)){
+        const uint8_t* source = in + attribute->offset;
+        decoded.uv = vertices.format.uv == UVFormat::Float32 ? read<glm::vec2>(source) : glm::unpackHalf2x16(read<uint32_t>(source));
+    }
+    return decoded;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include "mesh.hpp"
+
+// Compressed Vertex Formats
+// ----------------
+// With big meshes, the GPU spends a lot of its time reading vertices from memory, so smaller vertices draw faster.
+// Most attributes don't need 32-bit floats:
+// - Positions as 16-bit integers (snorm16): the mesh's bounding box is divided into 65536 steps along each axis.
+//   The GPU converts them to floats in [-1, 1] (normalized attribute), and a dequantization matrix (scale and translation
+//   back to the bounding box) is multiplied into the model matrix, so the shaders don't change.
+// - Positions as 16-bit floats (half): no matrix needed, but less precise far from the origin.
+// - Normals as 2 16-bit integers (octahedral encoding): the sphere of directions is unfolded onto a square,
+//   the shader decodes them with:
+//       vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+//       if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+//       n = normalize(n);
+// - Normals as GL_INT_2_10_10_10_REV: x, y and z in 10 bits each and w in 2 bits, all in 1 32-bit integer,
+//   the GPU unpacks them itself.
+// - Texture coordinates as 16-bit floats (half).
+// Colors are always 4 normalized bytes, like in Vertex.
+//
+// A VertexLayout describes where every attribute is in the vertex and its type,
+// and setupVertexAttributes() calls glVertexAttribPointer for all of them, so changing the format needs no other code.
+
+enum class PositionFormat { Float32, Half, Snorm16 };
+enum class NormalFormat { None, Float32, Octahedral, Int2_10_10_10 };
+enum class UVFormat { None, Float32, Half };
+
+struct VertexFormat {
+    PositionFormat position = PositionFormat::Float32;
+    NormalFormat normal = NormalFormat::None;
+    UVFormat uv = UVFormat::None;
+};
+
+// The attribute locations, 2 to 5 are used by the model matrix of instanced rendering, 8 and 9 by the atlas (see source/texture_atlas.hpp)
+const GLuint POSITION_LOCATION = 0;
+const GLuint COLOR_LOCATION = 1;
+const GLuint NORMAL_LOCATION = 6;
+const GLuint UV_LOCATION = 7;
+
+struct VertexAttribute {
+    GLuint location;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    size_t offset;
+};
+
+struct VertexLayout {
+    std::vector<VertexAttribute> attributes;
+    size_t stride = 0;
+};
+
+// Every attribute starts at a multiple of 4 bytes, as GPUs prefer
+VertexLayout getVertexLayout(const VertexFormat& format);
+
+// Enables and sets up all the attributes of the layout for the buffer bound to GL_ARRAY_BUFFER
+// "baseOffset" is the offset of the first vertex in the buffer
+void setupVertexAttributes(const VertexLayout& layout, size_t baseOffset = 0);
+
+// Parses "float", "half" or "snorm16", returns false if the name is unknown
+bool parsePositionFormat(const std::string& name, PositionFormat& format);
+const char* getPositionFormatName(PositionFormat format);
+const char* getNormalFormatName(NormalFormat format);
+const char* getUVFormatName(UVFormat format);
+
+struct EncodedVertices {
+    VertexFormat format;
+    VertexLayout layout;
+    std::vector<uint8_t> data;
+    size_t count = 0;
+    // Changes the decoded positions back to the positions of the mesh (the identity unless the positions are snorm16)
+    glm::mat4 dequantization = glm::mat4(1.0f);
+};
+
+// Encodes the positions and colors of the vertices, and the normals and texture coordinates if the format has them
+// "normals" and "uvs" must have "count" elements if the format uses them
+EncodedVertices encodeVertices(const VertexFormat& format, const Vertex* vertices, size_t count,
+                               const glm::vec3* normals = nullptr, const glm::vec2* uvs = nullptr);
+
+// Decodes 1 vertex on the CPU, like the GPU would (used to check the precision of the formats)
+struct DecodedVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+DecodedVertex decodeVertex(const EncodedVertices& vertices, size_t index);
+
+glm::vec2 encodeOctahedral(glm::vec3 normal);
+glm::vec3 decodeOctahedral(glm::vec2 encoded);
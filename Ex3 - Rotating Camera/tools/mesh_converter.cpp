@@ -0,0 +1,37 @@
+// Converts an OBJ or PLY file into a .mesh file (see source/mesh_file.hpp), which loads much faster
+// The mesh is also optimized for the GPU caches (see source/mesh_optimizer.hpp), since it only has to be done once
+// Usage: MeshConverter input.obj output.mesh
+
+#include <iostream>
+#include <string>
+#include "../source/mesh_importer.hpp"
+#include "../source/mesh_file.hpp"
+#include "../source/mesh_optimizer.hpp"
+
+int main(int argc, char** argv) {
+    if(argc != 3){
+        std::cerr << "Usage: " << argv[0] << " input.obj|input.ply output.mesh" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1], output = argv[2];
+
+    ThreadPool threadPool;
+    Mesh mesh;
+    MeshImportStats stats;
+    if(!importMesh(input, mesh, &threadPool, &stats)) return 1;
+    std::cout << "Imported " << input << " in " << stats.totalTime << " ms: " << mesh.getTriangleCount() << " triangles, "
+              << stats.cornerCount << " corners welded into " << mesh.vertices.size() << " vertices, "
+              << getIndexTypeBits(mesh.indexType) << "-bit indices" << std::endl;
+
+    MeshOptimizationReport report;
+    optimizeMesh(mesh, &report);
+    printMeshOptimizationReport(report);
+
+    if(!saveMeshFile(output, mesh)) return 1;
+
+    // Open the new file to make sure it is valid
+    MeshFile file;
+    if(!file.open(output)) return 1;
+    std::cout << "Saved " << output << " (" << file.getFileSize() / 1024.0 << " KB)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Compresses an image into a .ktx file (see source/ktx_file.hpp) with all its mip levels, ready to be sent to the GPU without decoding
+// The levels are filtered in linear colors (see source/mip_generator.hpp) and encoded in BC1 or BC3 (see source/block_compression.hpp)
+// It prints the encoding speed, the quality of every level and the video memory saved compared to RGBA8
+// Usage: TextureCompressor input.ppm|checkerboard:SIZE output.ktx [--format bc1|bc3] [--filter box|kaiser]
+// Build it in Release mode, the encoder is much slower without optimizations
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "../source/mip_generator.hpp"
+#include "../source/block_compression.hpp"
+#include "../source/ktx_file.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Reads a binary PPM (P6) file with 8 bits per channel, the simplest image format to write from any image editor
+// The rows of a PPM file go from top to bottom, they are flipped to go from bottom to top like OpenGL
+bool readPpm(const std::string& path, Image& image) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    file >> magic >> image.width >> image.height >> maxValue;
+    if(!file || magic != "P6" || image.width <= 0 || image.height <= 0 || maxValue != 255){
+        std::cerr << "Failed to read " << path << ": only binary PPM files (P6) with 8 bits per channel are supported" << std::endl;
+        return false;
+    }
+    // A single whitespace separates the header from the pixels
+    file.get();
+    std::vector<uint8_t> rgb((size_t)image.width * image.height * 3);
+    file.read((char*)rgb.data(), rgb.size());
+    if(!file){
+        std::cerr << "Failed to read " << path << ": truncated" << std::endl;
+        return false;
+    }
+    image.format = GL_RGBA8;
+    image.pixels.resize((size_t)image.width * image.height * 4);
+    for(int y = 0; y < image.height; y++){
+        for(int x = 0; x < image.width; x++){
+            const uint8_t* source = &rgb[((size_t)(image.height - 1 - y) * image.width + x) * 3];
+            uint8_t* destination = &image.pixels[((size_t)y * image.width + x) * 4];
+            destination[0] = source[0];
+            destination[1] = source[1];
+            destination[2] = source[2];
+            destination[3] = 255;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+#ifndef NDEBUG
+    std::cout << "Warning: the tool is built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    if(argc < 3){
+        std::cerr << "Usage: " << argv[0] << " input.ppm|checkerboard:SIZE output.ktx [--format bc1|bc3] [--filter box|kaiser]" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1], output = argv[2];
+    GLenum format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    MipFilter filter = MipFilter::Kaiser;
+    for(int i = 3; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--format" && i + 1 < argc && parseCompressedFormat(argv[i + 1], format)) i++;
+        else if(arg == "--filter" && i + 1 < argc && parseMipFilter(argv[i + 1], filter)) i++;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    Image image;
+    if(input.rfind("checkerboard:", 0) == 0){
+        int size = std::atoi(input.c_str() + 13);
+        if(size <= 0){
+            std::cerr << "Invalid checkerboard size " << input << std::endl;
+            return 1;
+        }
+        image = createCheckerboardImage(size, 8);
+    } else if(!readPpm(input, image)) return 1;
+
+    ThreadPool threadPool;
+
+    Clock::time_point start = Clock::now();
+    std::vector<Image> mips = generateGammaCorrectMipChain(image, filter, &threadPool);
+    double mipTime = millisecondsSince(start);
+    size_t pixelCount = 0;
+    for(const Image& mip : mips) pixelCount += (size_t)mip.width * mip.height;
+    std::cout << "Generated " << mips.size() << " levels of " << image.width << "x" << image.height << " with the "
+              << getMipFilterName(filter) << " filter in " << mipTime << " ms" << std::endl;
+
+    // The levels are encoded one after the other, and the block rows of every level are split between the threads
+    start = Clock::now();
+    std::vector<Image> compressed;
+    for(const Image& mip : mips) compressed.push_back(compressImage(mip, format, &threadPool));
+    double encodeTime = millisecondsSince(start);
+    std::cout << "Encoded in " << getCompressedFormatName(format) << " in " << encodeTime << " ms ("
+              << pixelCount / 1e6 / (encodeTime / 1000.0) << " MP/s on " << threadPool.getThreadCount() << " threads)" << std::endl;
+
+    // The quality of the biggest levels, the small ones only have a few blocks
+    for(size_t level = 0; level < mips.size() && level < 4; level++)
+        std::cout << "  Level " << level << ": PSNR " << computePsnr(mips[level], decompressImage(compressed[level])) << " dB" << std::endl;
+
+    size_t uncompressedSize = 0, compressedSize = 0;
+    for(size_t level = 0; level < mips.size(); level++){
+        uncompressedSize += mips[level].getSize();
+        compressedSize += compressed[level].getSize();
+    }
+    std::cout << "Video memory: " << uncompressedSize / 1024.0 << " KB in RGBA8, " << compressedSize / 1024.0 << " KB in "
+              << getCompressedFormatName(format) << " (" << 100.0 * (1.0 - (double)compressedSize / uncompressedSize) << "% saved)" << std::endl;
+
+    if(!saveKtxFile(output, compressed)) return 1;
+
+    // Open the new file to make sure it is valid
+    std::vector<Image> loaded;
+    if(!loadKtxFile(output, loaded)) return 1;
+    std::cout << "Saved " << output << " (" << loaded.size() << " levels)" << std::endl;
+    return 0;
+}